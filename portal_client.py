@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Walk through the captive portal the way a phone does, from a Linux machine
+joined to the Stepper AP, and report bytes served and time-to-portal.
+
+    python3 portal_client.py [portal_ip] [dns_port] [http_port]
+
+Checks the firmware's DNS responder (dns_server.c) and the portal's gzip and
+ETag handling (wifi_manager.c). Exits non-zero if any check fails.
+"""
+import gzip
+import http.client
+import random
+import socket
+import struct
+import sys
+import time
+
+# What Android resolves and fetches to decide whether a network is captive
+PROBE_HOST = "connectivitycheck.gstatic.com"
+PROBE_PATH = "/generate_204"
+
+DNS_TYPE_A = 1
+DNS_TYPE_AAAA = 28
+DNS_CLASS_IN = 1
+TIMEOUT_S = 3.0
+
+failures = 0
+
+
+def check(ok, what):
+    global failures
+    print(f"  {'ok  ' if ok else 'FAIL'} {what}")
+    if not ok:
+        failures += 1
+
+
+def dns_query(server, port, name, qtype):
+    """Send one query and return (rcode, [IPv4 answers], reply bytes, seconds)."""
+    qid = random.randrange(0x10000)
+    question = b"".join(bytes([len(p)]) + p.encode() for p in name.split(".")) + b"\0"
+    query = struct.pack(">HHHHHH", qid, 0x0100, 1, 0, 0, 0) + question + struct.pack(">HH", qtype, DNS_CLASS_IN)
+
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.settimeout(TIMEOUT_S)
+        start = time.monotonic()
+        s.sendto(query, (server, port))
+        reply, _ = s.recvfrom(512)
+        elapsed = time.monotonic() - start
+
+    rid, flags, _, ancount, _, _ = struct.unpack(">HHHHHH", reply[:12])
+    if rid != qid or not flags & 0x8000:
+        raise ValueError(f"reply id {rid:#x} flags {flags:#x} does not answer query {qid:#x}")
+    addresses = []
+    pos = 12 + len(question) + 4
+    for _ in range(ancount):
+        # Answers use a 2-byte name pointer, as the firmware writes them
+        rtype, _, _, rdlength = struct.unpack(">HHIH", reply[pos + 2:pos + 12])
+        if rtype == DNS_TYPE_A and rdlength == 4:
+            addresses.append(socket.inet_ntoa(reply[pos + 12:pos + 16]))
+        pos += 12 + rdlength
+    return flags & 0x000f, addresses, len(reply), elapsed
+
+
+def http_get(host, port, path, headers=None):
+    """GET a path; returns (status, headers, raw body). The body is not decoded."""
+    conn = http.client.HTTPConnection(host, port, timeout=TIMEOUT_S)
+    try:
+        conn.request("GET", path, headers=headers or {})
+        resp = conn.getresponse()
+        return resp.status, {k.lower(): v for k, v in resp.getheaders()}, resp.read()
+    finally:
+        conn.close()
+
+
+def run(portal_ip, dns_port, http_port):
+    print(f"DNS {portal_ip}:{dns_port}")
+    start = time.monotonic()
+    rcode, addresses, reply_len, elapsed = dns_query(portal_ip, dns_port, PROBE_HOST, DNS_TYPE_A)
+    check(rcode == 0 and addresses == [portal_ip],
+          f"A {PROBE_HOST} -> {addresses} in {elapsed * 1000:.1f} ms ({reply_len} bytes)")
+    rcode, addresses, _, _ = dns_query(portal_ip, dns_port, "example.org", DNS_TYPE_AAAA)
+    check(rcode == 0 and not addresses, "AAAA answered empty so clients fall back to IPv4")
+
+    print(f"HTTP {portal_ip}:{http_port}")
+    status, headers, _ = http_get(portal_ip, http_port, PROBE_PATH, {"Host": PROBE_HOST})
+    location = headers.get("location", "")
+    check(status == 302 and location, f"{PROBE_PATH} -> {status} {location}")
+    path = "/" + location.split("/", 3)[3] if location.count("/") >= 3 else "/"
+
+    status, headers, body = http_get(portal_ip, http_port, path, {"Accept-Encoding": "gzip"})
+    time_to_portal = time.monotonic() - start
+    etag = headers.get("etag")
+    check(status == 200 and headers.get("content-encoding") == "gzip" and etag,
+          f"{path} -> {status}, Content-Encoding {headers.get('content-encoding')}, ETag {etag}")
+    try:
+        page = gzip.decompress(body)
+        check(b"<html" in page.lower(), f"page {len(body)} bytes on the wire, {len(page)} uncompressed "
+              f"({100 * len(body) / len(page):.0f}%)")
+    except OSError as e:
+        check(False, f"page does not decompress: {e}")
+
+    status, headers, body = http_get(portal_ip, http_port, path,
+                                     {"Accept-Encoding": "gzip", "If-None-Match": etag or ""})
+    check(status == 304 and not body, f"revalidation -> {status}, {len(body)} body bytes")
+
+    print(f"Time to portal (first DNS query to page received): {time_to_portal * 1000:.0f} ms")
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    try:
+        run(args[0] if len(args) > 0 else "192.168.4.1",
+            int(args[1]) if len(args) > 1 else 53,
+            int(args[2]) if len(args) > 2 else 80)
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error: {e}")
+        failures += 1
+    sys.exit(1 if failures else 0)
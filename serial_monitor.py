@@ -1,18 +1,83 @@
 #!/usr/bin/env python3
+import os
+import re
+import sys
 import serial
 
+# Message table shared with the firmware's binary log (binlog.c)
+BINLOG_MSGS = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "step-counter", "main", "binlog_msgs.h")
+
+# One printf conversion: flags, width, precision, length modifier, specifier
+C_SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+def load_binlog_formats(path=BINLOG_MSGS):
+    """Return the format strings from binlog_msgs.h, indexed by message id."""
+    formats = []
+    try:
+        with open(path) as f:
+            for line in f:
+                m = re.match(r'\s*BINLOG_MSG\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', line)
+                if m:
+                    formats.append(m.group(1).encode().decode("unicode_escape"))
+    except OSError as e:
+        print(f"Binary log decoding disabled: {e}")
+    return formats
+
+
+def format_binlog(fmt, args):
+    """Apply a C format string to raw 32-bit argument words."""
+    args = list(args)
+
+    def convert(m):
+        flags, spec = m.group(1), m.group(2)
+        if spec == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        if spec in "di" and value & 0x80000000:
+            value -= 1 << 32
+        if spec == "u":
+            spec = "d"
+        if spec == "c":
+            value = chr(value & 0xff)
+        return ("%" + flags + spec) % value
+
+    return C_SPEC.sub(convert, fmt)
+
+
+def decode_binlog_line(line, formats):
+    """Turn a '#BL <ms> <id> <args...>' frame (all hex) into a log line, or None."""
+    if not line.startswith("#BL "):
+        return None
+    try:
+        fields = [int(x, 16) for x in line[4:].split()]
+    except ValueError:
+        return None
+    if len(fields) < 2:
+        return None
+    time_ms, msg_id, args = fields[0], fields[1], fields[2:]
+    if msg_id < len(formats):
+        text = format_binlog(formats[msg_id], args)
+    else:
+        text = f"unknown message {msg_id} {args}"
+    return f"B ({time_ms}) binlog: {text}"
+
+
 def monitor_serial(port, baudrate=115200):
+    formats = load_binlog_formats()
     try:
         with serial.Serial(port, baudrate, timeout=1) as ser:
             print(f"Monitoring serial port {port} at {baudrate} baud...")
             while True:
                 line = ser.readline().decode('utf-8', errors='ignore').strip()
                 if line:
-                    print(line)
+                    decoded = decode_binlog_line(line, formats)
+                    print(decoded if decoded is not None else line)
     except serial.SerialException as e:
         print(f"Error: {e}")
     except KeyboardInterrupt:
         print("\nExiting serial monitor.")
 
 if __name__ == "__main__":
-    monitor_serial("/dev/ttyACM0")
\ No newline at end of file
+    monitor_serial(sys.argv[1] if len(sys.argv) > 1 else "/dev/ttyACM0")
@@ -0,0 +1,47 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/*
+ * Minimal assertions for the host tests: a failed check is reported and
+ * counted, the test keeps going, and check_result() becomes the exit code.
+ */
+
+static int check_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                   \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                              \
+    do {                                                                        \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);         \
+        if (a_ != e_) {                                                         \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__,     \
+                    __LINE__, #actual, a_, e_);                                 \
+            check_failures++;                                                   \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_RANGE(actual, lo, hi)                                             \
+    do {                                                                        \
+        long long a_ = (long long)(actual);                                     \
+        if (a_ < (long long)(lo) || a_ > (long long)(hi)) {                     \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld..%lld\n", __FILE__, \
+                    __LINE__, #actual, a_, (long long)(lo), (long long)(hi));   \
+            check_failures++;                                                   \
+        }                                                                       \
+    } while (0)
+
+static inline int check_result(const char *name)
+{
+    printf("%s: %s\n", name, check_failures ? "FAILED" : "ok");
+    return check_failures ? 1 : 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Generate the synthetic discharge.log replayed by test_soc_model.
+
+    python3 gen_discharge.py > discharge.log
+
+A 1000 mAh cell is discharged in 10 s steps. The loads come from the energy
+ledger: a 20 mA base, +35 mA with the display on and +80 mA with WiFi up.
+The real current is off from the ledger's estimate by up to 10%. The cell
+follows its own OCV curve and internal resistance, not the ones
+soc_model.c assumes. Every 5 minutes a reading is logged in the main task's
+format, with ~6 mV of ADC noise.
+
+Each line carries two state-of-charge figures:
+  SoC  what the firmware's model prints. This is a port of soc_model.c that
+       reads the curve from the C source, so replaying it only detects a
+       change to the model.
+  ref  the cell's coulomb-counted state of charge: the independent reference
+       the model's estimate is checked against.
+
+A bench capture can replace the file. Without ref fields, only the change
+detection and the shape checks apply.
+"""
+import os
+import random
+import re
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOC_MODEL_C = os.path.join(HERE, "..", "..", "main", "soc_model.c")
+SOC_MODEL_H = os.path.join(HERE, "..", "..", "main", "soc_model.h")
+
+CAPACITY_MAH = 1000
+STEP_S = 10
+LOG_PERIOD_S = 300
+FIRST_LOG_S = 20
+
+BASE_UA, DISPLAY_UA, WIFI_UA = 20000, 35000, 80000
+LEDGER_ERROR = 0.10
+NOISE_MV = 6
+
+# The simulated cell: a typical NMC 18650 low-rate OCV curve, deliberately
+# not soc_model.c's table, and a higher resistance than SOC_MODEL_RINT_MOHM
+CELL_RINT_MOHM = 180
+CELL_OCV = [  # (state of charge 0-1, mV), highest first
+    (1.00, 4190), (0.90, 4070), (0.80, 3980), (0.70, 3910), (0.60, 3850),
+    (0.50, 3800), (0.40, 3760), (0.30, 3720), (0.20, 3680), (0.10, 3600),
+    (0.05, 3500), (0.00, 3300),
+]
+
+
+def cell_ocv_mv(soc):
+    for (s_hi, v_hi), (s_lo, v_lo) in zip(CELL_OCV, CELL_OCV[1:]):
+        if soc >= s_lo:
+            return v_lo + (soc - s_lo) * (v_hi - v_lo) / (s_hi - s_lo)
+    return CELL_OCV[-1][1]
+
+
+class SocModel:
+    """Integer port of soc_model_update(), with the curve read from the C source."""
+
+    def __init__(self):
+        with open(SOC_MODEL_H) as f:
+            header = f.read()
+        consts = dict(re.findall(r"#define (SOC_MODEL_\w+) (\d+)", header))
+        self.rint_mohm = int(consts["SOC_MODEL_RINT_MOHM"])
+        self.shift = int(consts["SOC_MODEL_FILTER_SHIFT"])
+        with open(SOC_MODEL_C) as f:
+            source = f.read()
+        self.curve = [(int(consts.get(mv, mv)), int(soc))
+                      for mv, soc in re.findall(r"\{(SOC_MODEL_\w+|\d+), (\d+)\}", source)]
+        self.soc_q8 = None
+
+    def lookup(self, ocv_mv):
+        if ocv_mv >= self.curve[0][0]:
+            return self.curve[0][1]
+        for (hi_mv, hi_soc), (lo_mv, lo_soc) in zip(self.curve, self.curve[1:]):
+            if ocv_mv >= lo_mv:
+                return lo_soc + (ocv_mv - lo_mv) * (hi_soc - lo_soc) // (hi_mv - lo_mv)
+        return 0
+
+    def update(self, mv, load_ua):
+        target_q8 = self.lookup(mv + load_ua * self.rint_mohm // 1000000) << 8
+        if self.soc_q8 is None:
+            self.soc_q8 = target_q8
+        else:
+            self.soc_q8 += (target_q8 - self.soc_q8) >> self.shift
+        return (self.soc_q8 + 128) >> 8
+
+
+def main():
+    rng = random.Random(43)
+    model = SocModel()
+    print("# Synthetic discharge log written by gen_discharge.py (seeded, so regenerating is reproducible).")
+    print("# SoC is what the firmware's model prints; ref is the simulated cell's coulomb-counted SoC.")
+    print("# Replace with a bench capture when available.")
+
+    charge_mah = float(CAPACITY_MAH)
+    t = 0
+    display = wifi = False
+    next_log = FIRST_LOG_S
+    while True:
+        if t % LOG_PERIOD_S == 0:
+            display = rng.random() < 0.3
+            wifi = rng.random() < 0.2
+            ledger_error = 1 + rng.uniform(-LEDGER_ERROR, LEDGER_ERROR)
+        ledger_ua = BASE_UA + (DISPLAY_UA if display else 0) + (WIFI_UA if wifi else 0)
+        true_ua = ledger_ua * ledger_error
+        soc = charge_mah / CAPACITY_MAH
+
+        if t >= next_log:
+            mv = round(cell_ocv_mv(soc) - true_ua * CELL_RINT_MOHM / 1e6 + rng.gauss(0, NOISE_MV))
+            if mv < 3350 or soc <= 0.01:
+                break
+            raw = round(mv / 3 * 4095 / 3300)
+            model_milli = model.update(mv, ledger_ua)
+            ref_milli = round(soc * 1000)
+            print(f"I ({t * 1000}) main: Battery: {mv / 1000:.3f} V (raw {raw}), load {ledger_ua} uA, "
+                  f"SoC {model_milli // 10}.{model_milli % 10}%, read took {rng.randint(3, 8)} us, "
+                  f"ref {ref_milli // 10}.{ref_milli % 10}%")
+            next_log += LOG_PERIOD_S
+
+        charge_mah -= true_ua / 1000 * STEP_S / 3600
+        t += STEP_S
+
+
+if __name__ == "__main__":
+    main()
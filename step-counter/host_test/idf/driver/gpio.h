@@ -0,0 +1,10 @@
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+#include "esp_err.h"
+
+// Host stand-in: mocks provide the calls their modules make
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags);
+
+#endif // DRIVER_GPIO_H
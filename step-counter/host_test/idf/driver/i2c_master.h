@@ -0,0 +1,29 @@
+#ifndef DRIVER_I2C_MASTER_H
+#define DRIVER_I2C_MASTER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Host stand-in: mocks provide the calls their modules make
+
+#define I2C_NUM_0 0
+#define I2C_CLK_SRC_DEFAULT 0
+
+typedef struct i2c_master_bus *i2c_master_bus_handle_t;
+
+typedef struct {
+    int i2c_port;
+    int sda_io_num;
+    int scl_io_num;
+    int clk_source;
+    uint8_t glitch_ignore_cnt;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *config, i2c_master_bus_handle_t *ret_bus);
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus);
+
+#endif // DRIVER_I2C_MASTER_H
@@ -0,0 +1,9 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+// Host stand-in: placement attributes mean nothing off the chip
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // ESP_ATTR_H
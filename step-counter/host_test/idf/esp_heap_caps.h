@@ -0,0 +1,18 @@
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+// Host stand-in: every capability is plain malloc
+
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+#define heap_caps_malloc(size, caps) ((void)(caps), malloc(size))
+#define heap_caps_calloc(n, size, caps) ((void)(caps), calloc(n, size))
+#define heap_caps_free(ptr) free(ptr)
+#define heap_caps_get_free_size(caps) ((void)(caps), (size_t)0)  // No heap regions to report
+
+#endif // ESP_HEAP_CAPS_H
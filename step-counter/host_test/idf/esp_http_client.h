@@ -0,0 +1,13 @@
+#ifndef ESP_HTTP_CLIENT_H
+#define ESP_HTTP_CLIENT_H
+
+#include <stdbool.h>
+
+// Host stand-in: tests provide the body reads as their network
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+
+#endif // ESP_HTTP_CLIENT_H
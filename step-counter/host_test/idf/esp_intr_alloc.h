@@ -0,0 +1,6 @@
+#ifndef ESP_INTR_ALLOC_H
+#define ESP_INTR_ALLOC_H
+
+#define ESP_INTR_FLAG_IRAM (1 << 10)
+
+#endif // ESP_INTR_ALLOC_H
@@ -0,0 +1,28 @@
+#ifndef ESP_LCD_PANEL_IO_H
+#define ESP_LCD_PANEL_IO_H
+
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Host stand-in: mocks provide the calls their modules make
+
+typedef struct esp_lcd_panel_io *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_io_event_data esp_lcd_panel_io_event_data_t;
+typedef bool (*esp_lcd_panel_io_color_trans_done_cb_t)(esp_lcd_panel_io_handle_t panel_io,
+                                                       esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
+
+typedef struct {
+    uint32_t dev_addr;
+    uint32_t scl_speed_hz;
+    uint32_t control_phase_bytes;
+    uint32_t lcd_cmd_bits;
+    uint32_t lcd_param_bits;
+} esp_lcd_panel_io_i2c_config_t;
+
+esp_err_t esp_lcd_new_panel_io_i2c(i2c_master_bus_handle_t bus, const esp_lcd_panel_io_i2c_config_t *config,
+                                   esp_lcd_panel_io_handle_t *ret_io);
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io);
+
+#endif // ESP_LCD_PANEL_IO_H
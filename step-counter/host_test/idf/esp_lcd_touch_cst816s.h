@@ -0,0 +1,36 @@
+#ifndef ESP_LCD_TOUCH_CST816S_H
+#define ESP_LCD_TOUCH_CST816S_H
+
+#include "esp_err.h"
+#include "esp_lcd_panel_io.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Host stand-in for the esp_lcd_touch_cst816s component; mock_touch.c implements it
+
+typedef struct esp_lcd_touch_s *esp_lcd_touch_handle_t;
+typedef void (*esp_lcd_touch_interrupt_callback_t)(esp_lcd_touch_handle_t tp);
+
+typedef struct {
+    uint16_t x_max;
+    uint16_t y_max;
+    int rst_gpio_num;
+    int int_gpio_num;
+    struct {
+        unsigned int reset : 1;
+        unsigned int interrupt : 1;
+    } levels;
+    esp_lcd_touch_interrupt_callback_t interrupt_callback;
+} esp_lcd_touch_config_t;
+
+#define ESP_LCD_TOUCH_IO_I2C_CST816S_ADDRESS 0x15
+#define ESP_LCD_TOUCH_IO_I2C_CST816S_CONFIG() \
+    { .dev_addr = ESP_LCD_TOUCH_IO_I2C_CST816S_ADDRESS, .control_phase_bytes = 1, .lcd_cmd_bits = 8 }
+
+esp_err_t esp_lcd_touch_new_i2c_cst816s(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config,
+                                        esp_lcd_touch_handle_t *ret_touch);
+esp_err_t esp_lcd_touch_read_data(esp_lcd_touch_handle_t tp);
+bool esp_lcd_touch_get_coordinates(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength,
+                                   uint8_t *point_num, uint8_t max_point_num);
+
+#endif // ESP_LCD_TOUCH_CST816S_H
@@ -0,0 +1,15 @@
+#ifndef ESP_OTA_OPS_H
+#define ESP_OTA_OPS_H
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-in: tests provide the write
+
+typedef uint32_t esp_ota_handle_t;
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void *data, size_t size, uint32_t offset);
+
+#endif // ESP_OTA_OPS_H
@@ -0,0 +1,18 @@
+#ifndef ESP_PARTITION_H
+#define ESP_PARTITION_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-in: tests provide the erase and supply their own flash backing
+
+typedef struct {
+    uint32_t address;
+    uint32_t size;
+    const char *label;
+} esp_partition_t;
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+#endif // ESP_PARTITION_H
@@ -0,0 +1,9 @@
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+/** Host stand-in: CLOCK_MONOTONIC in microseconds */
+int64_t esp_timer_get_time(void);
+
+#endif // ESP_TIMER_H
@@ -0,0 +1,27 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+/*
+ * Host stand-in for the FreeRTOS API subset the modules under test use,
+ * backed by pthreads (idf_shim.c). One tick is one millisecond.
+ */
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY ((BaseType_t)0x7fffffff)
+
+// No interrupts on the host: "ISR" callers are ordinary threads
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#endif // FREERTOS_H
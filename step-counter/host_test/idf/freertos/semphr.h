@@ -0,0 +1,27 @@
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include "freertos/queue.h"
+
+// Semaphores are zero-size-item queues, as in FreeRTOS
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreCreateBinary() xQueueCreate(1, 0)
+#define xSemaphoreCreateCounting(max, initial) host_semaphore_create_counting(max, initial)
+#define xSemaphoreTake(sem, ticks) xQueueReceive(sem, NULL, ticks)
+#define xSemaphoreGive(sem) xQueueSend(sem, NULL, 0)
+#define uxSemaphoreGetCount(sem) uxQueueMessagesWaiting(sem)
+#define vSemaphoreDelete(sem) vQueueDelete(sem)
+#define xSemaphoreGiveFromISR(sem, woken) ((void)(woken), xSemaphoreGive(sem))
+
+#define xSemaphoreCreateRecursiveMutex() host_recursive_mutex_create()
+#define xSemaphoreTakeRecursive(sem, ticks) host_recursive_mutex_take(sem, ticks)
+#define xSemaphoreGiveRecursive(sem) host_recursive_mutex_give(sem)
+
+SemaphoreHandle_t host_semaphore_create_counting(UBaseType_t max, UBaseType_t initial);
+SemaphoreHandle_t host_recursive_mutex_create(void);
+BaseType_t host_recursive_mutex_take(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t host_recursive_mutex_give(SemaphoreHandle_t mutex);
+
+#endif // SEMPHR_H
@@ -0,0 +1,33 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef struct host_task *TaskHandle_t;
+
+/** Runs fn on a detached thread; core and priority are ignored */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+#define xTaskCreate(fn, name, stack, arg, prio, handle) \
+    xTaskCreatePinnedToCore(fn, name, stack, arg, prio, handle, tskNO_AFFINITY)
+
+/** Only vTaskDelete(NULL) is supported: the calling thread exits */
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+/** Threads not started by xTaskCreate get a handle on first use */
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+// Direct-to-task notifications, used as a counting semaphore
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+
+// Lookups for task_placement_log(); the host has no named tasks to report
+TaskHandle_t xTaskGetHandle(const char *name);
+BaseType_t xTaskGetCoreID(TaskHandle_t task);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+
+#endif // TASK_H
@@ -0,0 +1,159 @@
+#include "mock_touch.h"
+#include "esp_lcd_touch_cst816s.h"
+#include "driver/gpio.h"
+#include <stddef.h>
+
+struct esp_lcd_touch_s {
+    esp_lcd_touch_interrupt_callback_t isr;
+    bool pressed;       // Latched by the last read
+    uint16_t x;
+    uint16_t y;
+};
+
+static mock_touch_fail_t fail_at = MOCK_TOUCH_FAIL_NONE;
+static bool isr_service_installed = false;
+static int live_buses = 0;
+static int live_ios = 0;
+static uint32_t reads = 0;
+static struct esp_lcd_touch_s controller;
+
+// What the finger is doing now, as opposed to what the last read saw
+static bool finger_down = false;
+static uint16_t finger_x = 0;
+static uint16_t finger_y = 0;
+
+void mock_touch_reset(mock_touch_fail_t fail)
+{
+    fail_at = fail;
+    finger_down = false;
+}
+
+static void raise_interrupt(void)
+{
+    if (controller.isr != NULL) {
+        controller.isr(&controller);
+    }
+}
+
+void mock_touch_press(uint16_t x, uint16_t y)
+{
+    finger_down = true;
+    finger_x = x;
+    finger_y = y;
+    raise_interrupt();
+}
+
+void mock_touch_release(void)
+{
+    finger_down = false;
+    raise_interrupt();
+}
+
+int mock_touch_live_buses(void)
+{
+    return live_buses;
+}
+
+int mock_touch_live_ios(void)
+{
+    return live_ios;
+}
+
+uint32_t mock_touch_reads(void)
+{
+    return reads;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *config, i2c_master_bus_handle_t *ret_bus)
+{
+    (void)config;
+    if (fail_at == MOCK_TOUCH_FAIL_BUS) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    live_buses++;
+    *ret_bus = (i2c_master_bus_handle_t)&live_buses;
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus)
+{
+    if (bus == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    live_buses--;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_io_i2c(i2c_master_bus_handle_t bus, const esp_lcd_panel_io_i2c_config_t *config,
+                                   esp_lcd_panel_io_handle_t *ret_io)
+{
+    (void)config;
+    if (bus == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (fail_at == MOCK_TOUCH_FAIL_IO) {
+        return ESP_ERR_NO_MEM;
+    }
+    live_ios++;
+    *ret_io = (esp_lcd_panel_io_handle_t)&live_ios;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_del(esp_lcd_panel_io_handle_t io)
+{
+    if (io == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    live_ios--;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    (void)intr_alloc_flags;
+    if (fail_at == MOCK_TOUCH_FAIL_ISR) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (isr_service_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    isr_service_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_touch_new_i2c_cst816s(esp_lcd_panel_io_handle_t io, const esp_lcd_touch_config_t *config,
+                                        esp_lcd_touch_handle_t *ret_touch)
+{
+    if (io == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (fail_at == MOCK_TOUCH_FAIL_CONTROLLER) {
+        return ESP_ERR_NOT_FOUND;  // No ACK from the controller
+    }
+    controller.isr = config->interrupt_callback;
+    controller.pressed = false;
+    *ret_touch = &controller;
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_touch_read_data(esp_lcd_touch_handle_t tp)
+{
+    reads++;
+    tp->pressed = finger_down;
+    tp->x = finger_x;
+    tp->y = finger_y;
+    return ESP_OK;
+}
+
+bool esp_lcd_touch_get_coordinates(esp_lcd_touch_handle_t tp, uint16_t *x, uint16_t *y, uint16_t *strength,
+                                   uint8_t *point_num, uint8_t max_point_num)
+{
+    (void)max_point_num;
+    *point_num = tp->pressed ? 1 : 0;
+    if (tp->pressed) {
+        *x = tp->x;
+        *y = tp->y;
+        *strength = 100;
+    }
+    return tp->pressed;
+}
@@ -0,0 +1,54 @@
+#ifndef MOCK_TOUCH_H
+#define MOCK_TOUCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Mock CST816S for host tests: implements the I2C bus, panel IO, GPIO ISR
+ * service and esp_lcd_touch calls touch.c makes. Presses and releases raise
+ * the interrupt callback the way the controller's INT line would.
+ */
+
+/**
+ * @brief Step of touch_init() to fail
+ */
+typedef enum {
+    MOCK_TOUCH_FAIL_NONE = 0,
+    MOCK_TOUCH_FAIL_BUS,          ///< i2c_new_master_bus
+    MOCK_TOUCH_FAIL_IO,           ///< esp_lcd_new_panel_io_i2c
+    MOCK_TOUCH_FAIL_ISR,          ///< gpio_install_isr_service
+    MOCK_TOUCH_FAIL_CONTROLLER,   ///< esp_lcd_touch_new_i2c_cst816s
+} mock_touch_fail_t;
+
+/**
+ * @brief Release the finger and make the next touch_init() fail at a step
+ */
+void mock_touch_reset(mock_touch_fail_t fail);
+
+/**
+ * @brief Put a finger down (or move it) and raise the interrupt
+ */
+void mock_touch_press(uint16_t x, uint16_t y);
+
+/**
+ * @brief Lift the finger and raise the interrupt
+ */
+void mock_touch_release(void);
+
+/**
+ * @brief I2C buses created and not yet deleted
+ */
+int mock_touch_live_buses(void);
+
+/**
+ * @brief Panel IO handles created and not yet deleted
+ */
+int mock_touch_live_ios(void);
+
+/**
+ * @brief Controller reads (esp_lcd_touch_read_data calls) so far
+ */
+uint32_t mock_touch_reads(void);
+
+#endif // MOCK_TOUCH_H
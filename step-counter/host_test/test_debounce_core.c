@@ -0,0 +1,121 @@
+#include "debounce_core.h"
+#include "check.h"
+
+#define WINDOW_US 80000
+
+typedef struct {
+    uint64_t t_us;
+    int level;
+} edge_t;
+
+/*
+ * Drive the core the way step_counter.c does, with an ideal one-shot
+ * timer, and return the number of accepted steps. Acceptance times go to
+ * accepted[] when it is given.
+ */
+static int run(const edge_t *edges, int count, uint64_t *accepted)
+{
+    debounce_t d;
+    debounce_init(&d, WINDOW_US);
+    bool armed = false;
+    int level = -1, steps = 0;
+
+    for (int i = 0; i <= count; i++) {
+        uint64_t t = i < count ? edges[i].t_us : UINT64_MAX;
+        if (armed && d.deadline_us <= t) {
+            armed = false;
+            if (debounce_expire(&d, level)) {
+                if (accepted != NULL) {
+                    accepted[steps] = d.deadline_us;
+                }
+                steps++;
+            }
+        }
+        if (i == count) {
+            break;
+        }
+        level = edges[i].level;
+        debounce_action_t action = debounce_edge(&d, level, t);
+        if (action == DEBOUNCE_ARM) {
+            armed = true;
+        } else if (action == DEBOUNCE_CANCEL) {
+            armed = false;
+        }
+    }
+    return steps;
+}
+
+static void test_actions(void)
+{
+    debounce_t d;
+    debounce_init(&d, WINDOW_US);
+
+    // The first edge only records the resting level
+    CHECK_EQ(debounce_edge(&d, 1, 0), DEBOUNCE_NONE);
+    CHECK_EQ(d.stable, 1);
+
+    CHECK_EQ(debounce_edge(&d, 0, 1000), DEBOUNCE_ARM);
+    CHECK_EQ(d.deadline_us, 1000 + WINDOW_US);
+    // A repeated edge at the pending level does not restart the window
+    CHECK_EQ(debounce_edge(&d, 0, 2000), DEBOUNCE_NONE);
+    CHECK_EQ(d.deadline_us, 1000 + WINDOW_US);
+    // Back to the stable level: cancel, then a second return is a no-op
+    CHECK_EQ(debounce_edge(&d, 1, 3000), DEBOUNCE_CANCEL);
+    CHECK_EQ(debounce_edge(&d, 1, 3500), DEBOUNCE_NONE);
+    // Leaving again restarts the window from the new edge
+    CHECK_EQ(debounce_edge(&d, 0, 4000), DEBOUNCE_ARM);
+    CHECK_EQ(d.deadline_us, 4000 + WINDOW_US);
+
+    // Expiry with the pin elsewhere (an edge was missed) accepts nothing
+    CHECK(!debounce_expire(&d, 1));
+    CHECK_EQ(d.stable, 1);
+    CHECK_EQ(d.pending, -1);
+
+    CHECK_EQ(debounce_edge(&d, 0, 100000), DEBOUNCE_ARM);
+    CHECK(debounce_expire(&d, 0));
+    CHECK_EQ(d.stable, 0);
+    // A stale second expiry does not count twice
+    CHECK(!debounce_expire(&d, 0));
+}
+
+static void test_sequences(void)
+{
+    // Clean press and release: two level changes, each accepted a window later
+    static const edge_t clean[] = {{0, 1}, {10000, 0}, {200000, 1}};
+    uint64_t at[4];
+    CHECK_EQ(run(clean, 3, at), 2);
+    CHECK_EQ(at[0], 10000 + WINDOW_US);
+    CHECK_EQ(at[1], 200000 + WINDOW_US);
+
+    // Contact chatter: the window runs from the last edge into the new level
+    static const edge_t chatter[] = {
+        {0, 1}, {10000, 0}, {10300, 1}, {10700, 0}, {11500, 1}, {12000, 0}, {300000, 1},
+    };
+    CHECK_EQ(run(chatter, 7, at), 2);
+    CHECK_EQ(at[0], 12000 + WINDOW_US);
+
+    // A pulse shorter than the window is not a step
+    static const edge_t glitch[] = {{0, 1}, {10000, 0}, {50000, 1}, {500000, 0}, {500000 + WINDOW_US - 1, 1}};
+    CHECK_EQ(run(glitch, 5, NULL), 0);
+
+    // A step every 400 ms for an hour, each with a burst of bounce
+    static edge_t walk[4 * 9000 + 1];
+    int n = 0;
+    walk[n++] = (edge_t){0, 1};
+    for (int i = 0; i < 9000; i++) {
+        uint64_t t = 100000 + (uint64_t)i * 400000;
+        int level = i % 2 == 0 ? 0 : 1;
+        walk[n++] = (edge_t){t, level};
+        walk[n++] = (edge_t){t + 400, !level};
+        walk[n++] = (edge_t){t + 900, level};
+        walk[n++] = (edge_t){t + 1500 + (i % 7) * 300, level};
+    }
+    CHECK_EQ(run(walk, n, NULL), 9000);
+}
+
+int main(void)
+{
+    test_actions();
+    test_sequences();
+    return check_result("debounce_core");
+}
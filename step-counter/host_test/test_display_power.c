@@ -0,0 +1,134 @@
+#include "display_power.h"
+#include "check.h"
+#include <string.h>
+
+/*
+ * Mock panel: every operation is appended to a trace string so the tests
+ * can check the exact order the state machine sends them in.
+ */
+static char trace[256];
+static esp_err_t fail_on_off = ESP_OK;
+static esp_err_t fail_sleep = ESP_OK;
+
+static void record(const char *op)
+{
+    if (trace[0] != '\0') {
+        strcat(trace, " ");
+    }
+    strcat(trace, op);
+}
+
+static esp_err_t mock_on_off(void *ctx, bool on)
+{
+    (void)ctx;
+    record(on ? "DISPON" : "DISPOFF");
+    return fail_on_off;
+}
+
+static esp_err_t mock_sleep(void *ctx, bool sleep)
+{
+    (void)ctx;
+    record(sleep ? "SLPIN" : "SLPOUT");
+    return fail_sleep;
+}
+
+static void mock_backlight(void *ctx, bool on)
+{
+    (void)ctx;
+    record(on ? "BL_ON" : "BL_OFF");
+}
+
+static const display_power_ops_t mock_ops = {
+    .disp_on_off = mock_on_off,
+    .disp_sleep = mock_sleep,
+    .backlight = mock_backlight,
+};
+
+static void reset(display_power_t *dp)
+{
+    trace[0] = '\0';
+    fail_on_off = ESP_OK;
+    fail_sleep = ESP_OK;
+    display_power_init(dp, &mock_ops);
+}
+
+static void test_sleep_wake_cycle(void)
+{
+    display_power_t dp;
+    reset(&dp);
+
+    CHECK_EQ(display_power_sleep(&dp), ESP_OK);
+    CHECK(strcmp(trace, "BL_OFF DISPOFF SLPIN") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_SLEEP);
+
+    // Already asleep: nothing goes to the panel
+    trace[0] = '\0';
+    CHECK_EQ(display_power_sleep(&dp), ESP_OK);
+    CHECK(strcmp(trace, "") == 0);
+
+    // The panel leaves sleep mode but stays dark while LVGL redraws
+    CHECK_EQ(display_power_wake_begin(&dp, 1000), ESP_OK);
+    CHECK(strcmp(trace, "SLPOUT") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_WAKING);
+
+    trace[0] = '\0';
+    CHECK_EQ(display_power_wake_finish(&dp, 1000 + 43210), ESP_OK);
+    CHECK(strcmp(trace, "DISPON BL_ON") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_ON);
+    CHECK_EQ(dp.last_wake_latency_us, 43210);
+}
+
+static void test_out_of_order_calls(void)
+{
+    display_power_t dp;
+    reset(&dp);
+
+    // Waking an awake panel, or finishing a wake that never began, is a no-op
+    CHECK_EQ(display_power_wake_begin(&dp, 0), ESP_OK);
+    CHECK_EQ(display_power_wake_finish(&dp, 0), ESP_OK);
+    CHECK(strcmp(trace, "") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_ON);
+    CHECK_EQ(dp.last_wake_latency_us, 0);
+
+    display_power_t detached = { 0 };
+    CHECK_EQ(display_power_sleep(&detached), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(display_power_wake_begin(&detached, 0), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(display_power_wake_finish(&detached, 0), ESP_ERR_INVALID_STATE);
+}
+
+static void test_failures(void)
+{
+    display_power_t dp;
+
+    // DISPOFF fails: no SLPIN is sent and the panel is still considered on
+    reset(&dp);
+    fail_on_off = ESP_FAIL;
+    CHECK_EQ(display_power_sleep(&dp), ESP_FAIL);
+    CHECK(strcmp(trace, "BL_OFF DISPOFF") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_ON);
+
+    // SLPOUT fails: stay asleep so the next wake retries it
+    reset(&dp);
+    display_power_sleep(&dp);
+    fail_sleep = ESP_ERR_TIMEOUT;
+    CHECK_EQ(display_power_wake_begin(&dp, 0), ESP_ERR_TIMEOUT);
+    CHECK_EQ(dp.state, DISPLAY_POWER_SLEEP);
+
+    // DISPON fails: the backlight stays off over a blank panel
+    reset(&dp);
+    display_power_sleep(&dp);
+    display_power_wake_begin(&dp, 0);
+    trace[0] = '\0';
+    fail_on_off = ESP_FAIL;
+    CHECK_EQ(display_power_wake_finish(&dp, 10), ESP_FAIL);
+    CHECK(strcmp(trace, "DISPON") == 0);
+    CHECK_EQ(dp.state, DISPLAY_POWER_WAKING);
+}
+
+int main(void)
+{
+    test_sleep_wake_cycle();
+    test_out_of_order_calls();
+    test_failures();
+    return check_result("display_power");
+}
@@ -0,0 +1,83 @@
+#include "energy_model.h"
+#include "check.h"
+
+static const energy_currents_t currents = {.ua = {
+    [ENERGY_SUB_WIFI] = 80000,
+    [ENERGY_SUB_TLS] = 40000,
+    [ENERGY_SUB_DISPLAY] = 35000,
+    [ENERGY_SUB_CPU] = 25000,
+    [ENERGY_SUB_BASE] = 20000,
+}};
+
+static void test_ledger(void)
+{
+    energy_model_t m;
+    energy_model_init(&m, &currents, 1000, 0);
+    energy_model_set(&m, 0, ENERGY_SUB_DISPLAY, true);
+
+    // One minute with the display on and half a core busy
+    energy_model_advance(&m, 60000, 30000);
+    CHECK_EQ(m.on_ms[ENERGY_SUB_DISPLAY], 60000);
+    CHECK_EQ(m.on_ms[ENERGY_SUB_CPU], 30000);
+    CHECK_EQ(m.on_ms[ENERGY_SUB_WIFI], 0);
+    CHECK_EQ(m.charge_uams[ENERGY_SUB_BASE], 20000ULL * 60000);
+    CHECK_EQ(m.charge_uams[ENERGY_SUB_CPU], 25000ULL * 30000);
+
+    // WiFi for the next minute; the set integrates up to its timestamp first
+    energy_model_set(&m, 60000, ENERGY_SUB_WIFI, true);
+    energy_model_advance(&m, 120000, 0);
+    CHECK_EQ(m.on_ms[ENERGY_SUB_WIFI], 60000);
+    CHECK_EQ(m.charge_uams[ENERGY_SUB_WIFI], 80000ULL * 60000);
+
+    // 20 mA base + 35 mA display + 40 mA WiFi half the time + 6.25 mA CPU
+    CHECK_EQ(energy_model_avg_current_ua(&m), 101250);
+    CHECK_EQ(energy_model_runtime_min(&m, 500), 500000ULL * 60 / 101250);
+    CHECK_EQ(energy_model_runtime_min(&m, -1), -1);
+
+    // CPU and base are not switchable, and time never runs backwards
+    uint32_t mask = m.mask;
+    energy_model_set(&m, 120000, ENERGY_SUB_CPU, true);
+    CHECK_EQ(m.mask, mask);
+    energy_model_advance(&m, 100000, 0);
+    CHECK_EQ(m.last_ms, 120000);
+    CHECK_EQ(m.on_ms[ENERGY_SUB_BASE], 120000);
+}
+
+static void test_voltage_trend(void)
+{
+    energy_model_t m;
+    energy_model_init(&m, &currents, 1000, 0);
+    CHECK_EQ(energy_model_runtime_min(&m, 500), -1);
+
+    energy_model_add_voltage(&m, 0, 4000);
+    energy_model_add_voltage(&m, ENERGY_MODEL_TREND_INTERVAL_MS / 2, 3000);
+    CHECK(!m.trend_valid);
+
+    // 10 mV over ten minutes is 60 mV/h
+    energy_model_add_voltage(&m, 600000, 3990);
+    CHECK(m.trend_valid);
+    CHECK_EQ(m.slope_uv_per_h, -60000);
+
+    // Base load only: 500 mAh at 20 mA is 1500 minutes by charge
+    energy_model_advance(&m, 600000, 0);
+    int32_t trend_min = (3990 - ENERGY_MODEL_EMPTY_MV) * 1000 * 60 / 60000;
+    CHECK_EQ(energy_model_runtime_min(&m, 500), (1500 + trend_min) / 2);
+
+    // The next interval is smoothed in by a quarter
+    energy_model_add_voltage(&m, 1200000, 3970);
+    CHECK_EQ(m.slope_uv_per_h, -60000 + (-120000 + 60000) / 4);
+
+    // A rising voltage (charging) leaves only the charge estimate
+    energy_model_add_voltage(&m, 1800000, 4100);
+    energy_model_add_voltage(&m, 2400000, 4150);
+    energy_model_advance(&m, 2400000, 0);
+    CHECK(m.slope_uv_per_h > 0);
+    CHECK_EQ(energy_model_runtime_min(&m, 500), 1500);
+}
+
+int main(void)
+{
+    test_ledger();
+    test_voltage_trend();
+    return check_result("energy_model");
+}
@@ -0,0 +1,121 @@
+#include "json_stream.h"
+#include "check.h"
+#include <string.h>
+
+/*
+ * Streams a worst-case /scan response (20 networks with 32-byte SSIDs full
+ * of characters that need escaping) through buffers of several sizes,
+ * checks the output matches byte for byte, and prints the memory each one
+ * needs.
+ */
+
+typedef struct {
+    char out[8192];
+    size_t len;
+    size_t largest_flush;
+} sink_t;
+
+static bool collect(void *ctx, const char *data, size_t len)
+{
+    sink_t *sink = ctx;
+    if (sink->len + len > sizeof(sink->out)) {
+        return false;
+    }
+    memcpy(sink->out + sink->len, data, len);
+    sink->len += len;
+    sink->largest_flush = len > sink->largest_flush ? len : sink->largest_flush;
+    return true;
+}
+
+static void write_scan(json_stream_t *s)
+{
+    char ssid[33];
+    json_stream_raw(s, "{\"scanning\":false,\"networks\":[");
+    for (int i = 0; i < 20; i++) {
+        for (int j = 0; j < 32; j++) {
+            ssid[j] = (j % 3 == 0) ? '"' : (j % 3 == 1) ? '\x01' : 'a' + i;
+        }
+        ssid[32] = '\0';
+        if (i > 0) {
+            json_stream_raw(s, ",");
+        }
+        json_stream_raw(s, "{\"ssid\":");
+        json_stream_string(s, ssid, sizeof(ssid));
+        json_stream_raw(s, ",\"rssi\":");
+        json_stream_int(s, -30 - i * 3);
+        json_stream_raw(s, "}");
+    }
+    json_stream_raw(s, "]}");
+}
+
+static bool refuse(void *ctx, const char *data, size_t len)
+{
+    (void)data;
+    (void)len;
+    (*(int *)ctx)++;
+    return false;
+}
+
+static void test_escaping(void)
+{
+    static sink_t sink;
+    char buf[16];
+    json_stream_t s;
+    memset(&sink, 0, sizeof(sink));
+    json_stream_init(&s, buf, sizeof(buf), collect, &sink);
+    json_stream_string(&s, "a\"b\\c\n\x1f", 32);
+    json_stream_raw(&s, ",");
+    json_stream_string(&s, "truncated", 4);
+    json_stream_raw(&s, ",");
+    json_stream_int(&s, -2147483647 - 1);
+    CHECK(json_stream_finish(&s));
+
+    const char *expected = "\"a\\\"b\\\\c\\u000a\\u001f\",\"trun\",-2147483648";
+    CHECK_EQ(sink.len, strlen(expected));
+    CHECK(memcmp(sink.out, expected, strlen(expected)) == 0);
+    CHECK_EQ(s.total, sink.len);
+}
+
+static void test_abort(void)
+{
+    // A refused flush stops the stream: nothing more is sent and finish reports it
+    int calls = 0;
+    char buf[8];
+    json_stream_t s;
+    json_stream_init(&s, buf, sizeof(buf), refuse, &calls);
+    json_stream_raw(&s, "0123456789abcdefghijklmnop");
+    CHECK(!json_stream_finish(&s));
+    CHECK(s.failed);
+    CHECK_EQ(calls, 1);
+}
+
+int main(void)
+{
+    static sink_t reference;
+    char big[8192];
+    json_stream_t s;
+    json_stream_init(&s, big, sizeof(big), collect, &reference);
+    write_scan(&s);
+    CHECK(json_stream_finish(&s));
+    CHECK_EQ(s.flushes, 1);
+    printf("worst-case /scan response: %zu bytes (cJSON tree + printed copy would hold all of it in heap)\n", reference.len);
+
+    static const size_t sizes[] = {8, 32, 128, 512};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        static sink_t sink;
+        char buf[512];
+        memset(&sink, 0, sizeof(sink));
+        json_stream_init(&s, buf, sizes[i], collect, &sink);
+        write_scan(&s);
+        CHECK(json_stream_finish(&s));
+        CHECK_EQ(sink.len, reference.len);
+        CHECK(sink.len == reference.len && memcmp(sink.out, reference.out, reference.len) == 0);
+        CHECK(sink.largest_flush <= sizes[i]);
+        printf("buffer %3zu: %4lu flushes, peak memory %zu + %zu bytes writer state\n", sizes[i],
+               (unsigned long)s.flushes, sink.largest_flush, sizeof(json_stream_t));
+    }
+
+    test_escaping();
+    test_abort();
+    return check_result("json_stream");
+}
@@ -0,0 +1,115 @@
+#include "metrics.h"
+#include "check.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/*
+ * Several threads hammer every update path at once while a reader takes
+ * snapshots, then the totals are compared with what was sent.
+ */
+
+#define THREADS 8
+#define ITERATIONS 200000
+
+static atomic_bool stop_reader;
+static uint32_t reader_errors = 0;
+
+static void *writer(void *arg)
+{
+    uint32_t seed = (uint32_t)(uintptr_t)arg;
+    for (int i = 0; i < ITERATIONS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        metrics_counter_add(METRIC_STEPS_DROPPED, 1);
+        metrics_counter_add(METRIC_WS_RECONNECTS, 2);
+        metrics_gauge_min(METRIC_HEAP_LOW_WATER, 100000 + (seed >> 16));
+        metrics_histogram_record(METRIC_WS_SEND_LATENCY_US, (seed >> 8) % 6000);
+        metrics_histogram_record(METRIC_TLS_HANDSHAKE_MS, 1);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    (void)arg;
+    uint32_t last = 0;
+    while (!atomic_load(&stop_reader)) {
+        metrics_snapshot_t snap;
+        metrics_snapshot(&snap);
+        // Counters and histogram counts never go backwards
+        if (snap.values[METRIC_STEPS_DROPPED].value < last) {
+            reader_errors++;
+        }
+        last = snap.values[METRIC_STEPS_DROPPED].value;
+        // Every TLS sample is 1, so sum never trails the count (it may lead by samples in flight)
+        if (snap.values[METRIC_TLS_HANDSHAKE_MS].sum < snap.values[METRIC_TLS_HANDSHAKE_MS].value) {
+            reader_errors++;
+        }
+    }
+    return NULL;
+}
+
+static void test_buckets(void)
+{
+    // Bounds are inclusive upper limits; the last bucket takes everything above
+    static const uint32_t samples[] = {0, 10, 11, 25, 5000, 5001, UINT32_MAX / 2};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        metrics_histogram_record(METRIC_DEBOUNCE_LATE_US, samples[i]);
+    }
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    const metric_value_t *v = &snap.values[METRIC_DEBOUNCE_LATE_US];
+    CHECK_EQ(v->value, 7);
+    CHECK_EQ(v->buckets[0], 2);
+    CHECK_EQ(v->buckets[1], 2);
+    CHECK_EQ(v->buckets[METRICS_HIST_BUCKETS - 2], 1);
+    CHECK_EQ(v->buckets[METRICS_HIST_BUCKETS - 1], 2);
+
+    metrics_gauge_set(METRIC_CPU_BUSY_PERMILLE, 250);
+    metrics_gauge_set(METRIC_CPU_BUSY_PERMILLE, 125);
+    metrics_snapshot(&snap);
+    CHECK_EQ(snap.values[METRIC_CPU_BUSY_PERMILLE].value, 125);
+    CHECK_EQ(snap.values[METRIC_CPU_BUSY_PERMILLE].sum, 0);
+}
+
+int main(void)
+{
+    pthread_t writers[THREADS], snapshotter;
+    pthread_create(&snapshotter, NULL, reader, NULL);
+    for (int t = 0; t < THREADS; t++) {
+        pthread_create(&writers[t], NULL, writer, (void *)(uintptr_t)(t + 1));
+    }
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(writers[t], NULL);
+    }
+    atomic_store(&stop_reader, true);
+    pthread_join(snapshotter, NULL);
+
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    const uint32_t expected = THREADS * ITERATIONS;
+    CHECK_EQ(reader_errors, 0);
+    CHECK_EQ(snap.values[METRIC_STEPS_DROPPED].value, expected);
+    CHECK_EQ(snap.values[METRIC_WS_RECONNECTS].value, 2 * expected);
+    CHECK_RANGE(snap.values[METRIC_HEAP_LOW_WATER].value, 100000, 100010);
+    CHECK_EQ(snap.values[METRIC_WS_SEND_LATENCY_US].value, expected);
+    CHECK_EQ(snap.values[METRIC_TLS_HANDSHAKE_MS].value, expected);
+    CHECK_EQ(snap.values[METRIC_TLS_HANDSHAKE_MS].sum, expected);
+
+    char line[160];
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        metrics_format_text(&snap, (metric_id_t)id, line, sizeof(line));
+        printf("%s\n", line);
+    }
+    char frame[384];
+    size_t len = metrics_format_frame(&snap, 60, frame, sizeof(frame));
+    printf("frame (%zu bytes): %s\n", len, frame);
+    CHECK(len > 0 && len < sizeof(frame));
+    const char *prefix = "{\"type\":\"metrics\",\"uptime_s\":60,";
+    CHECK(strncmp(frame, prefix, strlen(prefix)) == 0);
+    // Too small a buffer yields nothing rather than a truncated frame
+    CHECK_EQ(metrics_format_frame(&snap, 60, frame, 16), 0);
+
+    test_buckets();
+    return check_result("metrics");
+}
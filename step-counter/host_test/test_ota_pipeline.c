@@ -0,0 +1,256 @@
+/*
+ * ota_pipeline.c on the host: the real reader and writer task run on
+ * pthreads (idf_shim.c) against a paced network stand-in and a flash stand-in
+ * backed by a temporary file. Checks the written image, the erase bounds and
+ * the error paths, then times the pipeline against a serial read-erase-write
+ * loop over the same stand-ins.
+ *
+ * Timings are the device's scaled down 10x: a 4 KB sector erase ~30 ms, a
+ * 4 KB program ~10 ms, TLS over WiFi ~250 KB/s.
+ */
+#include "ota_pipeline.h"
+#include "check.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SECTOR_SIZE 4096
+#define PARTITION_SIZE (64 * SECTOR_SIZE)
+#define IMAGE_SIZE (48 * SECTOR_SIZE + 1234)
+#define NET_SEGMENT 1436        // TLS record payload per read
+#define NET_NS_PER_BYTE 400     // ~2.5 MB/s, 10x the device
+#define ERASE_US 3000
+#define WRITE_US_PER_SECTOR 1000
+
+// Network stand-in
+static const uint8_t *net_image;
+static int net_size;
+static int net_pos;
+static int net_fail_at = -1;    // Return an error once this offset is reached
+static int net_close_at = -1;   // Close the connection at this offset
+
+// Flash stand-in
+static FILE *flash;
+static const esp_partition_t partition = { .address = 0x110000, .size = PARTITION_SIZE, .label = "ota_0" };
+static uint32_t erased_bytes;
+static uint32_t erase_end;      // Highest offset erased so far
+static uint32_t write_fail_at = UINT32_MAX;
+static int unerased_writes;
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    (void)client;
+    if (net_fail_at >= 0 && net_pos >= net_fail_at) {
+        return -1;
+    }
+    int end = net_close_at >= 0 ? net_close_at : net_size;
+    int n = end - net_pos;
+    if (n > NET_SEGMENT) {
+        n = NET_SEGMENT;
+    }
+    if (n > len) {
+        n = len;
+    }
+    if (n <= 0) {
+        return 0;
+    }
+    memcpy(buffer, net_image + net_pos, n);
+    net_pos += n;
+    usleep(n * NET_NS_PER_BYTE / 1000);
+    return n;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+    (void)client;
+    return net_pos == net_size;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *p, size_t offset, size_t size)
+{
+    if (offset % SECTOR_SIZE || size % SECTOR_SIZE || offset + size > p->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    static uint8_t blank[SECTOR_SIZE];
+    memset(blank, 0xff, sizeof(blank));
+    fseek(flash, offset, SEEK_SET);
+    for (size_t done = 0; done < size; done += SECTOR_SIZE) {
+        fwrite(blank, 1, SECTOR_SIZE, flash);
+        usleep(ERASE_US);
+    }
+    erased_bytes += size;
+    if (offset + size > erase_end) {
+        erase_end = offset + size;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write_with_offset(esp_ota_handle_t handle, const void *data, size_t size, uint32_t offset)
+{
+    (void)handle;
+    if (offset >= write_fail_at) {
+        return ESP_ERR_FLASH_BASE;
+    }
+    // NOR flash only clears bits: writing over anything but 0xff corrupts it
+    uint8_t old[256];
+    for (size_t done = 0; done < size; done += sizeof(old)) {
+        size_t n = size - done < sizeof(old) ? size - done : sizeof(old);
+        fseek(flash, offset + done, SEEK_SET);
+        if (fread(old, 1, n, flash) != n) {
+            return ESP_FAIL;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (old[i] != 0xff) {
+                unerased_writes++;
+                break;
+            }
+        }
+    }
+    fseek(flash, offset, SEEK_SET);
+    fwrite(data, 1, size, flash);
+    usleep((useconds_t)((uint64_t)size * WRITE_US_PER_SECTOR / SECTOR_SIZE));
+    return ESP_OK;
+}
+
+static void reset(const uint8_t *image, int size)
+{
+    net_image = image;
+    net_size = size;
+    net_pos = 0;
+    net_fail_at = -1;
+    net_close_at = -1;
+    erased_bytes = 0;
+    erase_end = 0;
+    write_fail_at = UINT32_MAX;
+    unerased_writes = 0;
+
+    // Fresh flash full of an old image: nothing is writable until erased
+    static uint8_t stale[SECTOR_SIZE];
+    memset(stale, 0x5a, sizeof(stale));
+    fseek(flash, 0, SEEK_SET);
+    for (int i = 0; i < PARTITION_SIZE / SECTOR_SIZE; i++) {
+        fwrite(stale, 1, sizeof(stale), flash);
+    }
+}
+
+static bool flash_matches(const uint8_t *image, int size)
+{
+    uint8_t *readback = malloc(size);
+    fflush(flash);
+    fseek(flash, 0, SEEK_SET);
+    bool ok = fread(readback, 1, size, flash) == (size_t)size && memcmp(readback, image, size) == 0;
+    free(readback);
+    return ok;
+}
+
+static uint32_t round_up_sector(uint32_t n)
+{
+    return (n + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE;
+}
+
+static void test_full_image(const uint8_t *image, ota_pipeline_stats_t *stats)
+{
+    reset(image, IMAGE_SIZE);
+    esp_err_t err = ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, IMAGE_SIZE, NULL, stats);
+    CHECK_EQ(err, ESP_OK);
+    CHECK_EQ(stats->bytes, IMAGE_SIZE);
+    CHECK(flash_matches(image, IMAGE_SIZE));
+    CHECK_EQ(unerased_writes, 0);
+    // Each sector under the image erased once and nothing past it
+    CHECK_EQ(erased_bytes, round_up_sector(IMAGE_SIZE));
+    CHECK_EQ(erase_end, round_up_sector(IMAGE_SIZE));
+}
+
+static void test_unknown_length(const uint8_t *image)
+{
+    ota_pipeline_stats_t stats;
+    reset(image, IMAGE_SIZE);
+    esp_err_t err = ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, -1, NULL, &stats);
+    CHECK_EQ(err, ESP_OK);
+    CHECK_EQ(stats.bytes, IMAGE_SIZE);
+    CHECK(flash_matches(image, IMAGE_SIZE));
+    CHECK_EQ(unerased_writes, 0);
+    // Erase-ahead may run past the image but never past the partition
+    CHECK(erase_end <= PARTITION_SIZE);
+}
+
+static void test_errors(const uint8_t *image)
+{
+    ota_pipeline_stats_t stats;
+
+    reset(image, IMAGE_SIZE);
+    net_fail_at = IMAGE_SIZE / 2;
+    CHECK_EQ(ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, IMAGE_SIZE, NULL, &stats), ESP_FAIL);
+    CHECK(stats.bytes < IMAGE_SIZE);
+
+    reset(image, IMAGE_SIZE);
+    net_close_at = IMAGE_SIZE / 3;
+    CHECK_EQ(ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, IMAGE_SIZE, NULL, &stats), ESP_FAIL);
+
+    // The reader must notice a writer failure and stop instead of blocking
+    reset(image, IMAGE_SIZE);
+    write_fail_at = 8 * SECTOR_SIZE;
+    CHECK_EQ(ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, IMAGE_SIZE, NULL, &stats),
+             ESP_ERR_FLASH_BASE);
+    CHECK(net_pos < IMAGE_SIZE);
+
+    CHECK_EQ(ota_pipeline_run((esp_http_client_handle_t)1, 0, &partition, PARTITION_SIZE + 1, NULL, &stats),
+             ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(ota_pipeline_run(NULL, 0, &partition, IMAGE_SIZE, NULL, &stats), ESP_ERR_INVALID_ARG);
+}
+
+// The same work without the writer task: fill a buffer, then erase and write it inline
+static int64_t serial_baseline_us(const uint8_t *image)
+{
+    static char buf[SECTOR_SIZE];
+    reset(image, IMAGE_SIZE);
+    int64_t start = esp_timer_get_time();
+    uint32_t offset = 0;
+    while (offset < IMAGE_SIZE) {
+        int fill = 0;
+        int len;
+        while (fill < SECTOR_SIZE && (len = esp_http_client_read(NULL, buf + fill, SECTOR_SIZE - fill)) > 0) {
+            fill += len;
+        }
+        esp_partition_erase_range(&partition, offset, SECTOR_SIZE);
+        esp_ota_write_with_offset(0, buf, fill, offset);
+        offset += fill;
+    }
+    return esp_timer_get_time() - start;
+}
+
+int main(void)
+{
+    flash = tmpfile();
+    if (flash == NULL) {
+        perror("tmpfile");
+        return 1;
+    }
+    uint8_t *image = malloc(IMAGE_SIZE);
+    srand(27);
+    for (int i = 0; i < IMAGE_SIZE; i++) {
+        image[i] = rand();
+    }
+
+    ota_pipeline_stats_t stats;
+    test_full_image(image, &stats);
+    test_unknown_length(image);
+    test_errors(image);
+
+    // Throughput: flash work now hides behind the network instead of adding to it
+    int64_t serial_us = serial_baseline_us(image);
+    test_full_image(image, &stats);
+    printf("ota_pipeline: %d bytes, pipelined %lu ms (%lu KB/s; net %lu, write %lu, erase %lu, stalled %lu), "
+           "serial %lld ms (%lld KB/s)\n",
+           IMAGE_SIZE, (unsigned long)stats.total_ms,
+           (unsigned long)(IMAGE_SIZE / (stats.total_ms ? stats.total_ms : 1)),
+           (unsigned long)stats.net_ms, (unsigned long)stats.flash_write_ms,
+           (unsigned long)stats.flash_erase_ms, (unsigned long)stats.reader_stall_ms,
+           (long long)(serial_us / 1000), (long long)(IMAGE_SIZE * 1000LL / serial_us));
+    CHECK(stats.total_ms * 1000 < serial_us * 85 / 100);
+
+    free(image);
+    fclose(flash);
+    return check_result("ota_pipeline");
+}
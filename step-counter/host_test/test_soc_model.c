@@ -0,0 +1,163 @@
+#include "soc_model.h"
+#include "check.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void test_curve(void)
+{
+    CHECK_EQ(soc_model_lookup_milli(SOC_MODEL_FULL_MV + 100), 1000);
+    CHECK_EQ(soc_model_lookup_milli(SOC_MODEL_FULL_MV), 1000);
+    CHECK_EQ(soc_model_lookup_milli(SOC_MODEL_EMPTY_MV), 0);
+    CHECK_EQ(soc_model_lookup_milli(SOC_MODEL_EMPTY_MV - 300), 0);
+    CHECK_EQ(soc_model_lookup_milli(3840), 500);
+    CHECK_EQ(soc_model_lookup_milli(3845), 525);
+
+    // Never decreases with voltage
+    int prev = 0;
+    for (int32_t mv = SOC_MODEL_EMPTY_MV - 100; mv <= SOC_MODEL_FULL_MV + 100; mv++) {
+        int soc = soc_model_lookup_milli(mv);
+        CHECK(soc >= prev);
+        prev = soc;
+    }
+
+    // 100 mA through 150 mOhm is 15 mV of sag
+    CHECK_EQ(soc_model_ocv_mv(3700, 100000), 3700 + 100000 * SOC_MODEL_RINT_MOHM / 1000000);
+    CHECK_EQ(soc_model_ocv_mv(3700, 0), 3700);
+}
+
+static void test_filter(void)
+{
+    soc_model_t m;
+    soc_model_init(&m);
+
+    // The first sample is taken as-is, later ones move a quarter of the way
+    CHECK_EQ(soc_model_update(&m, 3840, 0), 500);
+    int soc = soc_model_update(&m, SOC_MODEL_FULL_MV, 0);
+    CHECK_EQ(soc, 500 + (1000 - 500) / (1 << SOC_MODEL_FILTER_SHIFT));
+    for (int i = 0; i < 64; i++) {
+        soc = soc_model_update(&m, SOC_MODEL_FULL_MV, 0);
+    }
+    CHECK_EQ(soc, 1000);
+}
+
+static void test_raw_filter(void)
+{
+    const int shift = 2;
+
+    // The first sample is taken as-is, later ones move a quarter of the way
+    int32_t q8 = soc_model_raw_filter_q8(-1, 2000, shift);
+    CHECK_EQ(q8, 2000 << 8);
+    q8 = soc_model_raw_filter_q8(q8, 2400, shift);
+    CHECK_EQ(q8, (2000 << 8) + (400 << 8) / 4);
+
+    // A step settles within a count: exactly from above, just under from below
+    for (int i = 0; i < 64; i++) {
+        q8 = soc_model_raw_filter_q8(q8, 4095, shift);
+    }
+    CHECK_RANGE(q8, (4095 << 8) - ((1 << shift) - 1), 4095 << 8);
+    for (int i = 0; i < 64; i++) {
+        q8 = soc_model_raw_filter_q8(q8, 0, shift);
+    }
+    CHECK_EQ(q8, 0);
+
+    // Noisy full-scale input tracks a floating-point EMA to within a count
+    double ref = -1;
+    q8 = -1;
+    srand(41);
+    for (int i = 0; i < 10000; i++) {
+        int sample = 3000 + rand() % 201 - 100;
+        q8 = soc_model_raw_filter_q8(q8, sample, shift);
+        ref = ref < 0 ? sample : ref + (sample - ref) / (1 << shift);
+        double err = q8 / 256.0 - ref;
+        CHECK(err > -1.0 && err < 1.0);
+    }
+}
+
+/*
+ * Replays a discharge log through the model. The SoC printed on each line
+ * is what the firmware computed, so matching it is only a change detector:
+ * it fails when the model changes, right or wrong. Accuracy is checked
+ * against the ref field, the simulated cell's coulomb-counted SoC written
+ * by data/gen_discharge.py, which does not share the model's curve or
+ * resistance. A bench capture without ref fields gets only the change
+ * detector and the shape checks: start full, end empty, move smoothly.
+ */
+
+// How far the model may stray from the coulomb-counted SoC, in tenths of a percent
+#define REF_MAX_ERR 150
+#define REF_MEAN_ERR 80
+static void test_discharge_log(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    CHECK(f != NULL);
+    if (f == NULL) {
+        return;
+    }
+
+    soc_model_t m;
+    soc_model_init(&m);
+    char line[256];
+    int samples = 0, first = -1, prev = -1, max_drop = 0, max_rise = 0;
+    int ref_samples = 0, ref_max_err = 0;
+    long ref_err_sum = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        const char *p = strstr(line, "Battery: ");
+        float volts;
+        int raw, logged_whole, logged_tenth;
+        unsigned load_ua;
+        if (p == NULL || sscanf(p, "Battery: %f V (raw %d), load %u uA, SoC %d.%d%%",
+                                &volts, &raw, &load_ua, &logged_whole, &logged_tenth) != 5) {
+            continue;
+        }
+        int soc = soc_model_update(&m, (int32_t)(volts * 1000.0f + 0.5f), load_ua);
+        // Change detector. The firmware truncates the float voltage, the log rounds it: allow that millivolt
+        CHECK_RANGE(soc, logged_whole * 10 + logged_tenth - 2, logged_whole * 10 + logged_tenth + 2);
+
+        const char *r = strstr(p, ", ref ");
+        int ref_whole, ref_tenth;
+        if (r != NULL && sscanf(r, ", ref %d.%d%%", &ref_whole, &ref_tenth) == 2) {
+            int err = abs(soc - (ref_whole * 10 + ref_tenth));
+            ref_max_err = err > ref_max_err ? err : ref_max_err;
+            ref_err_sum += err;
+            ref_samples++;
+        }
+
+        if (prev >= 0) {
+            max_drop = prev - soc > max_drop ? prev - soc : max_drop;
+            max_rise = soc - prev > max_rise ? soc - prev : max_rise;
+        } else {
+            first = soc;
+        }
+        prev = soc;
+        samples++;
+    }
+    fclose(f);
+
+    CHECK(samples >= 100);
+    CHECK_RANGE(first, 980, 1000);
+    CHECK_RANGE(prev, 0, 50);
+    // Load changes and ADC noise must not show up as jumps in the displayed percentage
+    CHECK_RANGE(max_drop, 0, 25);
+    CHECK_RANGE(max_rise, 0, 10);
+    printf("%d samples, %d.%d%% -> %d.%d%%, largest drop %d.%d%%, largest rise %d.%d%%\n", samples,
+           first / 10, first % 10, prev / 10, prev % 10, max_drop / 10, max_drop % 10, max_rise / 10, max_rise % 10);
+    if (ref_samples > 0) {
+        int ref_mean_err = (int)(ref_err_sum / ref_samples);
+        CHECK_RANGE(ref_max_err, 0, REF_MAX_ERR);
+        CHECK_RANGE(ref_mean_err, 0, REF_MEAN_ERR);
+        printf("against the coulomb-counted reference: mean error %d.%d%%, worst %d.%d%%\n",
+               ref_mean_err / 10, ref_mean_err % 10, ref_max_err / 10, ref_max_err % 10);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    test_curve();
+    test_filter();
+    test_raw_filter();
+    if (argc > 1) {
+        test_discharge_log(argv[1]);
+    }
+    return check_result("soc_model");
+}
@@ -0,0 +1,210 @@
+#include "step_history.h"
+#include "check.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MINUTE_MS (60 * 1000ULL)
+#define HOUR_MS (60 * MINUTE_MS)
+#define DAY_MS (24 * HOUR_MS)
+#define LOOP_MS 100                 // main.c feeds the history once per loop
+#define WEEK_MS (7 * DAY_MS)
+
+/*
+ * The module has no reset; every scenario starts a day past the previous
+ * one, which expires every bucket.
+ */
+static uint64_t base_ms = 0;
+
+static uint64_t fresh_start(void)
+{
+    base_ms += 2 * DAY_MS;
+    step_history_add(base_ms, 0);
+    CHECK_EQ(step_history_last_hour_total(), 0);
+    CHECK_EQ(step_history_last_day_total(), 0);
+    return base_ms;
+}
+
+// Bucket n places back from the newest (0 = current)
+static int minute_back(int n)
+{
+    uint16_t oldest;
+    const int16_t *ring = step_history_minutes(&oldest);
+    return ring[(oldest + STEP_HISTORY_MINUTES - 1 - n) % STEP_HISTORY_MINUTES];
+}
+
+static int hour_back(int n)
+{
+    uint16_t oldest;
+    const int16_t *ring = step_history_hours(&oldest);
+    return ring[(oldest + STEP_HISTORY_HOURS - 1 - n) % STEP_HISTORY_HOURS];
+}
+
+static void test_minute_rollover(void)
+{
+    uint64_t t = fresh_start();
+
+    step_history_add(t, 5);
+    step_history_add(t + MINUTE_MS - 1, 2);
+    CHECK_EQ(minute_back(0), 7);
+
+    step_history_add(t + MINUTE_MS, 3);
+    CHECK_EQ(minute_back(0), 3);
+    CHECK_EQ(minute_back(1), 7);
+    CHECK_EQ(step_history_last_hour_total(), 10);
+    CHECK_EQ(hour_back(0), 10);
+
+    // The first minute is in the window for 59 more minutes, then expires
+    step_history_add(t + 59 * MINUTE_MS, 0);
+    CHECK_EQ(step_history_last_hour_total(), 10);
+    CHECK_EQ(minute_back(59), 7);
+    step_history_add(t + 60 * MINUTE_MS, 0);
+    CHECK_EQ(step_history_last_hour_total(), 3);
+    step_history_add(t + 61 * MINUTE_MS, 0);
+    CHECK_EQ(step_history_last_hour_total(), 0);
+
+    // The day still has them all
+    CHECK_EQ(step_history_last_day_total(), 10);
+
+    // A gap longer than the ring clears it in one call
+    step_history_add(t + 61 * MINUTE_MS, 4);
+    step_history_add(t + 500 * MINUTE_MS, 0);
+    CHECK_EQ(step_history_last_hour_total(), 0);
+    for (int i = 0; i < STEP_HISTORY_MINUTES; i++) {
+        CHECK_EQ(minute_back(i), 0);
+    }
+}
+
+static void test_hour_rollover(void)
+{
+    uint64_t t = fresh_start();
+
+    for (int h = 0; h < STEP_HISTORY_HOURS; h++) {
+        step_history_add(t + h * HOUR_MS, 100 + h);
+    }
+    CHECK_EQ(hour_back(0), 100 + STEP_HISTORY_HOURS - 1);
+    CHECK_EQ(hour_back(STEP_HISTORY_HOURS - 1), 100);
+    CHECK_EQ(step_history_last_day_total(), STEP_HISTORY_HOURS * 100 + STEP_HISTORY_HOURS * (STEP_HISTORY_HOURS - 1) / 2);
+
+    // Hour 0 drops out when hour 24 starts
+    step_history_add(t + STEP_HISTORY_HOURS * HOUR_MS, 0);
+    CHECK_EQ(step_history_last_day_total(), (STEP_HISTORY_HOURS - 1) * 100 + STEP_HISTORY_HOURS * (STEP_HISTORY_HOURS - 1) / 2);
+    CHECK_EQ(hour_back(0), 0);
+}
+
+static void test_clamping(void)
+{
+    uint64_t t = fresh_start();
+
+    // Buckets saturate at INT16_MAX and the totals follow the saturated values
+    step_history_add(t, 40000);
+    CHECK_EQ(minute_back(0), INT16_MAX);
+    CHECK_EQ(hour_back(0), INT16_MAX);
+    CHECK_EQ(step_history_last_hour_total(), INT16_MAX);
+
+    step_history_add(t + 1000, 1);
+    CHECK_EQ(minute_back(0), INT16_MAX);
+    CHECK_EQ(step_history_last_hour_total(), INT16_MAX);
+
+    // The hour saturates on its own: two big minutes exceed it
+    step_history_add(t + MINUTE_MS, 30000);
+    CHECK_EQ(minute_back(0), 30000);
+    CHECK_EQ(hour_back(0), INT16_MAX);
+    CHECK_EQ(step_history_last_hour_total(), INT16_MAX + 30000);
+    CHECK_EQ(step_history_last_day_total(), INT16_MAX);
+
+    // A huge single add cannot wrap the int32 intermediate
+    step_history_add(t + 2 * MINUTE_MS, UINT32_MAX);
+    CHECK_EQ(minute_back(0), INT16_MAX);
+}
+
+static void test_version(void)
+{
+    uint64_t t = fresh_start();
+
+    uint32_t v = step_history_get_version();
+    step_history_add(t + 10, 0);
+    CHECK_EQ(step_history_get_version(), v);
+    step_history_add(t + 20, 1);
+    CHECK_EQ(step_history_get_version(), v + 1);
+    step_history_add(t + MINUTE_MS, 0);
+    CHECK_EQ(step_history_get_version(), v + 2);
+
+    // Time going backwards never rewinds the rings; steps land in the current bucket
+    step_history_add(t, 2);
+    CHECK_EQ(minute_back(0), 2);
+    CHECK_EQ(minute_back(1), 1);
+}
+
+/*
+ * A week of main-loop feeding with a walking pattern, checked every minute
+ * against totals recomputed from a plain per-minute log, and timed.
+ */
+static void test_week(void)
+{
+    uint64_t t0 = fresh_start() + HOUR_MS;
+    uint32_t minute_count = WEEK_MS / MINUTE_MS;
+    uint32_t *per_minute = calloc(minute_count, sizeof(uint32_t));
+    uint64_t calls = 0;
+    uint64_t mismatches = 0;
+    double total_ns = 0;
+    double max_ns = 0;
+
+    srand(35);
+    for (uint64_t ms = 0; ms < WEEK_MS; ms += LOOP_MS) {
+        uint64_t minute = ms / MINUTE_MS;
+        uint64_t hour_of_day = ms / HOUR_MS % 24;
+        // Awake 7-23h, walking about a fifth of the time at ~2 steps/s
+        bool awake = hour_of_day >= 7 && hour_of_day < 23;
+        bool walking = awake && (minute * 2654435761u >> 7) % 5 == 0;
+        uint32_t steps = walking && rand() % 5 == 0 ? 1 : 0;
+        per_minute[minute] += steps;
+
+        struct timespec a, b;
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        step_history_add(t0 + ms, steps);
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        double ns = (b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec);
+        total_ns += ns;
+        if (ns > max_ns) {
+            max_ns = ns;
+        }
+        calls++;
+
+        if ((ms + LOOP_MS) % MINUTE_MS == 0) {
+            uint32_t hour_sum = 0, day_sum = 0;
+            for (uint64_t m = minute + 1 > 60 ? minute + 1 - 60 : 0; m <= minute; m++) {
+                hour_sum += per_minute[m];
+            }
+            uint64_t hour = ms / HOUR_MS;
+            uint64_t first_hour = hour + 1 > 24 ? hour + 1 - 24 : 0;
+            for (uint64_t m = first_hour * 60; m <= minute; m++) {
+                day_sum += per_minute[m];
+            }
+            if (step_history_last_hour_total() != hour_sum || step_history_last_day_total() != day_sum) {
+                if (mismatches++ == 0) {
+                    fprintf(stderr, "minute %llu: hour %lu (expected %lu), day %lu (expected %lu)\n",
+                            (unsigned long long)minute, (unsigned long)step_history_last_hour_total(),
+                            (unsigned long)hour_sum, (unsigned long)step_history_last_day_total(),
+                            (unsigned long)day_sum);
+                }
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    printf("step_history: %llu calls over 7 days, avg %.1f ns, max %.0f ns\n",
+           (unsigned long long)calls, total_ns / calls, max_ns);
+    free(per_minute);
+}
+
+int main(void)
+{
+    test_minute_rollover();
+    test_hour_rollover();
+    test_clamping();
+    test_version();
+    test_week();
+    return check_result("step_history");
+}
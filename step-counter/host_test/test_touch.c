@@ -0,0 +1,138 @@
+#include "touch.h"
+#include "mock_touch.h"
+#include "check.h"
+
+/*
+ * touch.c against the mock controller: init cleanup on every failure step,
+ * the interrupt gating of reads, and the I2C read rate over a scripted
+ * minute of use. Built twice; test_touch_polled has TOUCH_POLLED=1.
+ */
+
+#define READ_PERIOD_MS 30   // CONFIG_LV_INDEV_DEF_READ_PERIOD
+#define SESSION_MS 60000
+
+static void test_init_cleanup(void)
+{
+    static const mock_touch_fail_t steps[] = {
+        MOCK_TOUCH_FAIL_BUS, MOCK_TOUCH_FAIL_IO, MOCK_TOUCH_FAIL_ISR, MOCK_TOUCH_FAIL_CONTROLLER,
+    };
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        mock_touch_reset(steps[i]);
+        CHECK(touch_init() == NULL);
+        CHECK_EQ(mock_touch_live_buses(), 0);
+        CHECK_EQ(mock_touch_live_ios(), 0);
+    }
+
+    // Without a controller nothing is read
+    uint16_t x, y;
+    bool pressed;
+    CHECK(!touch_read(&x, &y, &pressed));
+
+    mock_touch_reset(MOCK_TOUCH_FAIL_NONE);
+    CHECK(touch_init() != NULL);
+    CHECK_EQ(mock_touch_live_buses(), 1);
+    CHECK_EQ(mock_touch_live_ios(), 1);
+}
+
+static void test_tap(void)
+{
+    uint16_t x = 0, y = 0;
+    bool pressed = false;
+    uint32_t reads = mock_touch_reads();
+
+    mock_touch_press(120, 200);
+    CHECK(touch_has_pending());
+    CHECK(touch_read(&x, &y, &pressed));
+    CHECK(pressed);
+    CHECK_EQ(x, 120);
+    CHECK_EQ(y, 200);
+    CHECK(!touch_has_pending());
+
+    // Held: keep reading, there may be no further interrupt until the lift
+    CHECK(touch_read(&x, &y, &pressed));
+    CHECK(pressed);
+
+    mock_touch_release();
+    CHECK(touch_read(&x, &y, &pressed));
+    CHECK(!pressed);
+
+    CHECK_EQ(mock_touch_reads() - reads, 3);
+    CHECK_EQ(touch_get_read_count(), mock_touch_reads());
+
+    if (!TOUCH_POLLED) {
+        // Idle: no I2C traffic at all
+        CHECK(!touch_read(&x, &y, &pressed));
+        CHECK_EQ(mock_touch_reads() - reads, 3);
+    }
+}
+
+typedef struct {
+    uint32_t down_ms;
+    uint32_t up_ms;
+} touch_span_t;
+
+/*
+ * One minute with two taps and a 1.5 s swipe, read the way ui.c drives
+ * touch_read(): the LVGL input timer runs every READ_PERIOD_MS while the
+ * controller has something to report and is paused once it is released.
+ */
+static void test_read_rate(void)
+{
+    static const touch_span_t script[] = {
+        {5000, 5150}, {20000, 20200}, {40000, 41500},
+    };
+    uint32_t reads_before = touch_get_read_count();
+    uint32_t touched_ms = 0;
+    bool timer_running = TOUCH_POLLED;
+    size_t next = 0;
+
+    for (uint32_t t = 0; t < SESSION_MS; t++) {
+        if (next < sizeof(script) / sizeof(script[0])) {
+            const touch_span_t *span = &script[next];
+            if (t >= span->down_ms && t < span->up_ms) {
+                touched_ms++;
+                if (t == span->down_ms || t % 10 == 0) {
+                    mock_touch_press(100 + (t - span->down_ms) / 10, 160);
+                }
+            } else if (t == span->up_ms) {
+                mock_touch_release();
+                next++;
+            }
+        }
+
+        // lv_task resumes the read timer when the interrupt wakes it
+        if (touch_has_pending()) {
+            timer_running = true;
+        }
+        if (timer_running && t % READ_PERIOD_MS == 0) {
+            uint16_t x, y;
+            bool pressed = false;
+            bool read = touch_read(&x, &y, &pressed);
+            if (!TOUCH_POLLED && !(read && pressed) && !touch_has_pending()) {
+                timer_running = false;
+            }
+        }
+    }
+
+    uint32_t reads = touch_get_read_count() - reads_before;
+    printf("touch (%s): %lu I2C reads in %d ms (%lu.%lu/s), touched %lu ms\n",
+           TOUCH_POLLED ? "polled" : "interrupt", (unsigned long)reads, SESSION_MS,
+           (unsigned long)(reads * 1000 / SESSION_MS), (unsigned long)(reads * 10000 / SESSION_MS % 10),
+           (unsigned long)touched_ms);
+
+    if (TOUCH_POLLED) {
+        CHECK_EQ(reads, SESSION_MS / READ_PERIOD_MS);
+    } else {
+        // One read per period while touched, plus the press and the release read per touch
+        CHECK(reads <= touched_ms / READ_PERIOD_MS + 2 * sizeof(script) / sizeof(script[0]));
+        CHECK(reads >= touched_ms / READ_PERIOD_MS);
+    }
+}
+
+int main(void)
+{
+    test_init_cleanup();
+    test_tap();
+    test_read_rate();
+    return check_result(TOUCH_POLLED ? "touch_polled" : "touch");
+}
@@ -0,0 +1,113 @@
+#include "alloc_trace.h"
+
+#if ALLOC_TRACE_ENABLED
+#include "esp_log.h"
+#include "esp_heap_trace.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "alloc_trace";
+
+#define ALLOC_TRACE_RECORDS 300
+#define ALLOC_TRACE_SITES 24
+#define ALLOC_TRACE_REPORT_SITES 8
+
+typedef struct {
+    void *callers[2];
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t live;
+} alloc_site_t;
+
+static heap_trace_record_t records[ALLOC_TRACE_RECORDS];
+static alloc_site_t sites[ALLOC_TRACE_SITES];
+static bool initialized = false;
+static bool tracing = false;
+static uint64_t window_start_ms = 0;
+static uint64_t next_window_ms = ALLOC_TRACE_WINDOW_MS;  // First window shortly after boot
+
+static void *caller(const heap_trace_record_t *r, int depth)
+{
+    return depth < CONFIG_HEAP_TRACING_STACK_DEPTH ? r->alloced_by[depth] : NULL;
+}
+
+static void report(uint32_t window_ms)
+{
+    size_t count = heap_trace_get_count();
+    int site_count = 0;
+    uint32_t untracked = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        heap_trace_record_t r;
+        if (heap_trace_get(i, &r) != ESP_OK) {
+            continue;
+        }
+        int s = 0;
+        while (s < site_count && (sites[s].callers[0] != caller(&r, 0) || sites[s].callers[1] != caller(&r, 1))) {
+            s++;
+        }
+        if (s == site_count) {
+            if (site_count == ALLOC_TRACE_SITES) {
+                untracked++;
+                continue;
+            }
+            sites[s] = (alloc_site_t){{caller(&r, 0), caller(&r, 1)}, 0, 0, 0};
+            site_count++;
+        }
+        sites[s].count++;
+        sites[s].bytes += r.size;
+        sites[s].live += r.freed_by[0] == NULL;
+    }
+
+    // Busiest first; the table is tiny so a selection sort is fine
+    for (int i = 0; i < site_count; i++) {
+        for (int j = i + 1; j < site_count; j++) {
+            if (sites[j].count > sites[i].count) {
+                alloc_site_t tmp = sites[i];
+                sites[i] = sites[j];
+                sites[j] = tmp;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "%u allocations in %lu ms from %d sites%s", (unsigned)count, (unsigned long)window_ms,
+             site_count, count >= ALLOC_TRACE_RECORDS ? " (buffer full)" : "");
+    for (int i = 0; i < site_count && i < ALLOC_TRACE_REPORT_SITES; i++) {
+        ESP_LOGI(TAG, "  %p <- %p: %lu allocs, %lu bytes, %lu live", sites[i].callers[0], sites[i].callers[1],
+                 (unsigned long)sites[i].count, (unsigned long)sites[i].bytes, (unsigned long)sites[i].live);
+    }
+    if (untracked > 0) {
+        ESP_LOGI(TAG, "  %lu allocations from other sites", (unsigned long)untracked);
+    }
+    ESP_LOGI(TAG, "Heap: %u free, largest block %u", (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+void alloc_trace_init(void)
+{
+    if (heap_trace_init_standalone(records, ALLOC_TRACE_RECORDS) != ESP_OK) {
+        ESP_LOGW(TAG, "Heap trace buffer setup failed");
+        return;
+    }
+    initialized = true;
+}
+
+void alloc_trace_poll(uint64_t now_ms)
+{
+    if (!initialized || ALLOC_TRACE_INTERVAL_MS == 0) {
+        return;
+    }
+
+    if (!tracing && now_ms >= next_window_ms) {
+        if (heap_trace_start(HEAP_TRACE_ALL) == ESP_OK) {
+            tracing = true;
+            window_start_ms = now_ms;
+        }
+        next_window_ms = now_ms + ALLOC_TRACE_INTERVAL_MS;
+    } else if (tracing && now_ms - window_start_ms >= ALLOC_TRACE_WINDOW_MS) {
+        heap_trace_stop();
+        tracing = false;
+        report((uint32_t)(now_ms - window_start_ms));
+    }
+}
+
+#endif // ALLOC_TRACE_ENABLED
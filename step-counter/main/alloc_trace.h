@@ -0,0 +1,45 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+/*
+ * Only built with CONFIG_HEAP_TRACING_STANDALONE, which the release sdkconfig
+ * leaves off: build with the sdkconfig.heap_trace overlay to enable it.
+ * Callers guard their calls with ALLOC_TRACE_ENABLED.
+ */
+#ifdef CONFIG_HEAP_TRACING_STANDALONE
+#define ALLOC_TRACE_ENABLED 1
+#else
+#define ALLOC_TRACE_ENABLED 0
+#endif
+
+/** How often a trace window is opened (0 = never) */
+#ifndef ALLOC_TRACE_INTERVAL_MS
+#define ALLOC_TRACE_INTERVAL_MS (30 * 60 * 1000)
+#endif
+
+/** How long each window records allocations */
+#ifndef ALLOC_TRACE_WINDOW_MS
+#define ALLOC_TRACE_WINDOW_MS (60 * 1000)
+#endif
+
+/**
+ * @brief Set up the trace buffer
+ */
+void alloc_trace_init(void);
+
+/**
+ * @brief Open and close trace windows on schedule; call from the main loop
+ *
+ * When a window closes, allocations are grouped by call site (the two
+ * innermost callers of malloc) and the busiest sites are logged with their
+ * counts, bytes and how many are still live. idf.py monitor decodes the
+ * addresses.
+ *
+ * @param now_ms Current time
+ */
+void alloc_trace_poll(uint64_t now_ms);
+
+#endif // ALLOC_TRACE_H
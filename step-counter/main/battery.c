@@ -1,37 +1,131 @@
 #include "battery.h"
+#include "soc_model.h"
+#include "task_placement.h"
 #include "esp_log.h"
-#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
 
 #define BAT_ADC_CHANNEL ADC_CHANNEL_4
 #define BAT_ADC_ATTEN ADC_ATTEN_DB_12
 #define BAT_ADC_UNIT ADC_UNIT_1
-#define BAT_ADC_SAMPLES 8
 #define BAT_VOLTAGE_DIVIDER_FACTOR 3.0f
-#define BAT_V_EMPTY_MV 3000
-#define BAT_V_FULL_MV 4200
+
+// Continuous-mode sampling: one DMA frame per burst, one burst per period
+#define BAT_SAMPLE_FREQ_HZ SOC_ADC_SAMPLE_FREQ_THRES_LOW
+#define BAT_FRAME_SAMPLES 64
+#define BAT_FRAME_BYTES (BAT_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+#define BAT_BURST_PERIOD_MS 1000
+#define BAT_BURST_TIMEOUT_MS 500
+
+// Exponential moving average over bursts: each burst moves the estimate by 1/2^shift
+#define BAT_FILTER_SHIFT 2
 
 static const char *TAG = "battery";
-static adc_oneshot_unit_handle_t adc1_handle = NULL;
+static adc_continuous_handle_t adc_handle = NULL;
 static adc_cali_handle_t adc1_cali_chan_handle = NULL;
 static bool do_calibration = false;
+static TaskHandle_t sampler_task = NULL;
+static SemaphoreHandle_t first_sample = NULL;
 
-void battery_init(void)
+// Latest filtered reading, published by the sampler task
+static portMUX_TYPE reading_lock = portMUX_INITIALIZER_UNLOCKED;
+static int32_t filtered_raw_q8 = -1;  // Raw ADC counts in Q24.8, -1 until the first burst
+static float filtered_voltage_v = 0.0f;
+
+// Filtered state of charge, only touched from the caller of battery_soc_milli()
+static soc_model_t soc_filter = {0};
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
 {
-  adc_oneshot_unit_init_cfg_t init_config = {
-      .unit_id = BAT_ADC_UNIT,
-  };
-  ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config, &adc1_handle));
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(sampler_task, &woken);
+  return woken == pdTRUE;
+}
 
-  adc_oneshot_chan_cfg_t config = {
-      .bitwidth = ADC_BITWIDTH_DEFAULT,
-      .atten = BAT_ADC_ATTEN,
-  };
-  ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, BAT_ADC_CHANNEL, &config));
+static float raw_to_voltage(int raw)
+{
+  if (do_calibration)
+  {
+    int voltage_mv = 0;
+    if (adc_cali_raw_to_voltage(adc1_cali_chan_handle, raw, &voltage_mv) == ESP_OK)
+      return (voltage_mv * BAT_VOLTAGE_DIVIDER_FACTOR) / 1000.0f;
+  }
+  // Fallback: estimate assuming 12-bit ADC and 3.3V reference
+  return (raw * (3.3f / 4095.0f)) * BAT_VOLTAGE_DIVIDER_FACTOR;
+}
+
+// Average the samples for our channel in one DMA frame; returns -1 if there were none
+static int frame_average(const uint8_t *frame, uint32_t len)
+{
+  int32_t sum = 0;
+  int count = 0;
+  for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES)
+  {
+    const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&frame[i];
+    if (p->type2.channel == BAT_ADC_CHANNEL)
+    {
+      sum += p->type2.data;
+      count++;
+    }
+  }
+  return count > 0 ? (int)(sum / count) : -1;
+}
+
+static void sampler(void *arg)
+{
+  static uint8_t frame[BAT_FRAME_BYTES];
+
+  while (1)
+  {
+    // Sample in short bursts so the ADC and its DMA are idle most of the time
+    adc_continuous_flush_pool(adc_handle);
+    ulTaskNotifyTake(pdTRUE, 0);
+    esp_err_t err = adc_continuous_start(adc_handle);
+    if (err != ESP_OK)
+    {
+      // Skip this burst; the reading just ages until the ADC comes back
+      ESP_LOGW(TAG, "ADC start failed: %s, retrying", esp_err_to_name(err));
+      vTaskDelay(pdMS_TO_TICKS(BAT_BURST_PERIOD_MS));
+      continue;
+    }
+
+    uint32_t len = 0;
+    err = ESP_ERR_TIMEOUT;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BAT_BURST_TIMEOUT_MS)) > 0)
+      err = adc_continuous_read(adc_handle, frame, sizeof(frame), &len, 0);
+    adc_continuous_stop(adc_handle);
+
+    int avg = err == ESP_OK ? frame_average(frame, len) : -1;
+    if (avg >= 0)
+    {
+      int32_t prev = filtered_raw_q8;
+      int32_t next = soc_model_raw_filter_q8(prev, avg, BAT_FILTER_SHIFT);
+      float voltage = raw_to_voltage(next >> 8);
+
+      portENTER_CRITICAL(&reading_lock);
+      filtered_raw_q8 = next;
+      filtered_voltage_v = voltage;
+      portEXIT_CRITICAL(&reading_lock);
+
+      if (prev < 0)
+        xSemaphoreGive(first_sample);
+    }
+    else
+    {
+      ESP_LOGW(TAG, "Battery burst failed: %s", esp_err_to_name(err));
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(BAT_BURST_PERIOD_MS));
+  }
+}
 
+static void init_calibration(void)
+{
 #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
   {
     adc_cali_curve_fitting_config_t cali_config = {
@@ -69,38 +163,64 @@ void battery_init(void)
   ESP_LOGW(TAG, "ADC calibration: not available, using raw estimate");
 }
 
-void read_battery(float *voltage_v, int *adc_raw_avg)
+void battery_init(void)
 {
-  long sum_raw = 0;
-  for (int i = 0; i < BAT_ADC_SAMPLES; ++i)
-  {
-    int raw = 0;
-    ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, BAT_ADC_CHANNEL, &raw));
-    sum_raw += raw;
-    vTaskDelay(pdMS_TO_TICKS(5));
-  }
-  int avg_raw = (int)(sum_raw / BAT_ADC_SAMPLES);
-  *adc_raw_avg = avg_raw;
+  adc_continuous_handle_cfg_t handle_config = {
+      .max_store_buf_size = BAT_FRAME_BYTES * 2,
+      .conv_frame_size = BAT_FRAME_BYTES,
+  };
+  ESP_ERROR_CHECK(adc_continuous_new_handle(&handle_config, &adc_handle));
 
-  if (do_calibration)
-  {
-    int voltage_mv = 0;
-    ESP_ERROR_CHECK(adc_cali_raw_to_voltage(adc1_cali_chan_handle, avg_raw, &voltage_mv));
-    float bat_v = (voltage_mv * BAT_VOLTAGE_DIVIDER_FACTOR) / 1000.0f;
-    *voltage_v = bat_v;
-  }
-  else
+  adc_digi_pattern_config_t pattern = {
+      .atten = BAT_ADC_ATTEN,
+      .channel = BAT_ADC_CHANNEL,
+      .unit = BAT_ADC_UNIT,
+      .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+  };
+  adc_continuous_config_t config = {
+      .sample_freq_hz = BAT_SAMPLE_FREQ_HZ,
+      .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+      .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+      .pattern_num = 1,
+      .adc_pattern = &pattern,
+  };
+  ESP_ERROR_CHECK(adc_continuous_config(adc_handle, &config));
+
+  adc_continuous_evt_cbs_t cbs = {
+      .on_conv_done = on_conv_done,
+  };
+  ESP_ERROR_CHECK(adc_continuous_register_event_callbacks(adc_handle, &cbs, NULL));
+
+  init_calibration();
+
+  first_sample = xSemaphoreCreateBinary();
+  if (task_placement_create(sampler, "battery", 3072, NULL, TASK_ROLE_BACKGROUND, &sampler_task) != pdPASS)
   {
-    // Fallback: estimate assuming 12-bit ADC and 3.3V reference
-    float v = (avg_raw * (3.3f / 4095.0f)) * BAT_VOLTAGE_DIVIDER_FACTOR;
-    *voltage_v = v;
+    ESP_LOGE(TAG, "Failed to create the battery sampler");
+    return;
   }
+
+  // Callers expect a valid reading as soon as init returns
+  if (xSemaphoreTake(first_sample, pdMS_TO_TICKS(BAT_BURST_TIMEOUT_MS)) != pdTRUE)
+    ESP_LOGW(TAG, "No battery reading yet");
 }
 
-int estimate_percentage_milli(float mv)
+void read_battery(float *voltage_v, int *adc_raw_avg)
+{
+  portENTER_CRITICAL(&reading_lock);
+  int32_t raw_q8 = filtered_raw_q8;
+  float voltage = filtered_voltage_v;
+  portEXIT_CRITICAL(&reading_lock);
+
+  *adc_raw_avg = raw_q8 < 0 ? 0 : (int)(raw_q8 >> 8);
+  *voltage_v = voltage;
+}
+
+// The original linear estimate, kept as the benchmark baseline
+static int linear_percentage_milli(float mv)
 {
-  int min = BAT_V_EMPTY_MV;
-  int max = BAT_V_FULL_MV;
+  int min = SOC_MODEL_EMPTY_MV;
+  int max = SOC_MODEL_FULL_MV;
   int mv_i = (int)(mv * 1000.0f);
   if (mv_i <= min)
     return 0;
@@ -109,3 +229,39 @@ int estimate_percentage_milli(float mv)
   float p = (float)(mv_i - min) / (float)(max - min);
   return (int)(p * 1000.0f);
 }
+
+int estimate_percentage_milli(float mv)
+{
+  return soc_model_lookup_milli((int32_t)(mv * 1000.0f));
+}
+
+int battery_soc_milli(float voltage_v, uint32_t load_ua)
+{
+  return soc_model_update(&soc_filter, (int32_t)(voltage_v * 1000.0f), load_ua);
+}
+
+void battery_benchmark_soc(int iterations)
+{
+  if (iterations <= 0)
+    return;
+
+  volatile int sink = 0;
+  soc_model_t bench_filter;
+  soc_model_init(&bench_filter);
+
+  // Sweep the whole curve so every table segment is exercised
+  const int span_mv = SOC_MODEL_FULL_MV - SOC_MODEL_EMPTY_MV;
+  uint32_t start = esp_cpu_get_cycle_count();
+  for (int i = 0; i < iterations; i++)
+    sink = linear_percentage_milli((SOC_MODEL_EMPTY_MV + i % span_mv) / 1000.0f);
+  uint32_t linear_cycles = esp_cpu_get_cycle_count() - start;
+
+  start = esp_cpu_get_cycle_count();
+  for (int i = 0; i < iterations; i++)
+    sink = soc_model_update(&bench_filter, SOC_MODEL_EMPTY_MV + i % span_mv, 100000);
+  uint32_t model_cycles = esp_cpu_get_cycle_count() - start;
+
+  (void)sink;
+  ESP_LOGI(TAG, "SoC benchmark over %d calls: float linear %lu cycles/call, integer curve+filter %lu cycles/call",
+           iterations, (unsigned long)(linear_cycles / iterations), (unsigned long)(model_cycles / iterations));
+}
@@ -1,25 +1,56 @@
 #ifndef BATTERY_H
 #define BATTERY_H
 
+#include <stdint.h>
+
 /**
  * @brief Initialize battery monitoring
+ *
+ * Sets up ADC continuous (DMA) mode and starts a background task that
+ * samples the battery in short bursts and keeps a filtered voltage ready.
+ * Waits briefly for the first burst so read_battery() has a value.
  */
 void battery_init(void);
 
 /**
- * @brief Read battery voltage and raw ADC value
+ * @brief Get the latest filtered battery voltage and raw ADC value
+ *
+ * Constant time: returns what the background sampler last published and
+ * never touches the ADC.
  *
  * @param voltage_v Output: battery voltage in volts
- * @param adc_raw_avg Output: average raw ADC value
+ * @param adc_raw_avg Output: filtered raw ADC value
  */
 void read_battery(float *voltage_v, int *adc_raw_avg);
 
 /**
  * @brief Estimate battery percentage from voltage
  *
- * @param mv Voltage in millivolts
+ * Unfiltered lookup on the discharge curve, treating the reading as the
+ * resting voltage. Use battery_soc_milli() for readings taken under load.
+ *
+ * @param mv Voltage in volts
  * @return Battery percentage in thousandths (e.g., 952 = 95.2%)
  */
 int estimate_percentage_milli(float mv);
 
+/**
+ * @brief Filtered, load-compensated state of charge
+ *
+ * Adds back the sag caused by load_ua, looks the result up on the
+ * discharge curve and smooths it across calls. Call from one task only.
+ *
+ * @param voltage_v Battery voltage in volts
+ * @param load_ua Current being drawn when the reading was taken
+ * @return State of charge in thousandths
+ */
+int battery_soc_milli(float voltage_v, uint32_t load_ua);
+
+/**
+ * @brief Log the cycle cost of the SoC model against the old float estimate
+ *
+ * @param iterations Calls to time for each version
+ */
+void battery_benchmark_soc(int iterations);
+
 #endif // BATTERY_H
@@ -0,0 +1,202 @@
+#include "binlog.h"
+#include "task_placement.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "binlog";
+
+// 1 = the drain task prints formatted text, 0 = it prints "#BL" hex frames for serial_monitor.py
+#ifndef BINLOG_FORMAT_ON_DEVICE
+#define BINLOG_FORMAT_ON_DEVICE 0
+#endif
+
+#define BINLOG_RING_RECORDS 128   // Power of two
+#define BINLOG_DRAIN_PERIOD_MS 200
+#define BINLOG_DRAIN_STACK 3072
+#define BINLOG_MAGIC 0x42494e4c   // "BINL"
+
+typedef struct {
+    _Atomic uint32_t seq;       // Write index + 1 once the record is complete, 0 while being written
+    uint32_t time_ms;
+    uint16_t id;
+    uint16_t nargs;
+    uint32_t args[BINLOG_MAX_ARGS];
+} binlog_record_t;
+
+typedef struct {
+    uint32_t magic;
+    _Atomic uint32_t write_idx;
+    uint32_t read_idx;
+    binlog_record_t records[BINLOG_RING_RECORDS];
+} binlog_ring_t;
+
+// Not cleared on reset, so the last records before a crash can be dumped on the next boot
+static NOINIT_ATTR binlog_ring_t ring;
+
+static const char *const formats[BINLOG_MSG_COUNT] = {
+#define BINLOG_MSG(id, fmt) [id] = fmt,
+#include "binlog_msgs.h"
+#undef BINLOG_MSG
+};
+
+static uint32_t dropped = 0;
+static bool ring_ready = false;
+
+void IRAM_ATTR binlog_write(binlog_msg_t id, const uint32_t *args, uint32_t nargs)
+{
+    if (!ring_ready) {
+        return;
+    }
+
+    uint32_t idx = atomic_fetch_add_explicit(&ring.write_idx, 1, memory_order_relaxed);
+    binlog_record_t *r = &ring.records[idx % BINLOG_RING_RECORDS];
+
+    atomic_store_explicit(&r->seq, 0, memory_order_relaxed);
+    r->time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    r->id = (uint16_t)id;
+    r->nargs = (uint16_t)(nargs > BINLOG_MAX_ARGS ? BINLOG_MAX_ARGS : nargs);
+    for (uint32_t i = 0; i < r->nargs; i++) {
+        r->args[i] = args[i];
+    }
+    atomic_store_explicit(&r->seq, idx + 1, memory_order_release);
+}
+
+static void emit(const binlog_record_t *r)
+{
+#if BINLOG_FORMAT_ON_DEVICE
+    char text[128];
+    const char *fmt = r->id < BINLOG_MSG_COUNT ? formats[r->id] : "unknown message %u";
+    // Unused trailing arguments are ignored by snprintf
+    snprintf(text, sizeof(text), fmt, r->args[0], r->args[1], r->args[2], r->args[3]);
+    printf("B (%lu) %s: %s\n", (unsigned long)r->time_ms, TAG, text);
+#else
+    printf("#BL %lx %x", (unsigned long)r->time_ms, (unsigned)r->id);
+    for (int i = 0; i < r->nargs; i++) {
+        printf(" %lx", (unsigned long)r->args[i]);
+    }
+    printf("\n");
+#endif
+}
+
+// Copy the record at idx if it is complete; false if it is still being written or was overwritten
+static bool read_record(uint32_t idx, binlog_record_t *out)
+{
+    const binlog_record_t *r = &ring.records[idx % BINLOG_RING_RECORDS];
+    if (atomic_load_explicit(&r->seq, memory_order_acquire) != idx + 1) {
+        return false;
+    }
+    out->time_ms = r->time_ms;
+    out->id = r->id;
+    out->nargs = r->nargs > BINLOG_MAX_ARGS ? BINLOG_MAX_ARGS : r->nargs;
+    memcpy(out->args, r->args, sizeof(out->args));
+    // A writer that lapped us while copying would have changed seq
+    return atomic_load_explicit(&r->seq, memory_order_acquire) == idx + 1;
+}
+
+static void drain(void)
+{
+    uint32_t write_idx = atomic_load_explicit(&ring.write_idx, memory_order_acquire);
+    if (write_idx - ring.read_idx > BINLOG_RING_RECORDS) {
+        dropped += write_idx - ring.read_idx - BINLOG_RING_RECORDS;
+        ring.read_idx = write_idx - BINLOG_RING_RECORDS;
+    }
+
+    while (ring.read_idx != write_idx) {
+        binlog_record_t r;
+        if (!read_record(ring.read_idx, &r)) {
+            const binlog_record_t *slot = &ring.records[ring.read_idx % BINLOG_RING_RECORDS];
+            uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+            // 0, or an older lap's seq: the writer has claimed the slot but not
+            // cleared it yet. Only a newer lap means the record was overwritten
+            if (seq == 0 || (int32_t)(seq - (ring.read_idx + 1)) < 0) {
+                break;  // Writer still busy; try again next period
+            }
+            dropped++;  // Overwritten before we got to it
+        } else {
+            emit(&r);
+        }
+        ring.read_idx++;
+    }
+}
+
+static void drain_task(void *arg)
+{
+    while (1) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(BINLOG_DRAIN_PERIOD_MS));
+    }
+}
+
+// Print what the previous boot left in the ring if it died unexpectedly
+static void dump_after_crash(void)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool crashed = reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+                   reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT;
+    if (ring.magic != BINLOG_MAGIC || !crashed) {
+        return;
+    }
+
+    uint32_t end = atomic_load(&ring.write_idx);
+    uint32_t start = end > BINLOG_RING_RECORDS ? end - BINLOG_RING_RECORDS : 0;
+    printf("#BL-DUMP begin (reset reason %d)\n", (int)reason);
+    for (uint32_t idx = start; idx != end; idx++) {
+        binlog_record_t r;
+        if (read_record(idx, &r)) {
+            emit(&r);
+        }
+    }
+    printf("#BL-DUMP end\n");
+}
+
+esp_err_t binlog_init(void)
+{
+    dump_after_crash();
+
+    memset(&ring, 0, sizeof(ring));
+    ring.magic = BINLOG_MAGIC;
+    ring_ready = true;
+
+    if (task_placement_create(drain_task, "binlog", BINLOG_DRAIN_STACK, NULL, TASK_ROLE_BACKGROUND, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create drain task");
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Binary log ready (%u records, %s)", BINLOG_RING_RECORDS,
+             BINLOG_FORMAT_ON_DEVICE ? "formatted on device" : "decoded by serial_monitor.py");
+    return ESP_OK;
+}
+
+uint32_t binlog_get_dropped(void)
+{
+    return dropped;
+}
+
+void binlog_benchmark(int iterations)
+{
+    if (iterations <= 0) {
+        return;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iterations; i++) {
+        BINLOG(BL_BENCH, i, iterations);
+    }
+    uint32_t binlog_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < iterations; i++) {
+        ESP_LOGI(TAG, "Benchmark call %d of %d", i, iterations);
+    }
+    uint32_t logi_cycles = esp_cpu_get_cycle_count() - start;
+
+    ESP_LOGI(TAG, "Per-call cost over %d calls: BINLOG %lu cycles, ESP_LOGI %lu cycles",
+             iterations, (unsigned long)(binlog_cycles / iterations), (unsigned long)(logi_cycles / iterations));
+}
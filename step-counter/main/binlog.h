@@ -0,0 +1,60 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Binary log message ids, generated from binlog_msgs.h
+ */
+typedef enum {
+#define BINLOG_MSG(id, fmt) id,
+#include "binlog_msgs.h"
+#undef BINLOG_MSG
+    BINLOG_MSG_COUNT
+} binlog_msg_t;
+
+/** Arguments kept per record; extra arguments are dropped */
+#define BINLOG_MAX_ARGS 4
+
+/**
+ * @brief Log a message id and up to BINLOG_MAX_ARGS integer arguments
+ *
+ * Costs one atomic increment and a 28-byte copy into a RAM ring; the text
+ * is produced later by the drain task or by serial_monitor.py. Safe from
+ * ISRs and any task.
+ *
+ *   BINLOG(BL_STEP_SENT, remaining);
+ */
+#define BINLOG(id, ...)                                                          \
+    binlog_write((id), (const uint32_t[]){0, __VA_ARGS__} + 1,                 \
+                 sizeof((const uint32_t[]){0, __VA_ARGS__}) / sizeof(uint32_t) - 1)
+
+/**
+ * @brief Store one record; use the BINLOG() macro instead
+ */
+void binlog_write(binlog_msg_t id, const uint32_t *args, uint32_t nargs);
+
+/**
+ * @brief Set up the ring and start the low-priority drain task
+ *
+ * If the previous boot ended in a panic or watchdog reset, whatever was
+ * still in the ring is dumped to the console first.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t binlog_init(void);
+
+/**
+ * @brief Records lost because the ring overflowed before being drained
+ */
+uint32_t binlog_get_dropped(void);
+
+/**
+ * @brief Log the per-call cycle cost of BINLOG() against ESP_LOGI
+ *
+ * @param iterations Calls to time for each (the ESP_LOGI half prints them all)
+ */
+void binlog_benchmark(int iterations);
+
+#endif // BINLOG_H
@@ -0,0 +1,16 @@
+/*
+ * Binary log message table: BINLOG_MSG(id, format)
+ *
+ * Included several times with different BINLOG_MSG definitions, so no
+ * include guard. Formats may only use integer conversions (%d %u %x %c,
+ * with optional l/h length modifiers), since every argument is stored as a
+ * raw 32-bit word. serial_monitor.py parses this file to decode frames, so
+ * keep one entry per line. Only append new entries: ids are positions.
+ */
+BINLOG_MSG(BL_BENCH, "Benchmark call %u of %u")
+BINLOG_MSG(BL_STEP_SENT, "Step sent, %u remaining in buffer")
+BINLOG_MSG(BL_WS_SENT, "WebSocket sent %d bytes")
+BINLOG_MSG(BL_STEPS_FLUSHED, "Sent %d buffered step(s)")
+BINLOG_MSG(BL_POWER_TIMERS, "WiFi in: %ds, Display in: %ds, Steps: %lu, Buffered: %d")
+BINLOG_MSG(BL_STEP_EDGE, "Step edge at %u us, level %d")
+BINLOG_MSG(BL_STEP_ACCEPTED, "Step accepted at %u us")
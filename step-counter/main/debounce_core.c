@@ -0,0 +1,202 @@
+#include "debounce_core.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+// Called from the GPIO ISR and an ISR-dispatched timer
+#define DEBOUNCE_IRAM IRAM_ATTR
+#else
+#define DEBOUNCE_IRAM
+#endif
+
+void debounce_init(debounce_t *d, uint32_t window_us)
+{
+    d->stable = -1;
+    d->pending = -1;
+    d->window_us = window_us;
+    d->deadline_us = 0;
+}
+
+debounce_action_t DEBOUNCE_IRAM debounce_edge(debounce_t *d, int level, uint64_t now_us)
+{
+    // The first edge only tells us where the pin rests
+    if (d->stable < 0) {
+        d->stable = level;
+        return DEBOUNCE_NONE;
+    }
+
+    // Bounced back before the window ran out
+    if (level == d->stable) {
+        if (d->pending < 0) {
+            return DEBOUNCE_NONE;
+        }
+        d->pending = -1;
+        return DEBOUNCE_CANCEL;
+    }
+
+    // New level: the window restarts from this edge
+    if (level != d->pending) {
+        d->pending = level;
+        d->deadline_us = now_us + d->window_us;
+        return DEBOUNCE_ARM;
+    }
+    return DEBOUNCE_NONE;
+}
+
+bool DEBOUNCE_IRAM debounce_expire(debounce_t *d, int level)
+{
+    bool accepted = d->pending >= 0 && level == d->pending && level != d->stable;
+    if (accepted) {
+        d->stable = level;
+    }
+    d->pending = -1;
+    return accepted;
+}
+
+#ifdef DEBOUNCE_CORE_HOST
+/*
+ * Host replay: reads edge traces from stdin and prints the steps the
+ * debouncer accepts. Two line formats are understood:
+ *
+ *   <t_us> <level>                 hand-written or scope-exported edges
+ *   ... Step edge at <t_us> us, level <level>
+ *   ... Step accepted at <t_us> us
+ *
+ * The last two are the binary log lines step_counter.c prints when built
+ * with STEP_EDGE_TRACE=1 (decoded by serial_monitor.py). When the trace
+ * contains the device's acceptances, each is matched to the ideal deadline
+ * the model computes and the timer lateness is summarised. Override the
+ * window with -DDEBOUNCE_WINDOW_US=...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#ifndef DEBOUNCE_WINDOW_US
+#define DEBOUNCE_WINDOW_US 80000
+#endif
+#define MAX_STEPS 4096
+
+// Device timestamps are 32-bit microseconds and wrap every ~71 minutes
+static uint64_t unwrap(uint64_t *last, uint64_t t, bool wrapped)
+{
+    if (wrapped) {
+        uint64_t hi = *last & ~(uint64_t)UINT32_MAX;
+        t |= hi;
+        if (t < *last) {
+            t += (uint64_t)1 << 32;
+        }
+    }
+    *last = t;
+    return t;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(void)
+{
+    static uint64_t ideal[MAX_STEPS];
+    static uint64_t device[MAX_STEPS];
+    int n_ideal = 0, n_device = 0, edges = 0;
+    debounce_t d;
+    debounce_init(&d, DEBOUNCE_WINDOW_US);
+    bool armed = false;
+    int level = -1;
+    uint64_t last_t = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        const char *p;
+        unsigned long long t;
+        int lvl;
+        bool is_edge = false;
+
+        if ((p = strstr(line, "Step edge at ")) != NULL &&
+            sscanf(p, "Step edge at %llu us, level %d", &t, &lvl) == 2) {
+            t = unwrap(&last_t, t, true);
+            is_edge = true;
+        } else if ((p = strstr(line, "Step accepted at ")) != NULL &&
+                   sscanf(p, "Step accepted at %llu us", &t) == 1) {
+            if (n_device < MAX_STEPS) {
+                device[n_device++] = unwrap(&last_t, t, true);
+            }
+            continue;
+        } else if (sscanf(line, "%llu %d", &t, &lvl) == 2) {
+            last_t = t;
+            is_edge = true;
+        }
+        if (!is_edge) {
+            continue;
+        }
+
+        // Fire the timer if it would have expired before this edge
+        if (armed && d.deadline_us <= t) {
+            armed = false;
+            if (debounce_expire(&d, level) && n_ideal < MAX_STEPS) {
+                ideal[n_ideal++] = d.deadline_us;
+            }
+        }
+
+        level = lvl;
+        edges++;
+        switch (debounce_edge(&d, lvl, t)) {
+        case DEBOUNCE_ARM:
+            armed = true;
+            break;
+        case DEBOUNCE_CANCEL:
+            armed = false;
+            break;
+        default:
+            break;
+        }
+    }
+    if (armed && debounce_expire(&d, level) && n_ideal < MAX_STEPS) {
+        ideal[n_ideal++] = d.deadline_us;
+    }
+
+    if (edges == 0) {
+        fprintf(stderr, "no edges on stdin\n");
+        return 1;
+    }
+
+    printf("%d edges, %d steps accepted (window %u us)\n", edges, n_ideal, (unsigned)DEBOUNCE_WINDOW_US);
+    if (n_device == 0) {
+        for (int i = 0; i < n_ideal; i++) {
+            printf("  step %d at %" PRIu64 " us\n", i + 1, ideal[i]);
+        }
+        return 0;
+    }
+
+    // Pair each device acceptance with the earliest unmatched ideal deadline before it
+    static uint64_t late[MAX_STEPS];
+    int n_late = 0, extra = 0, i = 0;
+    for (int j = 0; j < n_device; j++) {
+        while (i + 1 < n_ideal && ideal[i + 1] <= device[j]) {
+            i++;  // Skipped ideal steps are counted as missed below
+        }
+        if (i < n_ideal && ideal[i] <= device[j]) {
+            late[n_late++] = device[j] - ideal[i];
+            i++;
+        } else {
+            extra++;
+        }
+    }
+    int missed = n_ideal - n_late;
+
+    printf("device accepted %d: %d matched, %d missed, %d extra\n", n_device, n_late, missed, extra);
+    if (n_late > 0) {
+        uint64_t sum = 0;
+        for (int k = 0; k < n_late; k++) {
+            sum += late[k];
+        }
+        qsort(late, n_late, sizeof(late[0]), cmp_u64);
+        printf("timer lateness us: min %" PRIu64 " avg %" PRIu64 " p50 %" PRIu64 " p99 %" PRIu64 " max %" PRIu64 "\n",
+               late[0], sum / n_late, late[n_late / 2], late[(n_late * 99) / 100], late[n_late - 1]);
+    }
+    return missed == 0 && extra == 0 ? 0 : 2;
+}
+#endif
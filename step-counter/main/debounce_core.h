@@ -0,0 +1,66 @@
+#ifndef DEBOUNCE_CORE_H
+#define DEBOUNCE_CORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Step input debouncer: a level change is accepted once the pin has held
+ * the new level for a full window. The core only decides; the caller owns
+ * the timer and the pin. Plain C, so recorded edge traces can be replayed
+ * on a host:
+ *
+ *   gcc -DDEBOUNCE_CORE_HOST -o debounce_replay main/debounce_core.c
+ *   ./debounce_replay < edges.txt
+ *
+ * host_test/test_debounce_core.c checks the decisions; the harness also
+ * runs the replay over the sample trace in host_test/data/step_edges.log.
+ */
+
+/**
+ * @brief What the caller should do with its one-shot timer after an edge
+ */
+typedef enum {
+    DEBOUNCE_NONE = 0,   ///< Leave the timer as it is
+    DEBOUNCE_ARM,        ///< (Re)start the timer to fire at deadline_us
+    DEBOUNCE_CANCEL,     ///< Stop the timer; the pin went back to the stable level
+} debounce_action_t;
+
+/**
+ * @brief Debouncer state
+ */
+typedef struct {
+    int stable;              ///< Last accepted level, -1 until the first edge
+    int pending;             ///< Level being timed, -1 if none
+    uint32_t window_us;      ///< How long a new level must hold
+    uint64_t deadline_us;    ///< When the pending level will be accepted
+} debounce_t;
+
+/**
+ * @brief Reset the debouncer
+ *
+ * @param d State
+ * @param window_us Stability window
+ */
+void debounce_init(debounce_t *d, uint32_t window_us);
+
+/**
+ * @brief Feed an edge interrupt
+ *
+ * @param d State
+ * @param level Pin level read in the interrupt
+ * @param now_us Time of the edge
+ * @return Timer action; for DEBOUNCE_ARM the deadline is in d->deadline_us
+ */
+debounce_action_t debounce_edge(debounce_t *d, int level, uint64_t now_us);
+
+/**
+ * @brief Handle the timer firing
+ *
+ * @param d State
+ * @param level Pin level read when the timer fired
+ * @return true if a new stable level was accepted (one step)
+ */
+bool debounce_expire(debounce_t *d, int level);
+
+#endif // DEBOUNCE_CORE_H
@@ -0,0 +1,203 @@
+#include "digit_counter.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DIGIT_COUNTER_MAX_DIGITS 10
+
+static const char *TAG = "digit_counter";
+
+// One pre-rasterised digit: the glyph's bounding box, already blended to RGB565
+typedef struct {
+  lv_color_t *pixels;
+  int16_t box_w;
+  int16_t box_h;
+  int16_t ofs_x;   // Offset of the box from the cell's left edge
+  int16_t top;     // Offset of the box from the line's top edge
+} digit_glyph_t;
+
+static lv_obj_t *counter_obj = NULL;
+static const lv_font_t *counter_font = NULL;
+static lv_color_t *atlas = NULL;
+static digit_glyph_t glyphs[10];
+
+// Currently displayed layout: characters and their cell x offsets within the object
+static char shown_text[DIGIT_COUNTER_MAX_DIGITS + 1];
+static int16_t shown_x[DIGIT_COUNTER_MAX_DIGITS];
+static int16_t shown_w[DIGIT_COUNTER_MAX_DIGITS];
+static int shown_len = 0;
+
+static uint8_t glyph_alpha(const uint8_t *bitmap, uint8_t bpp, uint32_t index)
+{
+  uint32_t bit = index * bpp;
+  uint8_t mask = (1 << bpp) - 1;
+  uint8_t shift = 8 - bpp - (bit & 7);
+  uint8_t val = (bitmap[bit >> 3] >> shift) & mask;
+  return (uint8_t)((val * 255) / mask);
+}
+
+static bool build_atlas(const lv_font_t *font, lv_color_t fg, lv_color_t bg)
+{
+  lv_font_glyph_dsc_t dsc[10];
+  size_t total_px = 0;
+
+  for (int d = 0; d < 10; d++)
+  {
+    if (!lv_font_get_glyph_dsc(font, &dsc[d], '0' + d, 0))
+      return false;
+    // Compressed or unusual formats go through the regular label path
+    if (dsc[d].bpp != 1 && dsc[d].bpp != 2 && dsc[d].bpp != 4 && dsc[d].bpp != 8)
+      return false;
+    total_px += dsc[d].box_w * dsc[d].box_h;
+  }
+
+  atlas = heap_caps_malloc(total_px * sizeof(lv_color_t), MALLOC_CAP_8BIT);
+  if (atlas == NULL)
+    return false;
+
+  lv_color_t *next = atlas;
+  for (int d = 0; d < 10; d++)
+  {
+    const uint8_t *bitmap = lv_font_get_glyph_bitmap(font, '0' + d);
+    digit_glyph_t *g = &glyphs[d];
+    g->pixels = next;
+    g->box_w = dsc[d].box_w;
+    g->box_h = dsc[d].box_h;
+    g->ofs_x = dsc[d].ofs_x;
+    // Same vertical placement as lv_draw_letter
+    g->top = (font->line_height - font->base_line) - dsc[d].box_h - dsc[d].ofs_y;
+
+    uint32_t n = g->box_w * g->box_h;
+    for (uint32_t i = 0; i < n; i++)
+      g->pixels[i] = lv_color_mix(fg, bg, bitmap ? glyph_alpha(bitmap, dsc[d].bpp, i) : 0);
+    next += n;
+  }
+
+  ESP_LOGI(TAG, "Digit atlas built: %u bytes", (unsigned)(total_px * sizeof(lv_color_t)));
+  return true;
+}
+
+static void blit_glyph(lv_draw_ctx_t *draw_ctx, const digit_glyph_t *g, lv_coord_t x, lv_coord_t y)
+{
+  lv_area_t glyph_area = {x, y, x + g->box_w - 1, y + g->box_h - 1};
+  lv_area_t clipped;
+  if (!_lv_area_intersect(&clipped, &glyph_area, draw_ctx->clip_area))
+    return;
+
+  const lv_area_t *buf_area = draw_ctx->buf_area;
+  lv_coord_t buf_w = lv_area_get_width(buf_area);
+  lv_color_t *buf = (lv_color_t *)draw_ctx->buf;
+  lv_coord_t copy_w = lv_area_get_width(&clipped);
+
+  for (lv_coord_t row = clipped.y1; row <= clipped.y2; row++)
+  {
+    const lv_color_t *src = g->pixels + (row - y) * g->box_w + (clipped.x1 - x);
+    lv_color_t *dst = buf + (row - buf_area->y1) * buf_w + (clipped.x1 - buf_area->x1);
+    memcpy(dst, src, copy_w * sizeof(lv_color_t));
+  }
+}
+
+static void counter_event_cb(lv_event_t *e)
+{
+  lv_event_code_t code = lv_event_get_code(e);
+
+  if (code == LV_EVENT_DRAW_MAIN)
+  {
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_area_t coords;
+    lv_obj_get_coords(counter_obj, &coords);
+    for (int i = 0; i < shown_len; i++)
+    {
+      const digit_glyph_t *g = &glyphs[shown_text[i] - '0'];
+      blit_glyph(draw_ctx, g, coords.x1 + shown_x[i] + g->ofs_x, coords.y1 + g->top);
+    }
+  }
+  else if (code == LV_EVENT_DELETE)
+  {
+    heap_caps_free(atlas);
+    atlas = NULL;
+    counter_obj = NULL;
+    shown_len = 0;
+  }
+}
+
+static void invalidate_cell(lv_coord_t x, lv_coord_t w)
+{
+  lv_area_t coords;
+  lv_obj_get_coords(counter_obj, &coords);
+  lv_area_t cell = {coords.x1 + x, coords.y1, coords.x1 + x + w - 1, coords.y2};
+  lv_obj_invalidate_area(counter_obj, &cell);
+}
+
+lv_obj_t *digit_counter_create(lv_obj_t *parent, const lv_font_t *font)
+{
+  if (counter_obj != NULL)
+    return NULL;
+
+  lv_color_t fg = lv_obj_get_style_text_color(parent, LV_PART_MAIN);
+  lv_color_t bg = lv_obj_get_style_bg_color(parent, LV_PART_MAIN);
+  if (!build_atlas(font, fg, bg))
+  {
+    ESP_LOGW(TAG, "Could not build digit atlas");
+    heap_caps_free(atlas);
+    atlas = NULL;
+    return NULL;
+  }
+
+  counter_font = font;
+  counter_obj = lv_obj_create(parent);
+  lv_obj_remove_style_all(counter_obj);
+  lv_obj_set_size(counter_obj, lv_pct(100), font->line_height);
+  lv_obj_clear_flag(counter_obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_add_event_cb(counter_obj, counter_event_cb, LV_EVENT_ALL, NULL);
+  shown_len = 0;
+
+  return counter_obj;
+}
+
+void digit_counter_set_value(uint32_t value)
+{
+  if (counter_obj == NULL)
+    return;
+
+  char text[DIGIT_COUNTER_MAX_DIGITS + 1];
+  int len = snprintf(text, sizeof(text), "%lu", (unsigned long)value);
+
+  // Lay the digits out exactly as a centred label would, kerning included
+  int16_t adv[DIGIT_COUNTER_MAX_DIGITS];
+  int16_t x[DIGIT_COUNTER_MAX_DIGITS];
+  lv_coord_t total_w = 0;
+  for (int i = 0; i < len; i++)
+  {
+    adv[i] = lv_font_get_glyph_width(counter_font, text[i], i + 1 < len ? text[i + 1] : 0);
+    total_w += adv[i];
+  }
+
+  lv_obj_update_layout(counter_obj);
+  lv_coord_t start = (lv_obj_get_width(counter_obj) - total_w) / 2;
+  for (int i = 0; i < len; i++)
+  {
+    x[i] = start;
+    start += adv[i];
+  }
+
+  // Only cells whose digit or position changed need redrawing
+  int cells = len > shown_len ? len : shown_len;
+  for (int i = 0; i < cells; i++)
+  {
+    bool in_old = i < shown_len;
+    bool in_new = i < len;
+    if (in_old && in_new && shown_text[i] == text[i] && shown_x[i] == x[i])
+      continue;
+    if (in_old)
+      invalidate_cell(shown_x[i], shown_w[i]);
+    if (in_new)
+      invalidate_cell(x[i], adv[i]);
+  }
+
+  memcpy(shown_text, text, len + 1);
+  memcpy(shown_x, x, len * sizeof(int16_t));
+  memcpy(shown_w, adv, len * sizeof(int16_t));
+  shown_len = len;
+}
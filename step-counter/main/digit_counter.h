@@ -0,0 +1,32 @@
+#ifndef DIGIT_COUNTER_H
+#define DIGIT_COUNTER_H
+
+#include <stdint.h>
+#include "lvgl.h"
+
+/**
+ * @brief Create the large step counter widget
+ *
+ * Pre-rasterises '0'-'9' from the given font into an RGB565 atlas, blended
+ * against the parent's background and text colours, and returns an object
+ * that draws the count by copying atlas glyphs straight into the LVGL draw
+ * buffer. Only digit cells whose character or position changed are
+ * invalidated on update. Only one counter may exist at a time; the atlas
+ * is freed when the object is deleted.
+ *
+ * @param parent Parent object (its bg and text colours are sampled)
+ * @param font Font to rasterise the digits from
+ * @return The counter object, or NULL if the atlas could not be allocated
+ */
+lv_obj_t *digit_counter_create(lv_obj_t *parent, const lv_font_t *font);
+
+/**
+ * @brief Set the displayed value
+ *
+ * Must be called with the LVGL lock held.
+ *
+ * @param value Value to display
+ */
+void digit_counter_set_value(uint32_t value);
+
+#endif // DIGIT_COUNTER_H
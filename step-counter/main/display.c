@@ -5,11 +5,10 @@
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
+#include "esp_timer.h"
 
 /* Display configuration */
 #define LCD_PIXEL_CLOCK_HZ (80 * 1000 * 1000)
-#define LCD_H_RES 240
-#define LCD_V_RES 320
 #define LCD_PIN_DC 42
 #define LCD_PIN_RST -1
 #define LCD_PIN_CS 45
@@ -20,15 +19,57 @@
 #define SPI_PIN_MISO 40
 #define SPI_HOST SPI2_HOST
 
+/* GPSPI moves at most 2^18 bits per transaction (SPI_LL_DATA_MAX_BIT_LEN on the S3) */
+#define SPI_MAX_TRANSACTION_BYTES ((1 << 18) / 8)
+_Static_assert(LCD_DRAW_BUF_PIXELS * sizeof(uint16_t) <= SPI_MAX_TRANSACTION_BYTES,
+               "an LVGL draw band must fit in one SPI transaction");
+
 /* Backlight configuration */
 #define BK_LIGHT_PIN 1
 
 static const char *TAG = "display";
 
+static display_power_t power;
+static esp_lcd_panel_io_color_trans_done_cb_t trans_done_cb = NULL;
+
+static esp_err_t panel_on_off(void *ctx, bool on)
+{
+  return esp_lcd_panel_disp_on_off((esp_lcd_panel_handle_t)ctx, on);
+}
+
+static esp_err_t panel_sleep(void *ctx, bool sleep)
+{
+  return esp_lcd_panel_disp_sleep((esp_lcd_panel_handle_t)ctx, sleep);
+}
+
+static void backlight(void *ctx, bool on)
+{
+  (void)ctx;
+  if (on) {
+    display_backlight_on();
+  } else {
+    display_backlight_off();
+  }
+}
+
+static display_power_ops_t panel_ops = {
+  .disp_on_off = panel_on_off,
+  .disp_sleep = panel_sleep,
+  .backlight = backlight,
+};
+
+static bool display_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+  esp_lcd_panel_io_color_trans_done_cb_t cb = trans_done_cb;
+  return cb != NULL ? cb(panel_io, edata, user_ctx) : false;
+}
+
 esp_lcd_panel_handle_t display_init(esp_lcd_panel_io_color_trans_done_cb_t on_color_trans_done)
 {
   ESP_LOGI(TAG, "Initializing display hardware");
 
+  trans_done_cb = on_color_trans_done;
+
   // Backlight PWM
   ledc_timer_config_t ledc_timer = {
       .speed_mode = LEDC_LOW_SPEED_MODE,
@@ -57,7 +98,7 @@ esp_lcd_panel_handle_t display_init(esp_lcd_panel_io_color_trans_done_cb_t on_co
       .miso_io_num = SPI_PIN_MISO,
       .quadwp_io_num = -1,
       .quadhd_io_num = -1,
-      .max_transfer_sz = LCD_H_RES * 40 * sizeof(uint16_t),
+      .max_transfer_sz = LCD_DRAW_BUF_PIXELS * sizeof(uint16_t),
   };
   ESP_ERROR_CHECK(spi_bus_initialize(SPI_HOST, &buscfg, SPI_DMA_CH_AUTO));
 
@@ -71,7 +112,7 @@ esp_lcd_panel_handle_t display_init(esp_lcd_panel_io_color_trans_done_cb_t on_co
       .lcd_param_bits = 8,
       .spi_mode = 0,
       .trans_queue_depth = 10,
-      .on_color_trans_done = on_color_trans_done,
+      .on_color_trans_done = display_trans_done,
   };
   ESP_ERROR_CHECK(esp_lcd_new_panel_io_spi((esp_lcd_spi_bus_handle_t)SPI_HOST, &io_config, &io_handle));
 
@@ -90,6 +131,9 @@ esp_lcd_panel_handle_t display_init(esp_lcd_panel_io_color_trans_done_cb_t on_co
   ESP_ERROR_CHECK(esp_lcd_panel_disp_on_off(panel_handle, true));
   ESP_ERROR_CHECK(esp_lcd_panel_invert_color(panel_handle, true));
 
+  panel_ops.ctx = panel_handle;
+  display_power_init(&power, &panel_ops);
+
   ESP_LOGI(TAG, "Display hardware initialized");
   return panel_handle;
 }
@@ -114,3 +158,53 @@ void display_backlight_off(void)
 {
   display_set_backlight(0);
 }
+
+esp_err_t display_sleep(void)
+{
+  bool was_asleep = power.state == DISPLAY_POWER_SLEEP;
+  esp_err_t err = display_power_sleep(&power);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to put panel to sleep: %s", esp_err_to_name(err));
+  } else if (!was_asleep) {
+    ESP_LOGI(TAG, "Panel asleep");
+  }
+  return err;
+}
+
+esp_err_t display_wake_begin(void)
+{
+  esp_err_t err = display_power_wake_begin(&power, esp_timer_get_time());
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to wake panel: %s", esp_err_to_name(err));
+  }
+  return err;
+}
+
+esp_err_t display_wake_finish(void)
+{
+  bool was_waking = power.state == DISPLAY_POWER_WAKING;
+  esp_err_t err = display_power_wake_finish(&power, esp_timer_get_time());
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to turn display on: %s", esp_err_to_name(err));
+  } else if (was_waking) {
+    ESP_LOGI(TAG, "Panel awake, wake-to-visible %lu us", (unsigned long)power.last_wake_latency_us);
+  }
+  return err;
+}
+
+display_power_state_t display_get_power_state(void)
+{
+  return power.state;
+}
+
+uint32_t display_get_last_wake_latency_us(void)
+{
+  return power.last_wake_latency_us;
+}
+
+esp_lcd_panel_io_color_trans_done_cb_t display_set_color_trans_done_cb(esp_lcd_panel_io_color_trans_done_cb_t cb)
+{
+  esp_lcd_panel_io_color_trans_done_cb_t prev = trans_done_cb;
+  trans_done_cb = cb;
+  return prev;
+}
@@ -3,6 +3,20 @@
 
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_io.h"
+#include "display_power.h"
+
+/* Panel resolution */
+#define LCD_H_RES 240
+#define LCD_V_RES 320
+
+/*
+ * Height of each LVGL draw band; the SPI transfer size is sized to match.
+ * 64 lines (30720 B) is the most that fits one 32 KB SPI transaction.
+ */
+#ifndef LCD_DRAW_BUF_LINES
+#define LCD_DRAW_BUF_LINES 64
+#endif
+#define LCD_DRAW_BUF_PIXELS (LCD_H_RES * LCD_DRAW_BUF_LINES)
 
 /**
  * @brief Initialize display hardware (LCD panel, SPI, backlight)
@@ -29,4 +43,54 @@ void display_backlight_on(void);
  */
 void display_backlight_off(void);
 
+/**
+ * @brief Put the panel to sleep
+ *
+ * Turns the backlight off, blanks the display and sends the ST7789 into
+ * sleep mode. The caller must stop flushing to the panel first.
+ *
+ * @return ESP_OK on success (or if already asleep), error code otherwise
+ */
+esp_err_t display_sleep(void);
+
+/**
+ * @brief Bring the panel out of sleep mode, keeping it dark
+ *
+ * The panel is ready to accept pixel data when this returns; call
+ * display_wake_finish() once the frame has been redrawn.
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t display_wake_begin(void);
+
+/**
+ * @brief Turn the display and backlight on after a wake
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t display_wake_finish(void);
+
+/**
+ * @brief Get the current display power state
+ */
+display_power_state_t display_get_power_state(void);
+
+/**
+ * @brief Get the time from the last display_wake_begin() to visible output
+ *
+ * @return Latency in microseconds, 0 if the panel has not been woken yet
+ */
+uint32_t display_get_last_wake_latency_us(void);
+
+/**
+ * @brief Redirect DMA completion notifications to another consumer
+ *
+ * Lets code that pushes pixels without LVGL (the glance renderer) wait for
+ * its own transfers. Only one consumer may be drawing at a time.
+ *
+ * @param cb New callback, invoked from ISR context
+ * @return The previous callback, to be restored afterwards
+ */
+esp_lcd_panel_io_color_trans_done_cb_t display_set_color_trans_done_cb(esp_lcd_panel_io_color_trans_done_cb_t cb);
+
 #endif // DISPLAY_H
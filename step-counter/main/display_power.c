@@ -0,0 +1,71 @@
+#include "display_power.h"
+#include <stddef.h>
+
+void display_power_init(display_power_t *dp, const display_power_ops_t *ops)
+{
+  dp->ops = ops;
+  dp->state = DISPLAY_POWER_ON;
+  dp->wake_start_us = 0;
+  dp->last_wake_latency_us = 0;
+}
+
+esp_err_t display_power_sleep(display_power_t *dp)
+{
+  if (dp->ops == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (dp->state == DISPLAY_POWER_SLEEP) {
+    return ESP_OK;
+  }
+
+  dp->ops->backlight(dp->ops->ctx, false);
+  esp_err_t err = dp->ops->disp_on_off(dp->ops->ctx, false);
+  if (err == ESP_OK) {
+    err = dp->ops->disp_sleep(dp->ops->ctx, true);
+  }
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  dp->state = DISPLAY_POWER_SLEEP;
+  return ESP_OK;
+}
+
+esp_err_t display_power_wake_begin(display_power_t *dp, int64_t now_us)
+{
+  if (dp->ops == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (dp->state != DISPLAY_POWER_SLEEP) {
+    return ESP_OK;
+  }
+
+  dp->wake_start_us = now_us;
+  esp_err_t err = dp->ops->disp_sleep(dp->ops->ctx, false);
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  dp->state = DISPLAY_POWER_WAKING;
+  return ESP_OK;
+}
+
+esp_err_t display_power_wake_finish(display_power_t *dp, int64_t now_us)
+{
+  if (dp->ops == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (dp->state != DISPLAY_POWER_WAKING) {
+    return ESP_OK;
+  }
+
+  esp_err_t err = dp->ops->disp_on_off(dp->ops->ctx, true);
+  if (err != ESP_OK) {
+    return err;
+  }
+  dp->ops->backlight(dp->ops->ctx, true);
+
+  dp->state = DISPLAY_POWER_ON;
+  dp->last_wake_latency_us = (uint32_t)(now_us - dp->wake_start_us);
+  return ESP_OK;
+}
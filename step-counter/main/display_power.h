@@ -0,0 +1,72 @@
+#ifndef DISPLAY_POWER_H
+#define DISPLAY_POWER_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Panel power state machine. It only sequences the panel and backlight
+ * operations it is given, so display.c hands it the esp_lcd and LEDC calls
+ * and host_test/test_display_power.c hands it recording mocks.
+ */
+
+/**
+ * @brief Display power state
+ */
+typedef enum {
+    DISPLAY_POWER_ON = 0,   ///< Panel awake, display on, backlight lit
+    DISPLAY_POWER_SLEEP,    ///< Backlight off, display off, panel in sleep mode
+    DISPLAY_POWER_WAKING    ///< Panel awake but dark while the last frame is restored
+} display_power_state_t;
+
+/**
+ * @brief Panel and backlight operations
+ */
+typedef struct {
+    esp_err_t (*disp_on_off)(void *ctx, bool on);        ///< DISPON / DISPOFF
+    esp_err_t (*disp_sleep)(void *ctx, bool sleep);      ///< SLPIN / SLPOUT
+    void (*backlight)(void *ctx, bool on);
+    void *ctx;
+} display_power_ops_t;
+
+/**
+ * @brief State machine instance
+ */
+typedef struct {
+    const display_power_ops_t *ops;   ///< NULL until a panel is attached
+    display_power_state_t state;
+    int64_t wake_start_us;
+    uint32_t last_wake_latency_us;    ///< 0 until the first wake completes
+} display_power_t;
+
+/**
+ * @brief Attach the panel operations; the panel is assumed to be on
+ */
+void display_power_init(display_power_t *dp, const display_power_ops_t *ops);
+
+/**
+ * @brief Backlight off, display off, then panel sleep
+ *
+ * @return ESP_OK (also when already asleep), ESP_ERR_INVALID_STATE without
+ *         a panel, or the failing operation's error with the state unchanged
+ */
+esp_err_t display_power_sleep(display_power_t *dp);
+
+/**
+ * @brief Take the panel out of sleep mode, keeping display and backlight off
+ *
+ * @param now_us Start of the wake, for the latency
+ * @return ESP_OK (also when not asleep), or an error as display_power_sleep()
+ */
+esp_err_t display_power_wake_begin(display_power_t *dp, int64_t now_us);
+
+/**
+ * @brief Display on, then backlight on, after display_power_wake_begin()
+ *
+ * @param now_us Time the frame is visible, for the latency
+ * @return ESP_OK (also when not waking), or an error as display_power_sleep()
+ */
+esp_err_t display_power_wake_finish(display_power_t *dp, int64_t now_us);
+
+#endif // DISPLAY_POWER_H
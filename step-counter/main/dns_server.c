@@ -0,0 +1,189 @@
+#include "dns_server.h"
+#include "task_placement.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include <errno.h>
+#include <string.h>
+
+static const char *TAG = "dns_server";
+
+#define DNS_PORT 53
+#define DNS_MAX_PACKET 512
+#define DNS_TASK_STACK 4096
+#define DNS_ANSWER_TTL_S 60
+
+#define DNS_HEADER_SIZE 12
+#define DNS_ANSWER_SIZE 16      // Name pointer, type, class, TTL, length, IPv4 address
+#define DNS_FLAG_QR 0x8000
+#define DNS_FLAG_OPCODE 0x7800
+#define DNS_FLAG_AA 0x0400
+#define DNS_FLAG_RD 0x0100
+#define DNS_FLAG_RA 0x0080
+#define DNS_RCODE_NOTIMP 4
+#define DNS_TYPE_A 1
+#define DNS_CLASS_IN 1
+
+static TaskHandle_t dns_task = NULL;
+static int dns_socket = -1;
+static uint32_t portal_ip = 0;
+static dns_server_stats_t stats = {0};
+
+static uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void write_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+// Length of the encoded name starting at p, or -1 if it is malformed or compressed
+static int question_name_length(const uint8_t *p, int available)
+{
+    int pos = 0;
+    while (pos < available) {
+        uint8_t label = p[pos];
+        if (label == 0) {
+            return pos + 1;
+        }
+        if (label & 0xc0) {
+            return -1;  // Pointers never appear in a query's first question
+        }
+        pos += label + 1;
+    }
+    return -1;
+}
+
+/**
+ * Turn the query in buf into a response in place.
+ * Returns the response length, or 0 if the packet should be ignored.
+ */
+static int build_response(uint8_t *buf, int len)
+{
+    if (len < DNS_HEADER_SIZE) {
+        return 0;
+    }
+
+    uint16_t flags = read_u16(buf + 2);
+    uint16_t qdcount = read_u16(buf + 4);
+    if (flags & DNS_FLAG_QR) {
+        return 0;  // Not a query
+    }
+
+    uint16_t reply_flags = DNS_FLAG_QR | DNS_FLAG_AA | DNS_FLAG_RA | (flags & DNS_FLAG_RD);
+    if ((flags & DNS_FLAG_OPCODE) != 0 || qdcount != 1) {
+        // Only standard single-question queries are answered. The reply is the
+        // bare header, so every count (QDCOUNT included) must be zero
+        write_u16(buf + 2, reply_flags | (flags & DNS_FLAG_OPCODE) | DNS_RCODE_NOTIMP);
+        memset(buf + 4, 0, 8);
+        return DNS_HEADER_SIZE;
+    }
+
+    int name_len = question_name_length(buf + DNS_HEADER_SIZE, len - DNS_HEADER_SIZE);
+    int question_end = DNS_HEADER_SIZE + name_len + 4;
+    if (name_len < 0 || question_end > len) {
+        return 0;
+    }
+    uint16_t qtype = read_u16(buf + DNS_HEADER_SIZE + name_len);
+    uint16_t qclass = read_u16(buf + DNS_HEADER_SIZE + name_len + 2);
+
+    // Drop anything after the question (EDNS OPT records and the like)
+    write_u16(buf + 2, reply_flags);
+    write_u16(buf + 6, 0);    // ANCOUNT
+    write_u16(buf + 8, 0);    // NSCOUNT
+    write_u16(buf + 10, 0);   // ARCOUNT
+
+    if (qtype != DNS_TYPE_A || qclass != DNS_CLASS_IN || question_end + DNS_ANSWER_SIZE > DNS_MAX_PACKET) {
+        return question_end;  // No records: the name exists but has no address of that type
+    }
+
+    uint8_t *answer = buf + question_end;
+    write_u16(answer, 0xc000 | DNS_HEADER_SIZE);  // Pointer back to the question name
+    write_u16(answer + 2, DNS_TYPE_A);
+    write_u16(answer + 4, DNS_CLASS_IN);
+    write_u16(answer + 6, 0);
+    write_u16(answer + 8, DNS_ANSWER_TTL_S);
+    write_u16(answer + 10, 4);
+    memcpy(answer + 12, &portal_ip, 4);
+    write_u16(buf + 6, 1);
+    return question_end + DNS_ANSWER_SIZE;
+}
+
+static void dns_server_task(void *arg)
+{
+    uint8_t buf[DNS_MAX_PACKET];
+
+    while (1) {
+        struct sockaddr_in client;
+        socklen_t client_len = sizeof(client);
+        int len = recvfrom(dns_socket, buf, sizeof(buf), 0, (struct sockaddr *)&client, &client_len);
+        if (len < 0) {
+            ESP_LOGW(TAG, "recvfrom failed: errno %d", errno);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+
+        if (stats.queries++ == 0) {
+            stats.first_query_us = esp_timer_get_time();
+        }
+
+        int reply_len = build_response(buf, len);
+        if (reply_len == 0) {
+            continue;
+        }
+        if (read_u16(buf + 6) > 0) {
+            stats.answered++;
+        }
+        sendto(dns_socket, buf, reply_len, 0, (struct sockaddr *)&client, client_len);
+    }
+}
+
+esp_err_t dns_server_start(uint32_t ip_addr)
+{
+    if (dns_task != NULL) {
+        return ESP_OK;
+    }
+
+    dns_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (dns_socket < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(DNS_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(dns_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "Failed to bind port %d: errno %d", DNS_PORT, errno);
+        close(dns_socket);
+        dns_socket = -1;
+        return ESP_FAIL;
+    }
+
+    portal_ip = ip_addr;
+    if (task_placement_create(dns_server_task, "dns_server", DNS_TASK_STACK, NULL,
+                              TASK_ROLE_NET, &dns_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create DNS task");
+        close(dns_socket);
+        dns_socket = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Answering all DNS queries with " IPSTR, IP2STR((esp_ip4_addr_t *)&portal_ip));
+    return ESP_OK;
+}
+
+void dns_server_get_stats(dns_server_stats_t *out)
+{
+    if (out != NULL) {
+        *out = stats;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef DNS_SERVER_H
+#define DNS_SERVER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Captive portal DNS counters
+ */
+typedef struct {
+    uint32_t queries;         ///< Queries received
+    uint32_t answered;        ///< Queries answered with the portal address
+    int64_t first_query_us;   ///< esp_timer time of the first query, 0 if none yet
+} dns_server_stats_t;
+
+/**
+ * @brief Start a DNS responder that resolves every A query to ip_addr
+ *
+ * Phones probe a known host after joining a network; answering every name
+ * with the AP address sends those probes to our HTTP server, which is what
+ * makes the OS pop up the captive portal. AAAA and other query types get an
+ * empty answer so clients fall back to IPv4.
+ *
+ * There is no stop: the portal runs until saving credentials restarts the
+ * device. Calling this again while it runs is a no-op.
+ *
+ * portal_client.py at the repository root exercises it, and the portal's
+ * HTTP caching, from a Linux machine joined to the AP.
+ *
+ * @param ip_addr Portal address in network byte order
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t dns_server_start(uint32_t ip_addr);
+
+/**
+ * @brief Get the DNS counters
+ *
+ * @param stats Output counters
+ */
+void dns_server_get_stats(dns_server_stats_t *stats);
+
+#endif // DNS_SERVER_H
@@ -0,0 +1,229 @@
+#include "energy.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+// Print ENERGY_TRACE lines for replay with the host build of energy_model.c
+#ifndef ENERGY_TRACE_LOG
+#define ENERGY_TRACE_LOG 0
+#endif
+#define ENERGY_TRACE_INTERVAL_MS 60000
+
+static const char *TAG = "energy";
+
+static portMUX_TYPE ledger_lock = portMUX_INITIALIZER_UNLOCKED;
+static energy_model_t ledger;
+static int tls_depth = 0;
+static int last_soc_milli = -1;
+static uint64_t last_sample_us = 0;
+static configRUN_TIME_COUNTER_TYPE last_idle[configNUMBER_OF_CORES];
+
+#if ENERGY_TRACE_LOG
+static uint64_t trace_last_ms = 0;
+static uint32_t trace_busy_ms = 0;
+static int32_t trace_mv = 0;
+
+static void trace_emit(uint64_t now_ms, uint32_t mask, uint32_t busy_ms, int32_t mv, int soc_milli)
+{
+  printf("ENERGY_TRACE,%llu,%lu,%lu,%ld,%d\n", (unsigned long long)now_ms, (unsigned long)mask,
+         (unsigned long)busy_ms, (long)mv, soc_milli);
+}
+#endif
+
+// Idle-task run time per core (the run-time stats clock is esp_timer, in us)
+static void read_idle_counters(configRUN_TIME_COUNTER_TYPE *idle)
+{
+  for (int core = 0; core < configNUMBER_OF_CORES; core++) {
+    idle[core] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+  }
+}
+
+// CPU busy core-milliseconds since the previous call
+static uint32_t sample_cpu_busy_ms(uint64_t now_us)
+{
+  configRUN_TIME_COUNTER_TYPE idle[configNUMBER_OF_CORES];
+  read_idle_counters(idle);
+
+  uint64_t elapsed_us = now_us - last_sample_us;
+  uint64_t busy_us = 0;
+  for (int core = 0; core < configNUMBER_OF_CORES; core++) {
+    uint64_t idle_us = (uint64_t)(idle[core] - last_idle[core]);
+    busy_us += idle_us < elapsed_us ? elapsed_us - idle_us : 0;
+    last_idle[core] = idle[core];
+  }
+  last_sample_us = now_us;
+  return (uint32_t)(busy_us / 1000);
+}
+
+void energy_init(void)
+{
+  energy_currents_t currents = {.ua = {
+      [ENERGY_SUB_WIFI] = ENERGY_WIFI_UA,
+      [ENERGY_SUB_TLS] = ENERGY_TLS_UA,
+      [ENERGY_SUB_DISPLAY] = ENERGY_DISPLAY_UA,
+      [ENERGY_SUB_CPU] = ENERGY_CPU_BUSY_UA,
+      [ENERGY_SUB_BASE] = ENERGY_BASE_UA,
+  }};
+  uint64_t now_us = esp_timer_get_time();
+
+  portENTER_CRITICAL(&ledger_lock);
+  energy_model_init(&ledger, &currents, ENERGY_CAPACITY_MAH, now_us / 1000);
+  energy_model_set(&ledger, now_us / 1000, ENERGY_SUB_DISPLAY, true);
+  portEXIT_CRITICAL(&ledger_lock);
+
+  read_idle_counters(last_idle);
+  last_sample_us = now_us;
+  ESP_LOGI(TAG, "Energy ledger started (%u mAh battery)", (unsigned)ENERGY_CAPACITY_MAH);
+}
+
+#if ENERGY_TRACE_LOG
+typedef struct {
+  bool emit;
+  uint64_t now_ms;
+  uint32_t mask;
+  uint32_t busy_ms;
+} trace_point_t;
+#else
+typedef int trace_point_t;
+#endif
+
+// Caller holds ledger_lock; a trace line, if due, is captured in *trace for printing after unlock
+static void set_state_locked(energy_subsystem_t sub, bool on, uint64_t now_ms, trace_point_t *trace)
+{
+  uint32_t old_mask = ledger.mask;
+  energy_model_set(&ledger, now_ms, sub, on);
+#if ENERGY_TRACE_LOG
+  trace->emit = ledger.mask != old_mask;
+  if (trace->emit) {
+    trace->now_ms = now_ms;
+    trace->mask = ledger.mask;
+    trace->busy_ms = trace_busy_ms;
+    trace_last_ms = now_ms;
+    trace_busy_ms = 0;
+  }
+#else
+  (void)old_mask;
+  (void)trace;
+#endif
+}
+
+static void trace_point_emit(const trace_point_t *trace)
+{
+#if ENERGY_TRACE_LOG
+  if (trace->emit) {
+    trace_emit(trace->now_ms, trace->mask, trace->busy_ms, 0, last_soc_milli);
+  }
+#else
+  (void)trace;
+#endif
+}
+
+void energy_set(energy_subsystem_t sub, bool on)
+{
+  trace_point_t trace = {0};
+  uint64_t now_ms = esp_timer_get_time() / 1000;
+  portENTER_CRITICAL(&ledger_lock);
+  set_state_locked(sub, on, now_ms, &trace);
+  portEXIT_CRITICAL(&ledger_lock);
+  trace_point_emit(&trace);
+}
+
+// The depth and the TLS state change together, so a racing begin and end cannot leave them disagreeing
+void energy_tls_begin(void)
+{
+  trace_point_t trace = {0};
+  uint64_t now_ms = esp_timer_get_time() / 1000;
+  portENTER_CRITICAL(&ledger_lock);
+  if (tls_depth++ == 0) {
+    set_state_locked(ENERGY_SUB_TLS, true, now_ms, &trace);
+  }
+  portEXIT_CRITICAL(&ledger_lock);
+  trace_point_emit(&trace);
+}
+
+void energy_tls_end(void)
+{
+  trace_point_t trace = {0};
+  uint64_t now_ms = esp_timer_get_time() / 1000;
+  portENTER_CRITICAL(&ledger_lock);
+  if (tls_depth > 0 && --tls_depth == 0) {
+    set_state_locked(ENERGY_SUB_TLS, false, now_ms, &trace);
+  }
+  portEXIT_CRITICAL(&ledger_lock);
+  trace_point_emit(&trace);
+}
+
+void energy_update(void)
+{
+  uint64_t now_us = esp_timer_get_time();
+  uint32_t busy_ms = sample_cpu_busy_ms(now_us);
+
+  portENTER_CRITICAL(&ledger_lock);
+  energy_model_advance(&ledger, now_us / 1000, busy_ms);
+#if ENERGY_TRACE_LOG
+  trace_busy_ms += busy_ms;
+  bool emit = now_us / 1000 - trace_last_ms >= ENERGY_TRACE_INTERVAL_MS;
+  uint32_t mask = ledger.mask;
+  uint32_t busy = trace_busy_ms;
+  int32_t mv = trace_mv;
+  if (emit) {
+    trace_last_ms = now_us / 1000;
+    trace_busy_ms = 0;
+    trace_mv = 0;
+  }
+  portEXIT_CRITICAL(&ledger_lock);
+  if (emit) {
+    trace_emit(now_us / 1000, mask, busy, mv, last_soc_milli);
+  }
+#else
+  portEXIT_CRITICAL(&ledger_lock);
+#endif
+}
+
+void energy_add_battery_sample(int32_t voltage_mv, int soc_milli)
+{
+  uint64_t now_ms = esp_timer_get_time() / 1000;
+  portENTER_CRITICAL(&ledger_lock);
+  energy_model_add_voltage(&ledger, now_ms, voltage_mv);
+  last_soc_milli = soc_milli;
+#if ENERGY_TRACE_LOG
+  trace_mv = voltage_mv;
+#endif
+  portEXIT_CRITICAL(&ledger_lock);
+}
+
+uint32_t energy_get_load_ua(void)
+{
+  portENTER_CRITICAL(&ledger_lock);
+  uint32_t load_ua = ledger.currents.ua[ENERGY_SUB_BASE];
+  for (int sub = ENERGY_SUB_WIFI; sub <= ENERGY_SUB_DISPLAY; sub++) {
+    if (ledger.mask & (1u << sub)) {
+      load_ua += ledger.currents.ua[sub];
+    }
+  }
+  portEXIT_CRITICAL(&ledger_lock);
+  return load_ua;
+}
+
+void energy_get_report(energy_report_t *report)
+{
+  if (report == NULL) {
+    return;
+  }
+
+  portENTER_CRITICAL(&ledger_lock);
+  energy_model_t m = ledger;
+  int soc_milli = last_soc_milli;
+  portEXIT_CRITICAL(&ledger_lock);
+
+  report->uptime_s = (uint32_t)((m.last_ms - m.start_ms) / 1000);
+  report->avg_current_ua = energy_model_avg_current_ua(&m);
+  for (int sub = 0; sub < ENERGY_SUB_COUNT; sub++) {
+    report->on_s[sub] = (uint32_t)(m.on_ms[sub] / 1000);
+    report->used_uah[sub] = (uint32_t)(m.charge_uams[sub] / 3600000);
+  }
+  report->slope_uv_per_h = m.trend_valid ? m.slope_uv_per_h : 0;
+  report->runtime_min = energy_model_runtime_min(&m, soc_milli);
+}
@@ -0,0 +1,79 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "energy_model.h"
+
+/**
+ * @brief Snapshot of the energy ledger
+ */
+typedef struct {
+  uint32_t uptime_s;                     ///< Time covered by the ledger
+  uint32_t avg_current_ua;               ///< Average current since boot
+  uint32_t on_s[ENERGY_SUB_COUNT];       ///< Active time per consumer (core-seconds for CPU)
+  uint32_t used_uah[ENERGY_SUB_COUNT];   ///< Charge used per consumer
+  int32_t slope_uv_per_h;                ///< Smoothed battery voltage slope
+  int32_t runtime_min;                   ///< Predicted runtime, -1 until known
+} energy_report_t;
+
+/**
+ * @brief Start the ledger with the ENERGY_*_UA current figures
+ *
+ * WiFi is assumed off and the display on, matching the state at boot.
+ */
+void energy_init(void);
+
+/**
+ * @brief Record a WiFi or display on/off transition
+ *
+ * @param sub ENERGY_SUB_WIFI or ENERGY_SUB_DISPLAY
+ * @param on New state
+ */
+void energy_set(energy_subsystem_t sub, bool on);
+
+/**
+ * @brief Mark the start of a TLS handshake
+ *
+ * Handshakes may overlap (WebSocket and OTA); the TLS state stays on
+ * until every begin has been matched by energy_tls_end().
+ */
+void energy_tls_begin(void);
+
+/**
+ * @brief Mark the end of a TLS handshake, successful or not
+ */
+void energy_tls_end(void);
+
+/**
+ * @brief Integrate the ledger up to now, sampling CPU busy time
+ *
+ * Call periodically (the main loop does it every iteration).
+ */
+void energy_update(void);
+
+/**
+ * @brief Feed the latest battery reading into the runtime estimate
+ *
+ * @param voltage_mv Battery voltage in millivolts
+ * @param soc_milli State of charge in thousandths
+ */
+void energy_add_battery_sample(int32_t voltage_mv, int soc_milli);
+
+/**
+ * @brief Current the ledger expects to be drawn right now
+ *
+ * Base plus every consumer that is switched on; CPU load is not included.
+ *
+ * @return Load in microamps
+ */
+uint32_t energy_get_load_ua(void);
+
+/**
+ * @brief Get the current ledger and runtime prediction
+ *
+ * @param report Output snapshot
+ */
+void energy_get_report(energy_report_t *report);
+
+#endif // ENERGY_H
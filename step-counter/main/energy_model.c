@@ -0,0 +1,160 @@
+#include "energy_model.h"
+#include <string.h>
+
+void energy_model_init(energy_model_t *m, const energy_currents_t *currents, uint32_t capacity_mah, uint64_t now_ms)
+{
+  memset(m, 0, sizeof(*m));
+  m->currents = *currents;
+  m->capacity_mah = capacity_mah;
+  m->start_ms = now_ms;
+  m->last_ms = now_ms;
+  m->last_mv = -1;
+}
+
+void energy_model_advance(energy_model_t *m, uint64_t now_ms, uint32_t cpu_busy_ms)
+{
+  uint64_t dt = now_ms > m->last_ms ? now_ms - m->last_ms : 0;
+  m->last_ms = now_ms > m->last_ms ? now_ms : m->last_ms;
+
+  for (int sub = ENERGY_SUB_WIFI; sub <= ENERGY_SUB_DISPLAY; sub++) {
+    if (m->mask & (1u << sub)) {
+      m->on_ms[sub] += dt;
+      m->charge_uams[sub] += (uint64_t)m->currents.ua[sub] * dt;
+    }
+  }
+
+  m->on_ms[ENERGY_SUB_CPU] += cpu_busy_ms;
+  m->charge_uams[ENERGY_SUB_CPU] += (uint64_t)m->currents.ua[ENERGY_SUB_CPU] * cpu_busy_ms;
+
+  m->on_ms[ENERGY_SUB_BASE] += dt;
+  m->charge_uams[ENERGY_SUB_BASE] += (uint64_t)m->currents.ua[ENERGY_SUB_BASE] * dt;
+}
+
+void energy_model_set(energy_model_t *m, uint64_t now_ms, energy_subsystem_t sub, bool on)
+{
+  if (sub > ENERGY_SUB_DISPLAY) {
+    return;  // CPU and base are not on/off states
+  }
+  energy_model_advance(m, now_ms, 0);
+  if (on) {
+    m->mask |= 1u << sub;
+  } else {
+    m->mask &= ~(1u << sub);
+  }
+}
+
+void energy_model_add_voltage(energy_model_t *m, uint64_t now_ms, int32_t mv)
+{
+  bool first = m->last_mv < 0;
+  m->last_mv = mv;
+  if (first) {
+    m->trend_ms = now_ms;
+    m->trend_mv = mv;
+    return;
+  }
+
+  uint64_t dt = now_ms - m->trend_ms;
+  if (dt < ENERGY_MODEL_TREND_INTERVAL_MS) {
+    return;
+  }
+
+  int32_t slope = (int32_t)((int64_t)(mv - m->trend_mv) * 1000 * 3600000 / (int64_t)dt);
+  // Smooth over intervals so a WiFi burst at one sample does not swing the estimate
+  m->slope_uv_per_h = m->trend_valid ? m->slope_uv_per_h + (slope - m->slope_uv_per_h) / 4 : slope;
+  m->trend_valid = true;
+  m->trend_ms = now_ms;
+  m->trend_mv = mv;
+}
+
+uint32_t energy_model_avg_current_ua(const energy_model_t *m)
+{
+  uint64_t elapsed = m->last_ms - m->start_ms;
+  if (elapsed == 0) {
+    return 0;
+  }
+  uint64_t total = 0;
+  for (int sub = 0; sub < ENERGY_SUB_COUNT; sub++) {
+    total += m->charge_uams[sub];
+  }
+  return (uint32_t)(total / elapsed);
+}
+
+int32_t energy_model_runtime_min(const energy_model_t *m, int soc_milli)
+{
+  uint32_t avg_ua = energy_model_avg_current_ua(m);
+  if (avg_ua == 0 || soc_milli < 0) {
+    return -1;
+  }
+
+  // Coulomb estimate: remaining uAh over average uA
+  uint64_t remaining_uah = (uint64_t)m->capacity_mah * (uint64_t)soc_milli;
+  int32_t coulomb_min = (int32_t)(remaining_uah * 60 / avg_ua);
+
+  if (!m->trend_valid || m->slope_uv_per_h >= 0 || m->last_mv <= ENERGY_MODEL_EMPTY_MV) {
+    return coulomb_min;
+  }
+
+  int32_t trend_min = (int32_t)((int64_t)(m->last_mv - ENERGY_MODEL_EMPTY_MV) * 1000 * 60 / -m->slope_uv_per_h);
+  return (coulomb_min + trend_min) / 2;
+}
+
+#ifdef ENERGY_MODEL_HOST
+/*
+ * Host replay: reads "ENERGY_TRACE,<ms>,<mask>,<cpu_busy_ms>,<mv>,<soc_milli>"
+ * lines from stdin and prints the resulting ledger. Override the current
+ * figures with -D on the command line to try other estimates.
+ */
+#include <stdio.h>
+#include <inttypes.h>
+
+int main(void)
+{
+  static const char *names[ENERGY_SUB_COUNT] = {"wifi", "tls", "display", "cpu", "base"};
+  energy_currents_t currents = {.ua = {
+      [ENERGY_SUB_WIFI] = ENERGY_WIFI_UA,
+      [ENERGY_SUB_TLS] = ENERGY_TLS_UA,
+      [ENERGY_SUB_DISPLAY] = ENERGY_DISPLAY_UA,
+      [ENERGY_SUB_CPU] = ENERGY_CPU_BUSY_UA,
+      [ENERGY_SUB_BASE] = ENERGY_BASE_UA,
+  }};
+  energy_model_t m;
+  bool started = false;
+  int soc_milli = -1;
+  char line[256];
+
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    const char *p = strstr(line, "ENERGY_TRACE,");
+    uint64_t t;
+    unsigned mask, busy;
+    int mv, soc;
+    if (p == NULL || sscanf(p, "ENERGY_TRACE,%" SCNu64 ",%u,%u,%d,%d", &t, &mask, &busy, &mv, &soc) != 5) {
+      continue;
+    }
+    if (!started) {
+      energy_model_init(&m, &currents, ENERGY_CAPACITY_MAH, t);
+      started = true;
+    }
+    energy_model_advance(&m, t, busy);
+    for (int sub = ENERGY_SUB_WIFI; sub <= ENERGY_SUB_DISPLAY; sub++) {
+      energy_model_set(&m, t, (energy_subsystem_t)sub, (mask >> sub) & 1);
+    }
+    if (mv > 0) {
+      energy_model_add_voltage(&m, t, mv);
+    }
+    soc_milli = soc;
+  }
+
+  if (!started) {
+    fprintf(stderr, "no ENERGY_TRACE lines on stdin\n");
+    return 1;
+  }
+
+  printf("elapsed %" PRIu64 " s, average %" PRIu32 " uA\n", (m.last_ms - m.start_ms) / 1000, energy_model_avg_current_ua(&m));
+  for (int sub = 0; sub < ENERGY_SUB_COUNT; sub++) {
+    printf("  %-8s on %8" PRIu64 " s  %8" PRIu64 " uAh\n", names[sub], m.on_ms[sub] / 1000, m.charge_uams[sub] / 3600000);
+  }
+  printf("runtime estimate %" PRId32 " min (slope %" PRId32 " uV/h)\n",
+         energy_model_runtime_min(&m, soc_milli), m.slope_uv_per_h);
+  return 0;
+}
+#endif
@@ -0,0 +1,136 @@
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "soc_model.h"
+
+/*
+ * Energy ledger and runtime estimator, in plain C with no ESP-IDF
+ * dependencies so the same model can replay recorded state traces on a
+ * host:
+ *
+ *   gcc -DENERGY_MODEL_HOST -o energy_replay main/energy_model.c
+ *   grep ENERGY_TRACE capture.log | ./energy_replay
+ *
+ * Trace lines are printed by energy.c when built with ENERGY_TRACE_LOG=1.
+ * The ledger arithmetic is checked by host_test/test_energy_model.c.
+ */
+
+/* Battery voltage treated as empty when extrapolating the voltage trend:
+ * the 0 % point of the SoC model, so both halves of the estimate agree */
+#define ENERGY_MODEL_EMPTY_MV SOC_MODEL_EMPTY_MV
+
+/* Default current figures in microamps; measure the board and override */
+#ifndef ENERGY_BASE_UA
+#define ENERGY_BASE_UA 20000
+#endif
+#ifndef ENERGY_CPU_BUSY_UA
+#define ENERGY_CPU_BUSY_UA 25000   // Per busy core, on top of the base
+#endif
+#ifndef ENERGY_WIFI_UA
+#define ENERGY_WIFI_UA 80000
+#endif
+#ifndef ENERGY_TLS_UA
+#define ENERGY_TLS_UA 40000        // Extra crypto load while a handshake runs
+#endif
+#ifndef ENERGY_DISPLAY_UA
+#define ENERGY_DISPLAY_UA 35000    // Panel plus backlight at 50 %
+#endif
+#ifndef ENERGY_CAPACITY_MAH
+#define ENERGY_CAPACITY_MAH 1000
+#endif
+
+/* Minimum spacing between voltage samples used for the trend */
+#ifndef ENERGY_MODEL_TREND_INTERVAL_MS
+#define ENERGY_MODEL_TREND_INTERVAL_MS (10 * 60 * 1000)
+#endif
+
+/**
+ * @brief Power consumers tracked by the ledger
+ *
+ * WiFi, TLS and display are on/off states. CPU is charged per busy
+ * core-millisecond. Base is the always-on floor (idle CPU, sensors, regulator).
+ */
+typedef enum {
+  ENERGY_SUB_WIFI = 0,
+  ENERGY_SUB_TLS,
+  ENERGY_SUB_DISPLAY,
+  ENERGY_SUB_CPU,
+  ENERGY_SUB_BASE,
+  ENERGY_SUB_COUNT
+} energy_subsystem_t;
+
+/**
+ * @brief Current drawn by each consumer while active, in microamps
+ */
+typedef struct {
+  uint32_t ua[ENERGY_SUB_COUNT];
+} energy_currents_t;
+
+/**
+ * @brief Ledger state
+ */
+typedef struct {
+  energy_currents_t currents;
+  uint32_t capacity_mah;                    ///< Nominal battery capacity
+  uint32_t mask;                            ///< Bit per energy_subsystem_t that is currently on
+  uint64_t start_ms;                        ///< Time the ledger was started
+  uint64_t last_ms;                         ///< Time charge was last integrated up to
+  uint64_t on_ms[ENERGY_SUB_COUNT];         ///< Time each consumer was active (core-ms for CPU)
+  uint64_t charge_uams[ENERGY_SUB_COUNT];   ///< Charge used by each consumer in uA*ms
+  int32_t last_mv;                          ///< Most recent battery voltage
+  int32_t trend_mv;                         ///< Voltage at the start of the current trend interval
+  uint64_t trend_ms;                        ///< Time of trend_mv
+  int32_t slope_uv_per_h;                   ///< Smoothed voltage slope (negative while discharging)
+  bool trend_valid;                         ///< At least one full trend interval has passed
+} energy_model_t;
+
+/**
+ * @brief Start an empty ledger
+ *
+ * @param m Ledger
+ * @param currents Current figures for each consumer
+ * @param capacity_mah Nominal battery capacity
+ * @param now_ms Current time
+ */
+void energy_model_init(energy_model_t *m, const energy_currents_t *currents, uint32_t capacity_mah, uint64_t now_ms);
+
+/**
+ * @brief Integrate charge up to now_ms with the current on/off states
+ *
+ * @param m Ledger
+ * @param now_ms Current time
+ * @param cpu_busy_ms CPU busy time (summed over cores) since the previous call
+ */
+void energy_model_advance(energy_model_t *m, uint64_t now_ms, uint32_t cpu_busy_ms);
+
+/**
+ * @brief Turn an on/off consumer on or off, integrating up to now_ms first
+ */
+void energy_model_set(energy_model_t *m, uint64_t now_ms, energy_subsystem_t sub, bool on);
+
+/**
+ * @brief Feed a battery voltage sample into the trend estimate
+ */
+void energy_model_add_voltage(energy_model_t *m, uint64_t now_ms, int32_t mv);
+
+/**
+ * @brief Average current over the life of the ledger, in microamps
+ */
+uint32_t energy_model_avg_current_ua(const energy_model_t *m);
+
+/**
+ * @brief Predict remaining runtime
+ *
+ * Divides the remaining capacity (from the state of charge) by the average
+ * current, and averages that with an extrapolation of the voltage trend to
+ * ENERGY_MODEL_EMPTY_MV once the trend is valid.
+ *
+ * @param m Ledger
+ * @param soc_milli State of charge in thousandths
+ * @return Minutes remaining, or -1 if there is not enough data yet
+ */
+int32_t energy_model_runtime_min(const energy_model_t *m, int soc_milli);
+
+#endif // ENERGY_MODEL_H
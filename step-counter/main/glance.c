@@ -0,0 +1,250 @@
+#include "glance.h"
+#include "display.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Band buffer height; the frame is pushed in LCD_V_RES / GLANCE_BAND_LINES transfers */
+#define GLANCE_BAND_LINES 40
+#define GLANCE_FLUSH_TIMEOUT_MS 100
+
+/* RGB565 in the same byte order LVGL flushes (CONFIG_LV_COLOR_16_SWAP off) */
+#define GLANCE_COLOR_BG 0x0000
+#define GLANCE_COLOR_FG 0xFFFF
+#define GLANCE_COLOR_ON 0x07E0
+#define GLANCE_COLOR_OFF 0x8410
+
+/* 5x7 bitmap font, one byte per row, bit 4 is the leftmost column */
+#define GLYPH_W 5
+#define GLYPH_H 7
+
+static const char *TAG = "glance";
+
+typedef struct {
+  char ch;
+  uint8_t rows[GLYPH_H];
+} glyph_t;
+
+static const glyph_t font[] = {
+    {'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+    {'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+    {'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+    {'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+    {'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+    {'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+    {'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+    {'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+    {'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+    {'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+    {'%', {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}},
+    {'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+    {'E', {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}},
+    {'P', {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}},
+    {'S', {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}},
+    {'T', {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}},
+    {'W', {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}},
+};
+
+typedef struct {
+  int x;
+  int y;
+  int scale;
+  uint16_t color;
+  char text[12];
+} glance_text_t;
+
+static SemaphoreHandle_t flush_done = NULL;
+static glance_stats_t last_stats;
+
+static const uint8_t *find_glyph(char ch)
+{
+  for (size_t i = 0; i < sizeof(font) / sizeof(font[0]); i++) {
+    if (font[i].ch == ch) {
+      return font[i].rows;
+    }
+  }
+  return NULL;  // Unknown characters render as a space
+}
+
+static int text_width(const char *text, int scale)
+{
+  int len = strlen(text);
+  return len > 0 ? len * (GLYPH_W + 1) * scale - scale : 0;
+}
+
+static bool glance_trans_done(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(flush_done, &woken);
+  return woken == pdTRUE;
+}
+
+static void fill_rect(uint16_t *band, int band_y, int x, int y, int w, int h, uint16_t color)
+{
+  int y0 = y > band_y ? y : band_y;
+  int y1 = y + h < band_y + GLANCE_BAND_LINES ? y + h : band_y + GLANCE_BAND_LINES;
+  int x0 = x > 0 ? x : 0;
+  int x1 = x + w < LCD_H_RES ? x + w : LCD_H_RES;
+  for (int py = y0; py < y1; py++) {
+    uint16_t *row = band + (py - band_y) * LCD_H_RES;
+    for (int px = x0; px < x1; px++) {
+      row[px] = color;
+    }
+  }
+}
+
+static void render_band(uint16_t *band, int band_y, const glance_text_t *items, int count)
+{
+  for (int i = 0; i < LCD_H_RES * GLANCE_BAND_LINES; i++) {
+    band[i] = GLANCE_COLOR_BG;
+  }
+
+  for (int i = 0; i < count; i++) {
+    const glance_text_t *t = &items[i];
+    // Skip text that does not touch this band
+    if (t->y >= band_y + GLANCE_BAND_LINES || t->y + GLYPH_H * t->scale <= band_y) {
+      continue;
+    }
+    int advance = (GLYPH_W + 1) * t->scale;
+    for (int c = 0; t->text[c] != '\0'; c++) {
+      const uint8_t *rows = find_glyph(t->text[c]);
+      if (rows == NULL) {
+        continue;
+      }
+      int gx = t->x + c * advance;
+      for (int r = 0; r < GLYPH_H; r++) {
+        int gy = t->y + r * t->scale;
+        if (gy >= band_y + GLANCE_BAND_LINES || gy + t->scale <= band_y) {
+          continue;
+        }
+        for (int col = 0; col < GLYPH_W; col++) {
+          if (rows[r] & (0x10 >> col)) {
+            fill_rect(band, band_y, gx + col * t->scale, gy, t->scale, t->scale, t->color);
+          }
+        }
+      }
+    }
+  }
+}
+
+static int layout(const glance_info_t *info, glance_text_t *items)
+{
+  int n = 0;
+
+  // Link status, top left
+  items[n] = (glance_text_t){.x = 8, .y = 8, .scale = 3,
+                             .color = info->wifi_connected ? GLANCE_COLOR_ON : GLANCE_COLOR_OFF, .text = "W"};
+  n++;
+  items[n] = (glance_text_t){.x = 8 + (GLYPH_W + 1) * 3, .y = 8, .scale = 3,
+                             .color = info->ws_connected ? GLANCE_COLOR_ON : GLANCE_COLOR_OFF, .text = "S"};
+  n++;
+
+  // Battery, top right
+  items[n] = (glance_text_t){.y = 8, .scale = 3, .color = GLANCE_COLOR_FG};
+  if (info->battery_pct >= 0) {
+    snprintf(items[n].text, sizeof(items[n].text), "%d%%", info->battery_pct);
+  } else {
+    snprintf(items[n].text, sizeof(items[n].text), "--%%");
+  }
+  items[n].x = LCD_H_RES - 8 - text_width(items[n].text, 3);
+  n++;
+
+  // Step count, centred; shrink the digits if a large count would not fit
+  items[n] = (glance_text_t){.scale = 7, .color = GLANCE_COLOR_FG};
+  snprintf(items[n].text, sizeof(items[n].text), "%lu", (unsigned long)info->step_count);
+  while (items[n].scale > 3 && text_width(items[n].text, items[n].scale) > LCD_H_RES - 16) {
+    items[n].scale--;
+  }
+  items[n].x = (LCD_H_RES - text_width(items[n].text, items[n].scale)) / 2;
+  items[n].y = (LCD_V_RES - GLYPH_H * items[n].scale) / 2;
+  n++;
+
+  items[n] = (glance_text_t){.y = LCD_V_RES / 2 + 40, .scale = 3, .color = GLANCE_COLOR_OFF, .text = "STEPS"};
+  items[n].x = (LCD_H_RES - text_width(items[n].text, 3)) / 2;
+  n++;
+
+  return n;
+}
+
+esp_err_t glance_show(esp_lcd_panel_handle_t panel, const glance_info_t *info)
+{
+  if (panel == NULL || info == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  int64_t start_us = esp_timer_get_time();
+  glance_stats_t stats = {0};
+
+  if (flush_done == NULL) {
+    flush_done = xSemaphoreCreateBinary();
+    if (flush_done == NULL) {
+      return ESP_ERR_NO_MEM;
+    }
+  }
+
+  uint16_t *band = heap_caps_malloc(LCD_H_RES * GLANCE_BAND_LINES * sizeof(uint16_t), MALLOC_CAP_DMA);
+  if (band == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate band buffer");
+    return ESP_ERR_NO_MEM;
+  }
+
+  glance_text_t items[5];
+  int count = layout(info, items);
+
+  // Panel stays dark until the whole frame is in GRAM, so no stale pixels show
+  bool was_asleep = display_get_power_state() == DISPLAY_POWER_SLEEP;
+  if (was_asleep) {
+    display_wake_begin();
+  }
+
+  esp_lcd_panel_io_color_trans_done_cb_t prev_cb = display_set_color_trans_done_cb(glance_trans_done);
+  esp_err_t err = ESP_OK;
+
+  for (int band_y = 0; band_y < LCD_V_RES && err == ESP_OK; band_y += GLANCE_BAND_LINES) {
+    int64_t t0 = esp_timer_get_time();
+    render_band(band, band_y, items, count);
+    int64_t t1 = esp_timer_get_time();
+
+    err = esp_lcd_panel_draw_bitmap(panel, 0, band_y, LCD_H_RES, band_y + GLANCE_BAND_LINES, band);
+    // The band buffer is reused, so wait for DMA before rendering the next one
+    if (err == ESP_OK && xSemaphoreTake(flush_done, pdMS_TO_TICKS(GLANCE_FLUSH_TIMEOUT_MS)) != pdTRUE) {
+      err = ESP_ERR_TIMEOUT;
+    }
+    int64_t t2 = esp_timer_get_time();
+
+    stats.render_us += (uint32_t)(t1 - t0);
+    stats.flush_wait_us += (uint32_t)(t2 - t1);
+    stats.spi_bytes += LCD_H_RES * GLANCE_BAND_LINES * sizeof(uint16_t);
+  }
+
+  display_set_color_trans_done_cb(prev_cb);
+  heap_caps_free(band);
+
+  if (was_asleep) {
+    display_wake_finish();
+  }
+
+  stats.visible_us = (uint32_t)(esp_timer_get_time() - start_us);
+  last_stats = stats;
+
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Glance flush failed: %s", esp_err_to_name(err));
+    return err;
+  }
+
+  ESP_LOGI(TAG, "Glance visible in %lu us (render %lu us, SPI wait %lu us, %lu bytes)",
+           (unsigned long)stats.visible_us, (unsigned long)stats.render_us,
+           (unsigned long)stats.flush_wait_us, (unsigned long)stats.spi_bytes);
+  return ESP_OK;
+}
+
+void glance_get_last_stats(glance_stats_t *stats)
+{
+  if (stats != NULL) {
+    *stats = last_stats;
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef GLANCE_H
+#define GLANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_lcd_panel_ops.h"
+
+/**
+ * @brief Values drawn by the glance renderer
+ */
+typedef struct {
+  uint32_t step_count;   ///< Total steps
+  int battery_pct;       ///< Battery percentage (0-100), or -1 if not known yet
+  bool wifi_connected;   ///< WiFi connection status
+  bool ws_connected;     ///< WebSocket connection status
+} glance_info_t;
+
+/**
+ * @brief Cost of the last glance
+ */
+typedef struct {
+  uint32_t visible_us;      ///< From glance_show() until the frame is on screen
+  uint32_t render_us;       ///< CPU time spent rasterising bands
+  uint32_t flush_wait_us;   ///< Time spent waiting for SPI transfers
+  uint32_t spi_bytes;       ///< Pixel bytes sent to the panel
+} glance_stats_t;
+
+/**
+ * @brief Draw the step count, battery and link status straight to the panel
+ *
+ * Rasterises a built-in bitmap font into a small DMA band buffer and pushes
+ * it with esp_lcd_panel_draw_bitmap, without LVGL. Usable before ui_init()
+ * and while LVGL rendering is suspended. If the panel is asleep it is woken
+ * and turned on once the frame is complete. LVGL must not flush while this runs.
+ *
+ * @param panel LCD panel handle from display_init()
+ * @param info Values to draw
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the band buffer could not be allocated
+ */
+esp_err_t glance_show(esp_lcd_panel_handle_t panel, const glance_info_t *info);
+
+/**
+ * @brief Get the timing of the most recent glance
+ *
+ * @param stats Output: cost of the last glance_show()
+ */
+void glance_get_last_stats(glance_stats_t *stats);
+
+#endif // GLANCE_H
@@ -0,0 +1,80 @@
+#include "json_stream.h"
+#include <stdio.h>
+
+static void flush_staged(json_stream_t *s)
+{
+    if (s->len == 0 || s->failed) {
+        s->len = 0;
+        return;
+    }
+    if (!s->flush(s->ctx, s->buf, s->len)) {
+        s->failed = true;
+    }
+    s->flushes++;
+    s->len = 0;
+}
+
+static void put_char(json_stream_t *s, char c)
+{
+    if (s->len == s->size) {
+        flush_staged(s);
+    }
+    s->buf[s->len++] = c;
+    s->total++;
+}
+
+void json_stream_init(json_stream_t *s, char *buf, size_t size, json_stream_flush_fn flush, void *ctx)
+{
+    s->buf = buf;
+    s->size = size;
+    s->len = 0;
+    s->flush = flush;
+    s->ctx = ctx;
+    s->total = 0;
+    s->flushes = 0;
+    s->failed = false;
+}
+
+void json_stream_raw(json_stream_t *s, const char *text)
+{
+    while (*text != '\0') {
+        put_char(s, *text++);
+    }
+}
+
+void json_stream_string(json_stream_t *s, const char *str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(s, '"');
+    for (size_t i = 0; i < len && str[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if (c == '"' || c == '\\') {
+            put_char(s, '\\');
+            put_char(s, (char)c);
+        } else if (c < 0x20) {
+            put_char(s, '\\');
+            put_char(s, 'u');
+            put_char(s, '0');
+            put_char(s, '0');
+            put_char(s, hex[c >> 4]);
+            put_char(s, hex[c & 0xf]);
+        } else {
+            put_char(s, (char)c);
+        }
+    }
+    put_char(s, '"');
+}
+
+void json_stream_int(json_stream_t *s, int32_t value)
+{
+    char digits[12];
+    snprintf(digits, sizeof(digits), "%ld", (long)value);
+    json_stream_raw(s, digits);
+}
+
+bool json_stream_finish(json_stream_t *s)
+{
+    flush_staged(s);
+    return !s->failed;
+}
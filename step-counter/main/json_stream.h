@@ -0,0 +1,71 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal JSON writer that emits through a small caller-owned buffer,
+ * flushing it whenever it fills. Nothing is allocated, so a response of
+ * any length costs only the buffer. Plain C; checked on the host by
+ * host_test/test_json_stream.c.
+ */
+
+/**
+ * @brief Sink for full buffers; returns false to abort the stream
+ */
+typedef bool (*json_stream_flush_fn)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state
+ */
+typedef struct {
+    char *buf;                   ///< Caller-owned staging buffer
+    size_t size;                 ///< Capacity of buf
+    size_t len;                  ///< Bytes currently staged
+    json_stream_flush_fn flush;  ///< Where full buffers go
+    void *ctx;                   ///< Passed to flush
+    size_t total;                ///< Bytes written so far
+    uint32_t flushes;            ///< Number of flush calls
+    bool failed;                 ///< A flush failed; later writes are dropped
+} json_stream_t;
+
+/**
+ * @brief Start a stream over buf
+ *
+ * @param s Writer
+ * @param buf Staging buffer (at least 8 bytes)
+ * @param size Size of buf
+ * @param flush Called with each full buffer and once more by json_stream_finish()
+ * @param ctx Passed to flush
+ */
+void json_stream_init(json_stream_t *s, char *buf, size_t size, json_stream_flush_fn flush, void *ctx);
+
+/**
+ * @brief Write literal JSON text (punctuation, keys with their quotes, ...)
+ */
+void json_stream_raw(json_stream_t *s, const char *text);
+
+/**
+ * @brief Write a quoted, escaped JSON string
+ *
+ * @param s Writer
+ * @param str Bytes to write
+ * @param len Number of bytes, or stops early at a NUL
+ */
+void json_stream_string(json_stream_t *s, const char *str, size_t len);
+
+/**
+ * @brief Write a decimal integer
+ */
+void json_stream_int(json_stream_t *s, int32_t value);
+
+/**
+ * @brief Flush whatever is staged
+ *
+ * @return true if every flush succeeded
+ */
+bool json_stream_finish(json_stream_t *s);
+
+#endif // JSON_STREAM_H
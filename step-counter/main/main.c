@@ -9,19 +9,134 @@
 #include "battery.h"
 #include "display.h"
 #include "ui.h"
+#include "glance.h"
 #include "touch.h"
 #include "wifi_manager.h"
 #include "ntp_time.h"
 #include "websocket_client.h"
 #include "step_counter.h"
+#include "step_history.h"
 #include "ota.h"
+#include "task_placement.h"
+#include "energy.h"
+#include "metrics.h"
+#include "binlog.h"
+#include "profiler.h"
+#include "msg_pool.h"
+#include "alloc_trace.h"
+#include "esp_heap_caps.h"
+#include "esp_intr_alloc.h"
+#include "driver/gpio.h"
 
 static const char *TAG = "main";
 
+// Number of frames/updates to time in the UI benchmarks after the main screen appears (0 = off)
+#define UI_BENCHMARK_FRAMES 0
+
+// Calls to time in the battery SoC benchmark at startup (0 = off)
+#define SOC_BENCHMARK_ITERATIONS 0
+
+// Calls to time in the BINLOG vs ESP_LOGI benchmark at startup (0 = off)
+#define BINLOG_BENCHMARK_ITERATIONS 0
+
+// How long a glance stays on screen after a tap on the sleeping display
+#define GLANCE_DURATION_MS 5000
+
+// How often the energy ledger is sent over the uplink while connected
+#define ENERGY_REPORT_INTERVAL_MS (15 * 60 * 1000)
+
+// Metrics go to the console every minute and over the uplink every 5 minutes
+#define METRICS_LOG_INTERVAL_MS (60 * 1000)
+#define METRICS_REPORT_INTERVAL_MS (5 * 60 * 1000)
+
 // Power management state
 static bool wifi_power_saving_active = false;
 static bool display_power_saving_active = false;
 static uint64_t power_management_start_time_ms = 0;
+static uint64_t display_sleep_start_ms = 0;
+static uint64_t glance_until_ms = 0;
+static uint64_t glance_touch_ms = 0;
+static esp_lcd_panel_handle_t lcd_panel = NULL;
+
+/**
+ * Run an OTA check and log how late the UI task woke while the TLS handshake
+ * and download were running. Compare builds with TASK_PLACEMENT_SPLIT 0 and 1.
+ */
+static esp_err_t ota_check_measuring_jitter(void)
+{
+  // The probe keeps sampling on a static screen, where the handler would otherwise sleep untimed
+  ui_frame_jitter_t jitter;
+  ui_set_jitter_probe(true);
+  ui_get_frame_jitter(&jitter);  // Start a fresh window
+
+  esp_err_t result = ota_check_and_update();
+
+  ui_get_frame_jitter(&jitter);
+  ui_set_jitter_probe(false);
+  const ota_check_stats_t *stats = ota_get_last_check_stats();
+  ESP_LOGI(TAG, "UI jitter during OTA check (split %s, %lu handshakes): max %lu us, avg %lu us over %lu wakeups",
+           TASK_PLACEMENT_SPLIT ? "on" : "off", (unsigned long)stats->handshakes,
+           (unsigned long)jitter.max_late_us, (unsigned long)jitter.avg_late_us,
+           (unsigned long)jitter.samples);
+  return result;
+}
+
+// Periodic checks run here so a slow handshake or download never stalls the main loop
+#define OTA_CHECK_TASK_STACK 6144
+
+static volatile bool ota_check_running = false;
+
+static void ota_check_task(void *arg)
+{
+  esp_err_t ota_result = ota_check_measuring_jitter();
+  if (ota_result != ESP_OK) {
+    ESP_LOGW(TAG, "Periodic OTA check failed: %s", esp_err_to_name(ota_result));
+  }
+  ota_check_running = false;
+  vTaskDelete(NULL);
+}
+
+static void start_ota_check(void)
+{
+  ota_check_running = true;
+  if (task_placement_create(ota_check_task, "ota_check", OTA_CHECK_TASK_STACK, NULL,
+                            TASK_ROLE_NET, NULL) != pdPASS) {
+    ESP_LOGW(TAG, "Failed to start OTA check task");
+    ota_check_running = false;
+  }
+}
+
+// The GPIO ISR service takes its interrupt on the core that installs it
+#define GPIO_ISR_INSTALL_TASK_STACK 2048
+
+static esp_err_t gpio_isr_install_result;
+
+static void gpio_isr_install_task(void *arg)
+{
+  gpio_isr_install_result = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+  xTaskNotifyGive((TaskHandle_t)arg);
+  vTaskDelete(NULL);
+}
+
+/*
+ * Install the GPIO ISR service from the UI core, before touch.c and
+ * step_counter.c ask for it, so the step edge interrupt stays off the
+ * core that takes the WiFi and lwIP interrupts. Their own installs then
+ * return ESP_ERR_INVALID_STATE, which both treat as success.
+ */
+static void install_gpio_isr_service_on_ui_core(void)
+{
+  gpio_isr_install_result = ESP_FAIL;
+  if (task_placement_create(gpio_isr_install_task, "gpio_isr_install", GPIO_ISR_INSTALL_TASK_STACK,
+                            xTaskGetCurrentTaskHandle(), TASK_ROLE_UI, NULL) != pdPASS) {
+    ESP_LOGW(TAG, "Could not start the GPIO ISR install task; the service will go on this core");
+    return;
+  }
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  if (gpio_isr_install_result != ESP_OK) {
+    ESP_LOGW(TAG, "GPIO ISR service install failed: %s", esp_err_to_name(gpio_isr_install_result));
+  }
+}
 
 static void app_main_loop(void)
 {
@@ -30,30 +145,106 @@ static void app_main_loop(void)
   
   // Battery reading throttle - only read every 15 seconds
   uint64_t last_battery_read_ms = 0;
+  uint32_t history_steps = 0;
   float voltage = 0.0f;
   int battery_pct = 0;
+  int runtime_min = -1;
+  uint64_t last_energy_report_ms = 0;
+  uint64_t last_metrics_log_ms = 0;
+  uint64_t last_metrics_report_ms = 0;
 
   while (1)
   {
     uint64_t current_time_ms = esp_timer_get_time() / 1000;
+    energy_update();
     uint64_t last_step_ms = step_counter_get_last_step_time_ms();
+    uint64_t last_touch_ms = touch_get_last_activity_ms();
+
+    // A tap on the dark screen asks for a glance rather than a full wake
+    bool glance_requested = false;
+    if (display_power_saving_active && last_touch_ms > display_sleep_start_ms) {
+      glance_requested = last_touch_ms != glance_touch_ms;
+      glance_touch_ms = last_touch_ms;
+      last_touch_ms = 0;
+    }
 
-    // Use the later of: power management start time or last step time
+    // Use the later of: power management start time, last step time or last touch
     uint64_t activity_reference_ms = (last_step_ms > power_management_start_time_ms) ? last_step_ms : power_management_start_time_ms;
+    if (last_touch_ms > activity_reference_ms) {
+      activity_reference_ms = last_touch_ms;
+    }
     uint64_t time_since_last_step_ms = current_time_ms - activity_reference_ms;
 
     // Only read battery every 15 seconds (not every 100ms)
     if (current_time_ms - last_battery_read_ms >= 15000) {
       int adc_raw = 0;
+      // The loop used to stall ~40 ms here on eight blocking oneshot samples
+      int64_t read_start_us = esp_timer_get_time();
       read_battery(&voltage, &adc_raw);
-      int pct_milli = estimate_percentage_milli(voltage);
+      int64_t read_us = esp_timer_get_time() - read_start_us;
+      uint32_t load_ua = energy_get_load_ua();
+      int pct_milli = battery_soc_milli(voltage, load_ua);
       battery_pct = pct_milli / 10;
       last_battery_read_ms = current_time_ms;
+      // soc_model.c's host replay parses this line
+      ESP_LOGI(TAG, "Battery: %.3f V (raw %d), load %lu uA, SoC %d.%d%%, read took %lld us",
+               voltage, adc_raw, (unsigned long)load_ua, pct_milli / 10, pct_milli % 10, read_us);
+
+      energy_add_battery_sample((int32_t)(voltage * 1000.0f), pct_milli);
+      energy_report_t energy;
+      energy_get_report(&energy);
+      runtime_min = energy.runtime_min;
+      ESP_LOGI(TAG, "Energy: avg %lu uA, runtime %ld min, slope %ld uV/h | uAh wifi %lu, tls %lu, display %lu, cpu %lu, base %lu",
+               (unsigned long)energy.avg_current_ua, (long)energy.runtime_min, (long)energy.slope_uv_per_h,
+               (unsigned long)energy.used_uah[ENERGY_SUB_WIFI], (unsigned long)energy.used_uah[ENERGY_SUB_TLS],
+               (unsigned long)energy.used_uah[ENERGY_SUB_DISPLAY], (unsigned long)energy.used_uah[ENERGY_SUB_CPU],
+               (unsigned long)energy.used_uah[ENERGY_SUB_BASE]);
+
+      ui_render_stats_t render_stats;
+      ui_get_render_stats(&render_stats);
+      ESP_LOGI(TAG, "Render: %lu LVGL wakeups/s, %lu invalidated px/s, %lu flushed px/s, %lu label writes, %lu skipped",
+               (unsigned long)render_stats.lvgl_wakeups_per_s,
+               (unsigned long)render_stats.invalidated_px_per_s,
+               (unsigned long)render_stats.flushed_px_per_s,
+               (unsigned long)render_stats.label_writes,
+               (unsigned long)render_stats.label_skips);
+
+      // Interrupt-driven touch: reads only happen while touched; build with TOUCH_POLLED=1 to compare
+      static uint32_t last_touch_reads = 0;
+      uint32_t touch_reads = touch_get_read_count();
+      ESP_LOGI(TAG, "Touch (%s): %lu I2C reads in last %lu ms", TOUCH_POLLED ? "polled" : "interrupt",
+               (unsigned long)(touch_reads - last_touch_reads),
+               (unsigned long)render_stats.window_ms);
+      last_touch_reads = touch_reads;
+
+      ui_refresh_stats_t refresh_stats;
+      ui_get_refresh_stats(&refresh_stats);
+      ESP_LOGI(TAG, "Refresh: event %lu frames/min %lu B/min (%lu ms), animating %lu frames/min %lu B/min (%lu ms)",
+               (unsigned long)refresh_stats.frames_per_min[UI_REFRESH_EVENT],
+               (unsigned long)refresh_stats.spi_bytes_per_min[UI_REFRESH_EVENT],
+               (unsigned long)refresh_stats.time_ms[UI_REFRESH_EVENT],
+               (unsigned long)refresh_stats.frames_per_min[UI_REFRESH_ANIMATING],
+               (unsigned long)refresh_stats.spi_bytes_per_min[UI_REFRESH_ANIMATING],
+               (unsigned long)refresh_stats.time_ms[UI_REFRESH_ANIMATING]);
+
+      // High-water mark is what CONFIG_LV_MEM_SIZE_KILOBYTES should be sized against
+      ui_mem_stats_t mem_stats;
+      ui_get_mem_stats(&mem_stats);
+      ESP_LOGI(TAG, "LVGL heap: %lu/%lu used, peak %lu, biggest free %lu, frag %u%% | screens: main %lu, history %lu, qr %lu, ota %lu",
+               (unsigned long)mem_stats.used_size, (unsigned long)mem_stats.total_size,
+               (unsigned long)mem_stats.max_used, (unsigned long)mem_stats.free_biggest_size,
+               mem_stats.frag_pct,
+               (unsigned long)mem_stats.main_screen, (unsigned long)mem_stats.history_screen,
+               (unsigned long)mem_stats.qr_screen, (unsigned long)mem_stats.ota_overlay);
     }
 
     uint8_t buffer_size = step_counter_get_buffer_size();
     uint32_t total_steps = step_counter_get_total_steps();
 
+    // Feed new steps into the per-minute/per-hour history buckets
+    step_history_add(current_time_ms, total_steps - history_steps);
+    history_steps = total_steps;
+
     // Check if we need to reconnect WiFi after a step
     if (step_counter_needs_wifi_reconnect() && wifi_power_saving_active) {
       ESP_LOGI(TAG, "Step detected while WiFi off - reconnecting...");
@@ -61,6 +252,7 @@ static void app_main_loop(void)
       power_management_start_time_ms = current_time_ms; // Reset timer
 
       // Reconnect WiFi (don't call init, WiFi is already initialized)
+      energy_set(ENERGY_SUB_WIFI, true);
       wifi_result_t result = wifi_manager_reconnect();
       if (result == WIFI_RESULT_CONNECTED) {
         ESP_LOGI(TAG, "WiFi reconnected");
@@ -89,48 +281,134 @@ static void app_main_loop(void)
       wifi_countdown_s = (30000 - time_since_last_step_ms) / 1000;
     }
 
-    if (!display_power_saving_active && time_since_last_step_ms < 60000) {
+    // Counts down even while asleep-but-about-to-wake, so the restored frame is current
+    if (time_since_last_step_ms < 60000) {
       display_countdown_s = (60000 - time_since_last_step_ms) / 1000;
     }
 
     // Power management: WiFi
     // Turn off WiFi if no steps for 30 seconds AND buffer is empty
-    if (!wifi_power_saving_active && time_since_last_step_ms > 30000 && buffer_size == 0) {
+    // An OTA check or download in progress holds it on until the task finishes
+    if (!wifi_power_saving_active && time_since_last_step_ms > 30000 && buffer_size == 0 &&
+        !ota_check_running) {
       ESP_LOGI(TAG, "No activity for 30s, turning off WiFi to save power");
       websocket_client_stop();
       wifi_manager_disconnect();
+      energy_set(ENERGY_SUB_WIFI, false);
       wifi_power_saving_active = true;
       wifi_connected = false;
       ws_connected = false;
     }
 
+    // Update UI with all status information (even when display is off, so it's ready when we turn back on)
+    // This runs before the display power change so a wake restores current values.
+    // Only labels whose values changed are redrawn, under a single LVGL lock
+    ui_view_model_t vm = {
+      .step_count = total_steps,
+      .buffer_count = buffer_size,
+      .wifi_connected = wifi_connected,
+      .ws_connected = ws_connected,
+      .battery_pct = battery_pct,
+      .wifi_countdown_s = wifi_countdown_s,
+      .display_countdown_s = display_countdown_s,
+      .runtime_min = runtime_min,
+    };
+    ui_update(&vm);
+
     // Power management: Display
-    // Turn off display backlight if no steps for 60 seconds
+    // Put the panel to sleep if no steps for 60 seconds
     if (!display_power_saving_active && time_since_last_step_ms > 60000) {
       ESP_LOGI(TAG, "No activity for 60s, turning off display to save power");
-      display_backlight_off();
+      ui_display_sleep();
+      energy_set(ENERGY_SUB_DISPLAY, false);
       display_power_saving_active = true;
+      display_sleep_start_ms = current_time_ms;
     } else if (display_power_saving_active && time_since_last_step_ms < 60000) {
       ESP_LOGI(TAG, "Activity detected, turning display back on");
-      display_backlight_on();
+      ui_display_wake();
+      energy_set(ENERGY_SUB_DISPLAY, true);
       display_power_saving_active = false;
+      glance_until_ms = 0;
+    } else if (display_power_saving_active && glance_requested && glance_until_ms == 0) {
+      // Draw straight to the panel; LVGL stays suspended for the whole glance
+      glance_info_t glance = {
+        .step_count = total_steps,
+        .battery_pct = battery_pct,
+        .wifi_connected = wifi_connected,
+        .ws_connected = ws_connected,
+      };
+      if (glance_show(lcd_panel, &glance) == ESP_OK) {
+        energy_set(ENERGY_SUB_DISPLAY, true);
+        glance_stats_t glance_stats;
+        glance_get_last_stats(&glance_stats);
+        ESP_LOGI(TAG, "Glance: visible in %lu us (CPU %lu us, %lu SPI bytes), last LVGL wake took %lu us",
+                 (unsigned long)glance_stats.visible_us,
+                 (unsigned long)(glance_stats.render_us + glance_stats.flush_wait_us),
+                 (unsigned long)glance_stats.spi_bytes,
+                 (unsigned long)display_get_last_wake_latency_us());
+        glance_until_ms = current_time_ms + GLANCE_DURATION_MS;
+      }
+    } else if (glance_until_ms != 0 && current_time_ms >= glance_until_ms) {
+      display_sleep();
+      energy_set(ENERGY_SUB_DISPLAY, false);
+      glance_until_ms = 0;
     }
 
     // Log power management state only when buffer has steps or timers are near zero
     if ((buffer_size > 0 && current_time_ms - last_battery_read_ms < 100) || 
         wifi_countdown_s <= 5 || display_countdown_s <= 5) {
-      ESP_LOGI(TAG, "WiFi in: %ds, Display in: %ds, Steps: %lu, Buffered: %d",
-               wifi_countdown_s,
-               display_countdown_s,
-               (unsigned long)total_steps,
-               buffer_size);
+      // Runs every loop iteration near a timeout, so it goes through the binary log
+      BINLOG(BL_POWER_TIMERS, wifi_countdown_s, display_countdown_s, total_steps, buffer_size);
     }
 
-    // Update UI with all status information (even when display is off, so it's ready when we turn back on)
-    ui_update_status(total_steps, buffer_size, wifi_connected, ws_connected, battery_pct);
+    // Periodic firmware update check while we're online, off the loop in its own task
+    if (wifi_connected && !ota_check_running && ota_is_check_due(current_time_ms)) {
+      start_ota_check();
+    }
 
-    // Update power management countdown timers on display
-    ui_update_power_timers(wifi_countdown_s, display_countdown_s);
+    // Periodic energy ledger upload
+    if (ws_connected && current_time_ms - last_energy_report_ms >= ENERGY_REPORT_INTERVAL_MS) {
+      energy_report_t energy;
+      energy_get_report(&energy);
+      if (websocket_client_send_energy(&energy) == ESP_OK) {
+        last_energy_report_ms = current_time_ms;
+      }
+    }
+
+    // Metrics: console text and uplink frame
+    if (current_time_ms - last_metrics_log_ms >= METRICS_LOG_INTERVAL_MS) {
+      metrics_gauge_set(METRIC_HEAP_LOW_WATER, esp_get_minimum_free_heap_size());
+      metrics_gauge_set(METRIC_HEAP_LARGEST_FREE, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+      msg_pool_stats_t pool;
+      msg_pool_get_stats(&pool);
+      ESP_LOGI(TAG, "Message pools: small %u/%u (peak %u), large %u/%u (peak %u), %lu pooled, %lu heap fallbacks",
+               pool.classes[0].in_use, pool.classes[0].blocks, pool.classes[0].peak,
+               pool.classes[1].in_use, pool.classes[1].blocks, pool.classes[1].peak,
+               (unsigned long)pool.pool_allocs, (unsigned long)pool.heap_fallbacks);
+      metrics_snapshot_t snap;
+      metrics_snapshot(&snap);
+      char line[160];
+      for (int id = 0; id < METRIC_COUNT; id++) {
+        metrics_format_text(&snap, (metric_id_t)id, line, sizeof(line));
+        ESP_LOGI(TAG, "metric %s", line);
+      }
+      last_metrics_log_ms = current_time_ms;
+    }
+    if (ws_connected && current_time_ms - last_metrics_report_ms >= METRICS_REPORT_INTERVAL_MS) {
+      metrics_gauge_set(METRIC_HEAP_LOW_WATER, esp_get_minimum_free_heap_size());
+      metrics_gauge_set(METRIC_HEAP_LARGEST_FREE, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+      if (websocket_client_send_metrics() == ESP_OK) {
+        last_metrics_report_ms = current_time_ms;
+        profiler_report_t profile;
+        if (profiler_get_report(&profile) == ESP_OK) {
+          websocket_client_send_profile(&profile);
+        }
+      }
+    }
+
+#if ALLOC_TRACE_ENABLED
+    alloc_trace_poll(current_time_ms);
+#endif
 
     // Try to send ALL buffered steps if we have any and are connected
     if (buffer_size > 0 && ws_connected) {
@@ -147,7 +425,7 @@ static void app_main_loop(void)
         }
       }
       if (sent_count > 0) {
-        ESP_LOGI(TAG, "Sent %d buffered step(s)", sent_count);
+        BINLOG(BL_STEPS_FLUSHED, sent_count);
       }
     }
 
@@ -161,29 +439,62 @@ void app_main(void)
 {
   ESP_LOGI(TAG, "Starting battery monitor demo");
 
+  // First, so a crash dump from the previous boot is printed before anything else
+  binlog_init();
+  binlog_benchmark(BINLOG_BENCHMARK_ITERATIONS);
+
+  // Before any network code builds messages
+  msg_pool_init();
+#if ALLOC_TRACE_ENABLED
+  alloc_trace_init();
+#endif
+
+  // Start the energy ledger before anything is powered up
+  energy_init();
+
+  // Before touch_init() and step_counter_init(), which share the service
+  install_gpio_isr_service_on_ui_core();
+
   // Initialize display hardware FIRST
   esp_lcd_panel_handle_t panel = display_init(notify_lvgl_flush_ready);
+  lcd_panel = panel;
+
+  // Initialize battery monitoring early so the boot glance can show it
+  battery_init();
+  ESP_LOGI(TAG, "Battery monitoring initialized");
+  battery_benchmark_soc(SOC_BENCHMARK_ITERATIONS);
+
+  // Put something useful on the panel before LVGL is up
+  float boot_voltage = 0.0f;
+  int boot_adc_raw = 0;
+  read_battery(&boot_voltage, &boot_adc_raw);
+  glance_info_t boot_glance = {
+    .step_count = 0,
+    .battery_pct = estimate_percentage_milli(boot_voltage) / 10,
+  };
+  if (glance_show(panel, &boot_glance) == ESP_OK) {
+    ESP_LOGI(TAG, "Boot glance visible %lld us after boot", esp_timer_get_time());
+  }
 
   // Initialize LVGL and show startup screen
   ui_init(panel);
   ui_update_startup_status("Initializing hardware...");
   vTaskDelay(pdMS_TO_TICKS(100)); // Allow UI to render
 
-  // Initialize battery monitoring
-  ui_update_startup_status("Starting battery monitor...");
-  battery_init();
-  ESP_LOGI(TAG, "Battery monitoring initialized");
-  vTaskDelay(pdMS_TO_TICKS(500));
-
   // Initialize touch controller
   ui_update_startup_status("Initializing touch...");
-  // Note: touch_init returns handle but we're not using it yet
-  // touch_init(io_handle);
+  if (touch_init() != NULL) {
+    ui_register_touch();
+    ESP_LOGI(TAG, "Touch controller initialized");
+  } else {
+    ESP_LOGW(TAG, "Touch controller not available");
+  }
   vTaskDelay(pdMS_TO_TICKS(500));
 
   // Initialize WiFi and check for stored credentials
   ui_update_startup_status("Checking WiFi...");
   wifi_result_t wifi_result = wifi_manager_init();
+  energy_set(ENERGY_SUB_WIFI, true);  // Radio stays up in both station and AP mode
 
   if (wifi_result == WIFI_RESULT_CONNECTED) {
     ESP_LOGI(TAG, "WiFi connected successfully");
@@ -210,7 +521,7 @@ void app_main(void)
     ui_update_startup_status("Checking for updates...");
     if (ota_init() == ESP_OK) {
       ESP_LOGI(TAG, "OTA initialized");
-      esp_err_t ota_result = ota_check_and_update();
+      esp_err_t ota_result = ota_check_measuring_jitter();
       if (ota_result == ESP_OK) {
         const char* etag = ota_get_current_etag();
         if (etag) {
@@ -299,10 +610,20 @@ void app_main(void)
   esp_chip_info(&chip_info);
   ESP_LOGI(TAG, "Chip: %s, cores: %d, features: 0x%lx",
            CONFIG_IDF_TARGET, chip_info.cores, chip_info.features);
+  task_placement_log();
+  profiler_start();
   vTaskDelay(pdMS_TO_TICKS(500));
 
   // Transition to main screen
   ui_show_main_screen();
+  if (UI_BENCHMARK_FRAMES > 0) {
+    ui_benchmark_full_redraw(UI_BENCHMARK_FRAMES);
+    ui_benchmark_step_counter(UI_BENCHMARK_FRAMES, NULL);
+    int mismatches = ui_benchmark_screens();
+    if (mismatches > 0) {
+      ESP_LOGE(TAG, "UI benchmark: %d screen(s) miss their golden checksum or have none recorded", mismatches);
+    }
+  }
 
   // Start main application loop
   app_main_loop();
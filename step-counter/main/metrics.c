@@ -0,0 +1,178 @@
+#include "metrics.h"
+#include <stdatomic.h>
+#include <stdio.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+// Updates may come from ISRs that run while the flash cache is off
+#define METRICS_IRAM IRAM_ATTR
+#define METRICS_DRAM DRAM_ATTR
+#else
+#define METRICS_IRAM
+#define METRICS_DRAM
+#endif
+
+typedef struct {
+    const char *name;
+    metric_type_t type;
+    const uint32_t *bounds;  // Histograms: upper bound of each bucket but the last
+} metric_def_t;
+
+static METRICS_DRAM const uint32_t send_latency_bounds_us[METRICS_HIST_BUCKETS - 1] = {
+    250, 500, 1000, 2000, 5000, 10000, 50000
+};
+static METRICS_DRAM const uint32_t handshake_bounds_ms[METRICS_HIST_BUCKETS - 1] = {
+    250, 500, 750, 1000, 1500, 2500, 5000
+};
+
+static METRICS_DRAM const uint32_t debounce_late_bounds_us[METRICS_HIST_BUCKETS - 1] = {
+    10, 25, 50, 100, 250, 1000, 5000
+};
+
+static METRICS_DRAM const metric_def_t metric_defs[METRIC_COUNT] = {
+    [METRIC_STEPS_DROPPED] = {"steps_dropped", METRIC_TYPE_COUNTER, NULL},
+    [METRIC_WS_RECONNECTS] = {"ws_reconnects", METRIC_TYPE_COUNTER, NULL},
+    [METRIC_HEAP_LOW_WATER] = {"heap_low_water", METRIC_TYPE_GAUGE, NULL},
+    [METRIC_WS_SEND_LATENCY_US] = {"ws_send_latency_us", METRIC_TYPE_HISTOGRAM, send_latency_bounds_us},
+    [METRIC_TLS_HANDSHAKE_MS] = {"tls_handshake_ms", METRIC_TYPE_HISTOGRAM, handshake_bounds_ms},
+    [METRIC_CPU_BUSY_PERMILLE] = {"cpu_busy_permille", METRIC_TYPE_GAUGE, NULL},
+    [METRIC_STACK_FREE_MIN] = {"stack_free_min", METRIC_TYPE_GAUGE, NULL},
+    [METRIC_HEAP_LARGEST_FREE] = {"heap_largest_free", METRIC_TYPE_GAUGE, NULL},
+    [METRIC_DEBOUNCE_LATE_US] = {"debounce_late_us", METRIC_TYPE_HISTOGRAM, debounce_late_bounds_us},
+};
+
+static _Atomic uint32_t values[METRIC_COUNT] = {
+    [METRIC_HEAP_LOW_WATER] = UINT32_MAX,
+};
+static _Atomic uint32_t sums[METRIC_COUNT];
+static _Atomic uint32_t buckets[METRIC_COUNT][METRICS_HIST_BUCKETS];
+
+void METRICS_IRAM metrics_counter_add(metric_id_t id, uint32_t delta)
+{
+    atomic_fetch_add_explicit(&values[id], delta, memory_order_relaxed);
+}
+
+void METRICS_IRAM metrics_gauge_set(metric_id_t id, uint32_t value)
+{
+    atomic_store_explicit(&values[id], value, memory_order_relaxed);
+}
+
+void METRICS_IRAM metrics_gauge_min(metric_id_t id, uint32_t value)
+{
+    uint32_t current = atomic_load_explicit(&values[id], memory_order_relaxed);
+    while (value < current &&
+           !atomic_compare_exchange_weak_explicit(&values[id], &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void METRICS_IRAM metrics_histogram_record(metric_id_t id, uint32_t sample)
+{
+    const uint32_t *bounds = metric_defs[id].bounds;
+    int bucket = 0;
+    while (bucket < METRICS_HIST_BUCKETS - 1 && sample > bounds[bucket]) {
+        bucket++;
+    }
+    // Sum before bucket (release), so a snapshot that sees the bucket also sees the sum
+    atomic_fetch_add_explicit(&sums[id], sample, memory_order_relaxed);
+    atomic_fetch_add_explicit(&buckets[id][bucket], 1, memory_order_release);
+}
+
+void metrics_snapshot(metrics_snapshot_t *snap)
+{
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        metric_value_t *v = &snap->values[id];
+        if (metric_defs[id].type != METRIC_TYPE_HISTOGRAM) {
+            v->value = atomic_load_explicit(&values[id], memory_order_relaxed);
+            v->sum = 0;
+            for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+                v->buckets[b] = 0;
+            }
+            continue;
+        }
+        // Buckets first: sum then covers every counted sample, plus any still in flight
+        v->value = 0;
+        for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+            v->buckets[b] = atomic_load_explicit(&buckets[id][b], memory_order_acquire);
+            v->value += v->buckets[b];
+        }
+        v->sum = atomic_load_explicit(&sums[id], memory_order_relaxed);
+    }
+}
+
+const char *metrics_name(metric_id_t id)
+{
+    return id < METRIC_COUNT ? metric_defs[id].name : "?";
+}
+
+// snprintf that tracks the write position and remembers overflow
+static void append(char *buf, size_t size, size_t *pos, bool *overflow, const char *fmt, uint32_t value)
+{
+    if (*overflow) {
+        return;
+    }
+    int n = snprintf(buf + *pos, size - *pos, fmt, (unsigned long)value);
+    if (n < 0 || (size_t)n >= size - *pos) {
+        *overflow = true;
+        return;
+    }
+    *pos += n;
+}
+
+size_t metrics_format_frame(const metrics_snapshot_t *snap, uint32_t uptime_s, char *buf, size_t size)
+{
+    size_t pos = 0;
+    bool overflow = size == 0;
+
+    append(buf, size, &pos, &overflow, "{\"type\":\"metrics\",\"uptime_s\":%lu,\"m\":[", uptime_s);
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        const metric_value_t *v = &snap->values[id];
+        if (metric_defs[id].type != METRIC_TYPE_HISTOGRAM) {
+            append(buf, size, &pos, &overflow, id > 0 ? ",%lu" : "%lu", v->value);
+            continue;
+        }
+        append(buf, size, &pos, &overflow, id > 0 ? ",[%lu" : "[%lu", v->buckets[0]);
+        for (int b = 1; b < METRICS_HIST_BUCKETS; b++) {
+            append(buf, size, &pos, &overflow, ",%lu", v->buckets[b]);
+        }
+        append(buf, size, &pos, &overflow, ",%lu]", v->sum);
+    }
+    if (!overflow && size - pos > 2) {
+        buf[pos++] = ']';
+        buf[pos++] = '}';
+        buf[pos] = '\0';
+    } else {
+        overflow = true;
+    }
+    return overflow ? 0 : pos;
+}
+
+size_t metrics_format_text(const metrics_snapshot_t *snap, metric_id_t id, char *buf, size_t size)
+{
+    size_t pos = 0;
+    bool overflow = size == 0;
+    const metric_value_t *v = &snap->values[id];
+    const metric_def_t *def = &metric_defs[id];
+
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+    if (def->type != METRIC_TYPE_HISTOGRAM) {
+        int n = snprintf(buf, size, "%s %lu", def->name, (unsigned long)v->value);
+        return n < 0 ? 0 : ((size_t)n < size ? (size_t)n : size - 1);
+    }
+
+    int n = snprintf(buf, size, "%s n=%lu", def->name, (unsigned long)v->value);
+    if (n < 0 || (size_t)n >= size) {
+        return size > 0 ? size - 1 : 0;
+    }
+    pos = n;
+    append(buf, size, &pos, &overflow, " avg=%lu", v->value ? v->sum / v->value : 0);
+    for (int b = 0; b < METRICS_HIST_BUCKETS - 1; b++) {
+        char fmt[24];
+        snprintf(fmt, sizeof(fmt), " le%lu=%%lu", (unsigned long)def->bounds[b]);
+        append(buf, size, &pos, &overflow, fmt, v->buckets[b]);
+    }
+    append(buf, size, &pos, &overflow, " inf=%lu", v->buckets[METRICS_HIST_BUCKETS - 1]);
+    return pos;
+}
@@ -0,0 +1,105 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Runtime metrics registry. Every metric is declared in the table in
+ * metrics.c and updated with C11 atomics, so the update functions are safe
+ * from any task or ISR without locks. Plain C, so the same code runs on a
+ * host; host_test/test_metrics.c checks it from several threads at once.
+ */
+
+/** Buckets per histogram; the last one also collects everything above it */
+#define METRICS_HIST_BUCKETS 8
+
+/**
+ * @brief Registered metrics, in export order
+ */
+typedef enum {
+    METRIC_STEPS_DROPPED = 0,   ///< Counter: steps lost because the send buffer was full
+    METRIC_WS_RECONNECTS,       ///< Counter: WebSocket connections after the first
+    METRIC_HEAP_LOW_WATER,      ///< Gauge: lowest free heap seen, bytes
+    METRIC_WS_SEND_LATENCY_US,  ///< Histogram: time to hand a step to the WebSocket
+    METRIC_TLS_HANDSHAKE_MS,    ///< Histogram: WebSocket connect time including TLS
+    METRIC_CPU_BUSY_PERMILLE,   ///< Gauge: non-idle CPU share over the last profiler period
+    METRIC_STACK_FREE_MIN,      ///< Gauge: least free stack of any task, bytes
+    METRIC_HEAP_LARGEST_FREE,   ///< Gauge: largest free heap block, bytes (fragmentation)
+    METRIC_DEBOUNCE_LATE_US,    ///< Histogram: step debounce timer firing after its deadline
+    METRIC_COUNT
+} metric_id_t;
+
+typedef enum {
+    METRIC_TYPE_COUNTER,
+    METRIC_TYPE_GAUGE,
+    METRIC_TYPE_HISTOGRAM,
+} metric_type_t;
+
+/**
+ * @brief Copy of one metric taken by metrics_snapshot()
+ *
+ * For histograms, count is the sum of the buckets so a snapshot is always
+ * self-consistent; sum may include a sample whose bucket was not yet seen.
+ */
+typedef struct {
+    uint32_t value;                          ///< Counter or gauge value; histogram sample count
+    uint32_t sum;                            ///< Histogram: sum of samples
+    uint32_t buckets[METRICS_HIST_BUCKETS];  ///< Histogram: samples per bucket
+} metric_value_t;
+
+typedef struct {
+    metric_value_t values[METRIC_COUNT];
+} metrics_snapshot_t;
+
+/**
+ * @brief Add to a counter
+ */
+void metrics_counter_add(metric_id_t id, uint32_t delta);
+
+/**
+ * @brief Set a gauge
+ */
+void metrics_gauge_set(metric_id_t id, uint32_t value);
+
+/**
+ * @brief Lower a gauge to value if it is currently higher (low-water marks)
+ */
+void metrics_gauge_min(metric_id_t id, uint32_t value);
+
+/**
+ * @brief Record one histogram sample
+ */
+void metrics_histogram_record(metric_id_t id, uint32_t sample);
+
+/**
+ * @brief Read every metric
+ */
+void metrics_snapshot(metrics_snapshot_t *snap);
+
+/**
+ * @brief Metric name, as used in the console output
+ */
+const char *metrics_name(metric_id_t id);
+
+/**
+ * @brief Format a snapshot as a compact JSON uplink frame
+ *
+ * Values follow the metric_id_t order; histograms are arrays of their
+ * buckets followed by the sum. Bucket bounds are fixed in firmware, so
+ * they are not repeated in every frame:
+ *   {"type":"metrics","uptime_s":60,"m":[0,2,181234,[0,5,1,0,0,0,0,0,8412],[...]]}
+ *
+ * @return Length written (excluding the NUL), or 0 if buf is too small
+ */
+size_t metrics_format_frame(const metrics_snapshot_t *snap, uint32_t uptime_s, char *buf, size_t size);
+
+/**
+ * @brief Format one metric as a console line, e.g. "ws_send_latency_us n=8 avg=1051 le500=5 le1000=1 ..."
+ *
+ * @return Length written (excluding the NUL), truncated to fit
+ */
+size_t metrics_format_text(const metrics_snapshot_t *snap, metric_id_t id, char *buf, size_t size);
+
+#endif // METRICS_H
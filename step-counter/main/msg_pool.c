@@ -0,0 +1,117 @@
+#include "msg_pool.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "cJSON.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+static const char *TAG = "msg_pool";
+
+// Small blocks fit a cJSON node (about 40 bytes) or a short key/value string;
+// large ones fit a whole printed message
+#define SMALL_BLOCK_SIZE 64
+#define SMALL_BLOCKS 48
+#define LARGE_BLOCK_SIZE 512
+#define LARGE_BLOCKS 6
+
+typedef struct {
+    uint8_t *storage;
+    uint16_t block_size;
+    uint16_t blocks;
+    uint64_t free_mask;   // Bit set = block free
+    uint16_t in_use;
+    uint16_t peak;
+} pool_class_t;
+
+_Static_assert(SMALL_BLOCKS < 64 && LARGE_BLOCKS < 64, "free_mask holds fewer than 64 blocks");
+
+static uint8_t small_storage[SMALL_BLOCKS][SMALL_BLOCK_SIZE] __attribute__((aligned(8)));
+static uint8_t large_storage[LARGE_BLOCKS][LARGE_BLOCK_SIZE] __attribute__((aligned(8)));
+
+static pool_class_t classes[2] = {
+    {&small_storage[0][0], SMALL_BLOCK_SIZE, SMALL_BLOCKS, (1ULL << SMALL_BLOCKS) - 1, 0, 0},
+    {&large_storage[0][0], LARGE_BLOCK_SIZE, LARGE_BLOCKS, (1ULL << LARGE_BLOCKS) - 1, 0, 0},
+};
+
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t pool_allocs = 0;
+static uint32_t heap_fallbacks = 0;
+
+void *msg_pool_alloc(size_t size)
+{
+#if MSG_POOL_ENABLED
+    for (int c = 0; c < 2; c++) {
+        pool_class_t *pc = &classes[c];
+        if (size > pc->block_size) {
+            continue;
+        }
+        portENTER_CRITICAL(&pool_lock);
+        if (pc->free_mask != 0) {
+            int block = __builtin_ctzll(pc->free_mask);
+            pc->free_mask &= ~(1ULL << block);
+            pc->in_use++;
+            if (pc->in_use > pc->peak) {
+                pc->peak = pc->in_use;
+            }
+            pool_allocs++;
+            portEXIT_CRITICAL(&pool_lock);
+            return pc->storage + (size_t)block * pc->block_size;
+        }
+        portEXIT_CRITICAL(&pool_lock);
+        // Class exhausted; a larger class is still better than the heap
+    }
+    portENTER_CRITICAL(&pool_lock);
+    heap_fallbacks++;
+    portEXIT_CRITICAL(&pool_lock);
+#endif
+    return malloc(size);
+}
+
+void msg_pool_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    for (int c = 0; c < 2; c++) {
+        pool_class_t *pc = &classes[c];
+        uint8_t *p = ptr;
+        if (p >= pc->storage && p < pc->storage + (size_t)pc->blocks * pc->block_size) {
+            int block = (p - pc->storage) / pc->block_size;
+            portENTER_CRITICAL(&pool_lock);
+            pc->free_mask |= 1ULL << block;
+            pc->in_use--;
+            portEXIT_CRITICAL(&pool_lock);
+            return;
+        }
+    }
+    free(ptr);
+}
+
+void msg_pool_init(void)
+{
+#if MSG_POOL_ENABLED
+    cJSON_Hooks hooks = {
+        .malloc_fn = msg_pool_alloc,
+        .free_fn = msg_pool_free,
+    };
+    cJSON_InitHooks(&hooks);
+    ESP_LOGI(TAG, "cJSON using pools: %d x %d B + %d x %d B", SMALL_BLOCKS, SMALL_BLOCK_SIZE,
+             LARGE_BLOCKS, LARGE_BLOCK_SIZE);
+#else
+    ESP_LOGI(TAG, "Pools disabled; cJSON uses the general heap");
+#endif
+}
+
+void msg_pool_get_stats(msg_pool_stats_t *stats)
+{
+    portENTER_CRITICAL(&pool_lock);
+    for (int c = 0; c < 2; c++) {
+        stats->classes[c].block_size = classes[c].block_size;
+        stats->classes[c].blocks = classes[c].blocks;
+        stats->classes[c].in_use = classes[c].in_use;
+        stats->classes[c].peak = classes[c].peak;
+    }
+    stats->pool_allocs = pool_allocs;
+    stats->heap_fallbacks = heap_fallbacks;
+    portEXIT_CRITICAL(&pool_lock);
+}
@@ -0,0 +1,58 @@
+#ifndef MSG_POOL_H
+#define MSG_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Set to 0 to route every request to the general heap (for before/after comparisons) */
+#ifndef MSG_POOL_ENABLED
+#define MSG_POOL_ENABLED 1
+#endif
+
+/**
+ * @brief Usage of one size class
+ */
+typedef struct {
+    uint16_t block_size;   ///< Bytes per block
+    uint16_t blocks;       ///< Blocks in the class
+    uint16_t in_use;       ///< Blocks currently handed out
+    uint16_t peak;         ///< Most blocks ever in use at once
+} msg_pool_class_stats_t;
+
+/**
+ * @brief Pool usage
+ */
+typedef struct {
+    msg_pool_class_stats_t classes[2];   ///< Small (cJSON nodes, keys) and large (message text)
+    uint32_t pool_allocs;                ///< Requests served from a pool
+    uint32_t heap_fallbacks;             ///< Requests too big, or made while a class was full
+} msg_pool_stats_t;
+
+/**
+ * @brief Install the pools as cJSON's allocator
+ *
+ * cJSON builds every outgoing message from many small nodes and then
+ * prints it into one string; with the hooks installed both come from
+ * fixed slabs instead of the general heap.
+ */
+void msg_pool_init(void);
+
+/**
+ * @brief Allocate from the smallest class that fits, falling back to malloc
+ *
+ * @param size Bytes needed
+ * @return Block, or NULL if the heap fallback also failed
+ */
+void *msg_pool_alloc(size_t size);
+
+/**
+ * @brief Return a block from msg_pool_alloc(); heap fallbacks are freed normally
+ */
+void msg_pool_free(void *ptr);
+
+/**
+ * @brief Get pool usage
+ */
+void msg_pool_get_stats(msg_pool_stats_t *stats);
+
+#endif // MSG_POOL_H
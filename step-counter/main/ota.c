@@ -1,7 +1,12 @@
 #include "ota.h"
 #include "esp_log.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
+#include "esp_ota_ops.h"
+#include "ota_pipeline.h"
+#include "energy.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "ui.h"
@@ -89,11 +94,20 @@ const char* ota_get_current_etag(void)
 
 static char remote_etag[128] = {0};
 static bool etag_found = false;
+static ota_check_stats_t last_check_stats = {0};
+static uint64_t last_check_time_ms = 0;
+static bool check_has_run = false;
+static uint32_t check_interval_ms = OTA_CHECK_INTERVAL_MS;
 
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
     switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            // Fired once per TCP/TLS connection setup
+            last_check_stats.handshakes++;
+            break;
         case HTTP_EVENT_ON_HEADER:
+            last_check_stats.header_bytes += strlen(evt->header_key) + strlen(evt->header_value) + 4;
             if (strcasecmp(evt->header_key, "ETag") == 0) {
                 strncpy(remote_etag, evt->header_value, sizeof(remote_etag) - 1);
                 etag_found = true;
@@ -106,138 +120,183 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
     return ESP_OK;
 }
 
-static esp_err_t ota_check_etag(char *out_etag, size_t etag_size)
+static void ota_progress_callback(int image_size, int downloaded_bytes)
+{
+    static int last_percent = -1;
+    if (image_size <= 0) {
+        return;
+    }
+    int percent = (downloaded_bytes * 100) / image_size;
+
+    if (percent != last_percent) {
+        ESP_LOGI(TAG, "Download progress: %d%% (%d / %d bytes)", percent, downloaded_bytes, image_size);
+        ui_update_ota_progress(percent);
+        last_percent = percent;
+    }
+}
+
+static void ota_log_check_stats(void)
+{
+    ESP_LOGI(TAG, "Check stats: %lu handshake(s), %lu header bytes, %lu body bytes",
+             (unsigned long)last_check_stats.handshakes,
+             (unsigned long)last_check_stats.header_bytes,
+             (unsigned long)last_check_stats.body_bytes);
+}
+
+const ota_check_stats_t* ota_get_last_check_stats(void)
+{
+    return &last_check_stats;
+}
+
+void ota_set_check_interval_ms(uint32_t interval_ms)
+{
+    check_interval_ms = interval_ms;
+}
+
+bool ota_is_check_due(uint64_t now_ms)
+{
+    if (check_interval_ms == 0) {
+        return false;
+    }
+    if (!check_has_run) {
+        return true;
+    }
+    return now_ms - last_check_time_ms >= check_interval_ms;
+}
+
+esp_err_t ota_check_and_update(void)
 {
+    ESP_LOGI(TAG, "Checking for firmware updates...");
+
+    memset(&last_check_stats, 0, sizeof(last_check_stats));
     etag_found = false;
     remote_etag[0] = '\0';
+    last_check_time_ms = esp_timer_get_time() / 1000;
+    check_has_run = true;
 
-    esp_http_client_config_t config = {
+    // Single conditional GET: 304 if our ETag still matches, otherwise the
+    // image streams back on the same connection
+    esp_http_client_config_t http_config = {
         .url = FIRMWARE_URL,
         .cert_pem = amazon_root_ca,
         .event_handler = http_event_handler,
-        .method = HTTP_METHOD_HEAD,
-        .timeout_ms = 10000,
+        .timeout_ms = 30000,
+        .keep_alive_enable = true,
     };
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    esp_http_client_handle_t client = esp_http_client_init(&http_config);
     if (client == NULL) {
         ESP_LOGE(TAG, "Failed to initialize HTTP client");
         return ESP_FAIL;
     }
+    if (current_etag[0] != '\0') {
+        // Without the header every check would download the full image
+        esp_err_t header_err = esp_http_client_set_header(client, "If-None-Match", current_etag);
+        if (header_err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set If-None-Match: %s", esp_err_to_name(header_err));
+            esp_http_client_cleanup(client);
+            ota_log_check_stats();
+            return header_err;
+        }
+    }
 
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
-    esp_http_client_cleanup(client);
-
+    // Only the connect is charged to the TLS state; the download is plain WiFi traffic
+    energy_tls_begin();
+    esp_err_t err = esp_http_client_open(client, 0);
+    energy_tls_end();
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "HTTP HEAD request failed: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "HTTP open failed: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
         return err;
     }
 
+    int image_size = esp_http_client_fetch_headers(client);
+    int status_code = esp_http_client_get_status_code(client);
+
+    if (status_code == 304) {
+        ESP_LOGI(TAG, "Firmware is up to date (304 Not Modified)");
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
+        return ESP_OK;
+    }
+
     if (status_code == 404) {
         ESP_LOGW(TAG, "Firmware file not found (404)");
-        return ESP_ERR_NOT_FOUND;
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
+        return ESP_OK; // Not an error, just no update available
     }
 
     if (status_code != 200) {
-        ESP_LOGE(TAG, "HTTP HEAD returned status %d", status_code);
+        ESP_LOGE(TAG, "HTTP GET returned status %d", status_code);
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
         return ESP_FAIL;
     }
 
-    if (!etag_found || remote_etag[0] == '\0') {
-        ESP_LOGW(TAG, "No ETag header in response");
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    strncpy(out_etag, remote_etag, etag_size - 1);
-    return ESP_OK;
-}
-
-static void ota_progress_callback(int image_size, int downloaded_bytes)
-{
-    static int last_percent = -1;
-    int percent = (downloaded_bytes * 100) / image_size;
-
-    if (percent != last_percent) {
-        ESP_LOGI(TAG, "Download progress: %d%% (%d / %d bytes)", percent, downloaded_bytes, image_size);
-        ui_update_ota_progress(percent);
-        last_percent = percent;
+    // Servers that ignore If-None-Match still send the ETag; don't reflash the same image
+    if (etag_found && current_etag[0] != '\0' && strcmp(remote_etag, current_etag) == 0) {
+        ESP_LOGI(TAG, "Firmware is up to date (ETag match)");
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
+        return ESP_OK;
     }
-}
-
-esp_err_t ota_check_and_update(void)
-{
-    ESP_LOGI(TAG, "Checking for firmware updates...");
 
-    // Check remote ETag
     char new_etag[128] = {0};
-    esp_err_t err = ota_check_etag(new_etag, sizeof(new_etag));
-
-    if (err == ESP_ERR_NOT_FOUND) {
-        ESP_LOGI(TAG, "No firmware file available or no ETag");
-        return ESP_OK; // Not an error, just no update available
-    }
-
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to check ETag");
-        return err;
-    }
+    strncpy(new_etag, remote_etag, sizeof(new_etag) - 1);
 
-    // Compare ETags
-    if (current_etag[0] != '\0' && strcmp(new_etag, current_etag) == 0) {
-        ESP_LOGI(TAG, "Firmware is up to date (ETag match)");
-        return ESP_OK;
+    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
+    if (update_partition == NULL) {
+        ESP_LOGE(TAG, "No OTA partition available");
+        esp_http_client_cleanup(client);
+        ota_log_check_stats();
+        return ESP_ERR_NOT_FOUND;
     }
 
     ESP_LOGI(TAG, "New firmware available - downloading...");
+    ESP_LOGI(TAG, "Firmware size: %d bytes", image_size);
     ui_show_ota_status(true);
     ui_update_ota_progress(0);
 
-    // Configure OTA
-    esp_http_client_config_t http_config = {
-        .url = FIRMWARE_URL,
-        .cert_pem = amazon_root_ca,
-        .timeout_ms = 30000,
-        .keep_alive_enable = true,
-    };
-
-    esp_https_ota_config_t ota_config = {
-        .http_config = &http_config,
-    };
-
-    esp_https_ota_handle_t ota_handle = NULL;
-    err = esp_https_ota_begin(&ota_config, &ota_handle);
+    // Sectors are erased by the pipeline's writer task just ahead of the data
+    esp_ota_handle_t ota_handle = 0;
+    err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "OTA begin failed: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
         ui_show_ota_status(false);
         return err;
     }
 
-    int image_size = esp_https_ota_get_image_size(ota_handle);
-    ESP_LOGI(TAG, "Firmware size: %d bytes", image_size);
-
-    // Download with progress updates
-    while (1) {
-        err = esp_https_ota_perform(ota_handle);
-        if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
-            break;
-        }
+    // Download with progress updates; network reads and flash writes overlap
+    ota_pipeline_stats_t pipeline_stats = {0};
+    err = ota_pipeline_run(client, ota_handle, update_partition, image_size,
+                           ota_progress_callback, &pipeline_stats);
+    esp_http_client_cleanup(client);
 
-        int downloaded = esp_https_ota_get_image_len_read(ota_handle);
-        ota_progress_callback(image_size, downloaded);
-    }
+    last_check_stats.body_bytes = pipeline_stats.bytes;
+    ESP_LOGI(TAG, "Pipeline: %lu bytes in %lu ms (net %lu ms, write %lu ms, erase %lu ms, reader stalled %lu ms)",
+             (unsigned long)pipeline_stats.bytes, (unsigned long)pipeline_stats.total_ms,
+             (unsigned long)pipeline_stats.net_ms, (unsigned long)pipeline_stats.flash_write_ms,
+             (unsigned long)pipeline_stats.flash_erase_ms, (unsigned long)pipeline_stats.reader_stall_ms);
 
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "OTA download failed: %s", esp_err_to_name(err));
-        esp_https_ota_abort(ota_handle);
+        ota_log_check_stats();
+        esp_ota_abort(ota_handle);
         ui_show_ota_status(false);
         return err;
     }
 
     ui_update_ota_progress(100);
     ESP_LOGI(TAG, "Download complete, finishing OTA...");
+    ota_log_check_stats();
 
-    err = esp_https_ota_finish(ota_handle);
+    err = esp_ota_end(ota_handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(update_partition);
+    }
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "OTA finish failed: %s", esp_err_to_name(err));
         ui_show_ota_status(false);
@@ -245,7 +304,7 @@ esp_err_t ota_check_and_update(void)
     }
 
     // Save new ETag to NVS
-    err = ota_save_etag(new_etag);
+    err = new_etag[0] != '\0' ? ota_save_etag(new_etag) : ESP_ERR_NOT_FOUND;
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "Failed to save ETag, but OTA succeeded");
     }
@@ -3,6 +3,19 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/** Default interval between periodic update checks (0 disables them) */
+#define OTA_CHECK_INTERVAL_MS (6 * 60 * 60 * 1000)
+
+/**
+ * @brief Network cost of the most recent update check
+ */
+typedef struct {
+    uint32_t handshakes;    ///< TLS connections opened
+    uint32_t header_bytes;  ///< Approximate response header bytes received
+    uint32_t body_bytes;    ///< Firmware image bytes received
+} ota_check_stats_t;
 
 /**
  * @brief Initialize OTA system and load stored ETag from NVS
@@ -15,9 +28,9 @@ esp_err_t ota_init(void);
  * @brief Check for firmware updates and perform OTA if available
  *
  * This function:
- * 1. Checks the firmware URL for ETag
- * 2. Compares with stored ETag
- * 3. Downloads new firmware if different (with progress callback)
+ * 1. Sends a single GET with If-None-Match set to the stored ETag
+ * 2. Returns immediately on 304 Not Modified
+ * 3. Otherwise streams the new firmware on the same connection (with progress callback)
  * 4. Installs and reboots if successful
  *
  * @return ESP_OK if no update needed or update successful, error code otherwise
@@ -31,4 +44,26 @@ esp_err_t ota_check_and_update(void);
  */
 const char* ota_get_current_etag(void);
 
+/**
+ * @brief Check whether a periodic update check is due
+ *
+ * @param now_ms Current time in milliseconds since boot
+ * @return true if no check has run yet or the check interval has elapsed
+ */
+bool ota_is_check_due(uint64_t now_ms);
+
+/**
+ * @brief Set the interval between periodic update checks
+ *
+ * @param interval_ms Interval in milliseconds (0 disables periodic checks)
+ */
+void ota_set_check_interval_ms(uint32_t interval_ms);
+
+/**
+ * @brief Get handshake and byte counts for the most recent update check
+ *
+ * @return Pointer to the stats of the last check
+ */
+const ota_check_stats_t* ota_get_last_check_stats(void);
+
 #endif // OTA_H
@@ -0,0 +1,246 @@
+#include "ota_pipeline.h"
+#include "task_placement.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "ota_pipeline";
+
+// Pipeline configuration
+#define OTA_PIPELINE_BUFFERS 4
+#define OTA_PIPELINE_BUF_SIZE 4096
+#define OTA_PIPELINE_ERASE_AHEAD_SECTORS 4
+#define OTA_SECTOR_SIZE 4096
+
+typedef struct {
+    uint8_t idx;    ///< Ring slot holding the data
+    uint16_t len;   ///< Valid bytes in the slot (0 = end of stream)
+} ota_chunk_t;
+
+typedef struct {
+    esp_ota_handle_t ota_handle;
+    const esp_partition_t *partition;
+    uint32_t erase_limit;
+    uint8_t *buffers[OTA_PIPELINE_BUFFERS];
+    QueueHandle_t free_queue;
+    QueueHandle_t full_queue;
+    SemaphoreHandle_t done;
+    volatile uint32_t written;
+    volatile esp_err_t write_err;
+    int64_t write_us;
+    int64_t erase_us;
+} ota_pipeline_t;
+
+static esp_err_t erase_next_sector(ota_pipeline_t *p, uint32_t *erased_to)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(p->partition, *erased_to, OTA_SECTOR_SIZE);
+    p->erase_us += esp_timer_get_time() - start;
+    if (err == ESP_OK) {
+        *erased_to += OTA_SECTOR_SIZE;
+    }
+    return err;
+}
+
+/**
+ * @brief Flash writer task: programs full buffers and erases ahead while idle
+ */
+static void ota_writer_task(void *arg)
+{
+    ota_pipeline_t *p = (ota_pipeline_t *)arg;
+    uint32_t offset = 0;
+    uint32_t erased_to = 0;
+
+    while (1) {
+        // Use any gap in the incoming data to erase sectors ahead of the cursor
+        uint32_t erase_target = offset + OTA_PIPELINE_ERASE_AHEAD_SECTORS * OTA_SECTOR_SIZE;
+        if (erase_target > p->erase_limit) {
+            erase_target = p->erase_limit;
+        }
+        bool can_erase = p->write_err == ESP_OK && erased_to < erase_target;
+
+        ota_chunk_t chunk;
+        if (xQueueReceive(p->full_queue, &chunk, can_erase ? 0 : portMAX_DELAY) != pdTRUE) {
+            esp_err_t err = erase_next_sector(p, &erased_to);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Erase at 0x%lx failed: %s", (unsigned long)erased_to, esp_err_to_name(err));
+                p->write_err = err;
+            }
+            continue;
+        }
+
+        if (chunk.len == 0) {
+            break;
+        }
+
+        if (p->write_err == ESP_OK) {
+            // Data arrived faster than we pre-erased; catch up before writing
+            while (erased_to < offset + chunk.len && p->write_err == ESP_OK) {
+                p->write_err = erase_next_sector(p, &erased_to);
+            }
+        }
+
+        if (p->write_err == ESP_OK) {
+            int64_t start = esp_timer_get_time();
+            p->write_err = esp_ota_write_with_offset(p->ota_handle, p->buffers[chunk.idx], chunk.len, offset);
+            p->write_us += esp_timer_get_time() - start;
+            if (p->write_err != ESP_OK) {
+                ESP_LOGE(TAG, "Flash write at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(p->write_err));
+            }
+        }
+
+        // Keep draining after an error so the reader never blocks forever
+        offset += chunk.len;
+        p->written = offset;
+        xQueueSend(p->free_queue, &chunk.idx, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+static void ota_pipeline_free(ota_pipeline_t *p)
+{
+    for (int i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+        heap_caps_free(p->buffers[i]);
+    }
+    if (p->free_queue) {
+        vQueueDelete(p->free_queue);
+    }
+    if (p->full_queue) {
+        vQueueDelete(p->full_queue);
+    }
+    if (p->done) {
+        vSemaphoreDelete(p->done);
+    }
+}
+
+esp_err_t ota_pipeline_run(esp_http_client_handle_t client, esp_ota_handle_t ota_handle,
+                           const esp_partition_t *partition, int image_size,
+                           ota_pipeline_progress_cb_t progress_cb, ota_pipeline_stats_t *stats)
+{
+    if (client == NULL || partition == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (image_size > 0 && (uint32_t)image_size > partition->size) {
+        ESP_LOGE(TAG, "Image (%d bytes) larger than partition (%lu bytes)", image_size, (unsigned long)partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ota_pipeline_t p = {
+        .ota_handle = ota_handle,
+        .partition = partition,
+        .write_err = ESP_OK,
+    };
+
+    // Never erase past the end of the image when we know its size
+    p.erase_limit = partition->size;
+    if (image_size > 0) {
+        p.erase_limit = (image_size + OTA_SECTOR_SIZE - 1) & ~(OTA_SECTOR_SIZE - 1);
+    }
+
+    p.free_queue = xQueueCreate(OTA_PIPELINE_BUFFERS, sizeof(uint8_t));
+    p.full_queue = xQueueCreate(OTA_PIPELINE_BUFFERS + 1, sizeof(ota_chunk_t));
+    p.done = xSemaphoreCreateBinary();
+    if (p.free_queue == NULL || p.full_queue == NULL || p.done == NULL) {
+        ota_pipeline_free(&p);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint8_t i = 0; i < OTA_PIPELINE_BUFFERS; i++) {
+        p.buffers[i] = heap_caps_malloc(OTA_PIPELINE_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (p.buffers[i] == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate pipeline buffer %d", i);
+            ota_pipeline_free(&p);
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(p.free_queue, &i, 0);
+    }
+
+    if (task_placement_create(ota_writer_task, "ota_writer", 4096, &p, TASK_ROLE_NET, NULL) != pdPASS) {
+        ota_pipeline_free(&p);
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t net_us = 0;
+    int64_t stall_us = 0;
+    uint32_t received = 0;
+    esp_err_t err = ESP_OK;
+
+    while (p.write_err == ESP_OK) {
+        uint8_t idx;
+        int64_t wait_start = esp_timer_get_time();
+        xQueueReceive(p.free_queue, &idx, portMAX_DELAY);
+        stall_us += esp_timer_get_time() - wait_start;
+
+        // Fill the whole slot so the writer programs full pages
+        int fill = 0;
+        bool eof = false;
+        while (fill < OTA_PIPELINE_BUF_SIZE) {
+            int64_t read_start = esp_timer_get_time();
+            int len = esp_http_client_read(client, (char *)p.buffers[idx] + fill, OTA_PIPELINE_BUF_SIZE - fill);
+            net_us += esp_timer_get_time() - read_start;
+            if (len < 0) {
+                ESP_LOGE(TAG, "Network read failed (%d)", len);
+                err = ESP_FAIL;
+                break;
+            }
+            if (len == 0) {
+                eof = esp_http_client_is_complete_data_received(client) || image_size < 0;
+                if (!eof) {
+                    ESP_LOGE(TAG, "Connection closed after %lu bytes", (unsigned long)(received + fill));
+                    err = ESP_FAIL;
+                }
+                break;
+            }
+            fill += len;
+            if (image_size > 0 && received + fill >= (uint32_t)image_size) {
+                eof = true;
+                break;
+            }
+        }
+
+        if (fill > 0 && err == ESP_OK) {
+            ota_chunk_t chunk = { .idx = idx, .len = fill };
+            xQueueSend(p.full_queue, &chunk, portMAX_DELAY);
+            received += fill;
+        } else {
+            xQueueSend(p.free_queue, &idx, 0);
+        }
+
+        if (progress_cb) {
+            progress_cb(image_size, p.written);
+        }
+
+        if (err != ESP_OK || eof) {
+            break;
+        }
+    }
+
+    // Tell the writer we're done and wait for it to drain the ring
+    ota_chunk_t end = { .idx = 0, .len = 0 };
+    xQueueSend(p.full_queue, &end, portMAX_DELAY);
+    xSemaphoreTake(p.done, portMAX_DELAY);
+
+    if (err == ESP_OK) {
+        err = p.write_err;
+    }
+
+    if (stats) {
+        stats->bytes = p.written;
+        stats->total_ms = (esp_timer_get_time() - start_us) / 1000;
+        stats->net_ms = net_us / 1000;
+        stats->flash_write_ms = p.write_us / 1000;
+        stats->flash_erase_ms = p.erase_us / 1000;
+        stats->reader_stall_ms = stall_us / 1000;
+    }
+
+    ota_pipeline_free(&p);
+    return err;
+}
@@ -0,0 +1,53 @@
+#ifndef OTA_PIPELINE_H
+#define OTA_PIPELINE_H
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include <stdint.h>
+
+/**
+ * @brief Progress callback, invoked from the reader (calling) task
+ *
+ * @param image_size Total image size in bytes (-1 if unknown)
+ * @param written_bytes Bytes written to flash so far
+ */
+typedef void (*ota_pipeline_progress_cb_t)(int image_size, int written_bytes);
+
+/**
+ * @brief Timing breakdown of a pipelined download
+ */
+typedef struct {
+    uint32_t bytes;               ///< Image bytes received and written
+    uint32_t total_ms;            ///< Wall time for the whole transfer
+    uint32_t net_ms;              ///< Time the reader spent in esp_http_client_read
+    uint32_t flash_write_ms;      ///< Time the writer spent programming flash
+    uint32_t flash_erase_ms;      ///< Time the writer spent erasing sectors
+    uint32_t reader_stall_ms;     ///< Time the reader waited for a free buffer
+} ota_pipeline_stats_t;
+
+/**
+ * @brief Stream an HTTP response body into an OTA partition
+ *
+ * The calling task reads from the network into a ring of DMA-capable buffers
+ * while a separate writer task programs flash, erasing sectors ahead of the
+ * write cursor whenever it is waiting for data. The client must already have
+ * its headers fetched. The partition must have been opened with
+ * esp_ota_begin(..., OTA_WITH_SEQUENTIAL_WRITES, ...) so nothing is erased up front.
+ * host_test/test_ota_pipeline.c checks and times it against a paced network
+ * and file-backed flash.
+ *
+ * @param client HTTP client positioned at the start of the body
+ * @param ota_handle Handle returned by esp_ota_begin
+ * @param partition Target OTA partition
+ * @param image_size Content length, or -1 to read until the connection closes
+ * @param progress_cb Optional progress callback
+ * @param stats Optional output for timing statistics
+ * @return ESP_OK when the full image has been written, error code otherwise
+ */
+esp_err_t ota_pipeline_run(esp_http_client_handle_t client, esp_ota_handle_t ota_handle,
+                           const esp_partition_t *partition, int image_size,
+                           ota_pipeline_progress_cb_t progress_cb, ota_pipeline_stats_t *stats);
+
+#endif // OTA_PIPELINE_H
@@ -0,0 +1,204 @@
+#include "profiler.h"
+#include "esp_log.h"
+
+#if PROFILER_ENABLED
+#include "metrics.h"
+#include "task_placement.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+#ifndef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#error "PROFILER_ENABLED needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS"
+#endif
+
+static const char *TAG = "profiler";
+
+#define PROFILER_MAX_TASKS 32
+#define PROFILER_TASK_STACK 3072
+#define PROFILER_STACK_WARN_BYTES 512
+#define PROFILER_COUNTER_READS 1000
+
+// Task list buffers are static so a sample never allocates
+static TaskStatus_t status[PROFILER_MAX_TASKS];
+static UBaseType_t prev_numbers[PROFILER_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE prev_runtime[PROFILER_MAX_TASKS];
+static UBaseType_t prev_count = 0;
+static configRUN_TIME_COUNTER_TYPE prev_total = 0;
+
+static portMUX_TYPE report_lock = portMUX_INITIALIZER_UNLOCKED;
+static profiler_report_t last_report;
+static bool report_valid = false;
+static uint32_t counter_read_ns = 0;
+
+// What the kernel pays on each context switch to keep run-time stats
+static uint32_t measure_counter_read_ns(void)
+{
+    volatile configRUN_TIME_COUNTER_TYPE sink;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < PROFILER_COUNTER_READS; i++) {
+        sink = portGET_RUN_TIME_COUNTER_VALUE();
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    (void)sink;
+    return (uint32_t)(elapsed_us * 1000 / PROFILER_COUNTER_READS);
+}
+
+// Run time a task has used since the previous sample
+static configRUN_TIME_COUNTER_TYPE runtime_delta(const TaskStatus_t *task)
+{
+    for (UBaseType_t i = 0; i < prev_count; i++) {
+        if (prev_numbers[i] == task->xTaskNumber) {
+            return task->ulRunTimeCounter - prev_runtime[i];
+        }
+    }
+    return task->ulRunTimeCounter;  // Created since the previous sample
+}
+
+static void fill_entry(profiler_task_t *entry, const TaskStatus_t *task, uint64_t delta, uint64_t capacity)
+{
+    strlcpy(entry->name, task->pcTaskName, sizeof(entry->name));
+    entry->cpu_permille = capacity ? (uint16_t)(delta * 1000 / capacity) : 0;
+    entry->stack_free_min = task->usStackHighWaterMark;
+    entry->core = task->xCoreID == tskNO_AFFINITY ? -1 : (int8_t)task->xCoreID;
+}
+
+static void sample(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, PROFILER_MAX_TASKS, &total);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %d tasks; profiler skipped this period", PROFILER_MAX_TASKS);
+        return;
+    }
+
+    // Run-time counters tick once per microsecond on each core
+    uint64_t capacity = (uint64_t)(total - prev_total) * configNUMBER_OF_CORES;
+    bool first = prev_total == 0;
+
+    profiler_report_t report = {
+        .window_ms = (uint32_t)((total - prev_total) / 1000),
+        .task_count = count,
+        .tightest_stack_free = UINT32_MAX,
+    };
+    uint64_t top_delta[PROFILER_TOP_TASKS] = {0};
+    uint64_t idle_delta = 0;
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *task = &status[i];
+        uint64_t delta = runtime_delta(task);
+        if (strncmp(task->pcTaskName, "IDLE", 4) == 0) {
+            idle_delta += delta;
+        }
+
+        if (task->usStackHighWaterMark < report.tightest_stack_free) {
+            report.tightest_stack_free = task->usStackHighWaterMark;
+            strlcpy(report.tightest_stack_task, task->pcTaskName, sizeof(report.tightest_stack_task));
+        }
+
+        // Insertion into the busiest-first top list
+        int pos = report.top_count;
+        while (pos > 0 && delta > top_delta[pos - 1]) {
+            pos--;
+        }
+        if (pos >= PROFILER_TOP_TASKS) {
+            continue;
+        }
+        int last = report.top_count < PROFILER_TOP_TASKS ? report.top_count : PROFILER_TOP_TASKS - 1;
+        for (int j = last; j > pos; j--) {
+            top_delta[j] = top_delta[j - 1];
+            report.top[j] = report.top[j - 1];
+        }
+        top_delta[pos] = delta;
+        fill_entry(&report.top[pos], task, delta, capacity);
+        if (report.top_count < PROFILER_TOP_TASKS) {
+            report.top_count++;
+        }
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        prev_numbers[i] = status[i].xTaskNumber;
+        prev_runtime[i] = status[i].ulRunTimeCounter;
+    }
+    prev_count = count;
+    prev_total = total;
+
+    if (first) {
+        return;  // Deltas are since boot; wait for a full period
+    }
+
+    uint32_t busy_permille = capacity && idle_delta < capacity ? (uint32_t)(1000 - idle_delta * 1000 / capacity) : 0;
+    metrics_gauge_set(METRIC_CPU_BUSY_PERMILLE, busy_permille);
+    metrics_gauge_set(METRIC_STACK_FREE_MIN, report.tightest_stack_free);
+    report.sample_cost_us = (uint32_t)(esp_timer_get_time() - start_us);
+    report.counter_read_ns = counter_read_ns;
+
+    portENTER_CRITICAL(&report_lock);
+    last_report = report;
+    report_valid = true;
+    portEXIT_CRITICAL(&report_lock);
+
+    ESP_LOGI(TAG, "CPU %lu.%lu%% busy over %lu ms, %u tasks, sampling took %lu us, %lu ns per context switch",
+             (unsigned long)(busy_permille / 10), (unsigned long)(busy_permille % 10),
+             (unsigned long)report.window_ms, report.task_count, (unsigned long)report.sample_cost_us,
+             (unsigned long)report.counter_read_ns);
+    for (int i = 0; i < report.top_count; i++) {
+        const profiler_task_t *t = &report.top[i];
+        ESP_LOGI(TAG, "  %-16s %3u.%u%%  stack free %5lu  core %d", t->name,
+                 t->cpu_permille / 10, t->cpu_permille % 10, (unsigned long)t->stack_free_min, t->core);
+    }
+    if (report.tightest_stack_free < PROFILER_STACK_WARN_BYTES) {
+        ESP_LOGW(TAG, "Task %s has only %lu bytes of stack left", report.tightest_stack_task,
+                 (unsigned long)report.tightest_stack_free);
+    }
+}
+
+static void profiler_task(void *arg)
+{
+    while (1) {
+        sample();
+        vTaskDelay(pdMS_TO_TICKS(PROFILER_PERIOD_MS));
+    }
+}
+
+esp_err_t profiler_start(void)
+{
+    counter_read_ns = measure_counter_read_ns();
+    if (task_placement_create(profiler_task, "profiler", PROFILER_TASK_STACK, NULL,
+                              TASK_ROLE_BACKGROUND, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create profiler task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t profiler_get_report(profiler_report_t *report)
+{
+    portENTER_CRITICAL(&report_lock);
+    bool valid = report_valid;
+    if (valid) {
+        *report = last_report;
+    }
+    portEXIT_CRITICAL(&report_lock);
+    return valid ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+#else
+
+static const char *TAG = "profiler";
+
+esp_err_t profiler_start(void)
+{
+    ESP_LOGI(TAG, "Profiler not built (PROFILER_ENABLED=0)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t profiler_get_report(profiler_report_t *report)
+{
+    (void)report;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+/*
+ * Set to 0 to build without the sampling task. Defaults on when sdkconfig
+ * has CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, which the profiler reads.
+ *
+ * Run-time stats cost something even with the profiler off: the kernel reads
+ * the counter (esp_timer) on every context switch. The report carries the
+ * cost of one read, so the overhead is about context switches/s times
+ * counter_read_ns. Clear the option in sdkconfig to remove both.
+ */
+#ifndef PROFILER_ENABLED
+#ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+#endif
+
+/** Sampling period; each sample walks the task list once */
+#ifndef PROFILER_PERIOD_MS
+#define PROFILER_PERIOD_MS 60000
+#endif
+
+/** Tasks listed in each report, busiest first */
+#define PROFILER_TOP_TASKS 6
+
+/**
+ * @brief One task's share of the last sampling period
+ */
+typedef struct {
+    char name[16];
+    uint16_t cpu_permille;      ///< Share of total CPU time (all cores) in thousandths
+    uint32_t stack_free_min;    ///< Lowest free stack ever seen, bytes
+    int8_t core;                ///< Pinned core, -1 if unpinned
+} profiler_task_t;
+
+/**
+ * @brief Result of the last sampling period
+ */
+typedef struct {
+    uint32_t window_ms;                         ///< Length of the period
+    uint16_t task_count;                        ///< Tasks alive at the sample
+    uint16_t top_count;                         ///< Valid entries in top
+    profiler_task_t top[PROFILER_TOP_TASKS];    ///< Busiest tasks
+    char tightest_stack_task[16];               ///< Task with the least free stack
+    uint32_t tightest_stack_free;               ///< Its free stack, bytes
+    uint32_t sample_cost_us;                    ///< Time the profiler itself spent sampling
+    uint32_t counter_read_ns;                   ///< Kernel cost per context switch of keeping run-time stats
+} profiler_report_t;
+
+/**
+ * @brief Start the sampling task
+ *
+ * Needs CONFIG_FREERTOS_USE_TRACE_FACILITY and run-time stats.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if built with
+ *         PROFILER_ENABLED=0, error code otherwise
+ */
+esp_err_t profiler_start(void);
+
+/**
+ * @brief Get the report from the last completed period
+ *
+ * @param report Output report
+ * @return ESP_OK, ESP_ERR_INVALID_STATE before the first period completes,
+ *         or ESP_ERR_NOT_SUPPORTED if built with PROFILER_ENABLED=0
+ */
+esp_err_t profiler_get_report(profiler_report_t *report);
+
+#endif // PROFILER_H
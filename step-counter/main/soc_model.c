@@ -0,0 +1,145 @@
+#include "soc_model.h"
+#include <stddef.h>
+
+// Resting voltage against state of charge, highest first
+typedef struct {
+  int16_t mv;
+  int16_t soc_milli;
+} soc_point_t;
+
+static const soc_point_t discharge_curve[] = {
+  {SOC_MODEL_FULL_MV, 1000},
+  {4150, 950},
+  {4110, 900},
+  {4080, 850},
+  {4020, 800},
+  {3980, 750},
+  {3950, 700},
+  {3910, 650},
+  {3870, 600},
+  {3850, 550},
+  {3840, 500},
+  {3820, 450},
+  {3800, 400},
+  {3790, 350},
+  {3770, 300},
+  {3750, 250},
+  {3730, 200},
+  {3710, 150},
+  {3690, 100},
+  {3610, 50},
+  {SOC_MODEL_EMPTY_MV, 0},
+};
+
+#define CURVE_POINTS (sizeof(discharge_curve) / sizeof(discharge_curve[0]))
+
+void soc_model_init(soc_model_t *m)
+{
+  m->soc_q8 = 0;
+  m->valid = false;
+}
+
+int32_t soc_model_ocv_mv(int32_t loaded_mv, uint32_t load_ua)
+{
+  // uA * mOhm = nV
+  return loaded_mv + (int32_t)(((uint64_t)load_ua * SOC_MODEL_RINT_MOHM) / 1000000);
+}
+
+int soc_model_lookup_milli(int32_t ocv_mv)
+{
+  if (ocv_mv >= discharge_curve[0].mv) {
+    return discharge_curve[0].soc_milli;
+  }
+  for (size_t i = 1; i < CURVE_POINTS; i++) {
+    const soc_point_t *hi = &discharge_curve[i - 1];
+    const soc_point_t *lo = &discharge_curve[i];
+    if (ocv_mv >= lo->mv) {
+      return lo->soc_milli + (ocv_mv - lo->mv) * (hi->soc_milli - lo->soc_milli) / (hi->mv - lo->mv);
+    }
+  }
+  return 0;
+}
+
+int32_t soc_model_raw_filter_q8(int32_t prev_q8, int32_t sample, int shift)
+{
+  if (prev_q8 < 0) {
+    return sample << 8;
+  }
+  return prev_q8 + (((sample << 8) - prev_q8) >> shift);
+}
+
+int soc_model_update(soc_model_t *m, int32_t loaded_mv, uint32_t load_ua)
+{
+  int32_t target_q8 = (int32_t)soc_model_lookup_milli(soc_model_ocv_mv(loaded_mv, load_ua)) << 8;
+  if (!m->valid) {
+    m->soc_q8 = target_q8;
+    m->valid = true;
+  } else {
+    m->soc_q8 += (target_q8 - m->soc_q8) >> SOC_MODEL_FILTER_SHIFT;
+  }
+  return (m->soc_q8 + 128) >> 8;
+}
+
+#ifdef SOC_MODEL_HOST
+/*
+ * Host replay: reads the main task's "Battery: <V> V (raw <n>), load <uA> uA"
+ * log lines from stdin, prints the old linear estimate next to the model
+ * and summarises how far each one jumps between consecutive readings.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int linear_milli(int32_t mv)
+{
+  if (mv <= SOC_MODEL_EMPTY_MV) {
+    return 0;
+  }
+  if (mv >= SOC_MODEL_FULL_MV) {
+    return 1000;
+  }
+  return (mv - SOC_MODEL_EMPTY_MV) * 1000 / (SOC_MODEL_FULL_MV - SOC_MODEL_EMPTY_MV);
+}
+
+int main(void)
+{
+  soc_model_t m;
+  soc_model_init(&m);
+  char line[256];
+  int samples = 0;
+  int prev_linear = -1, prev_model = -1;
+  int max_jump_linear = 0, max_jump_model = 0;
+
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    const char *p = strstr(line, "Battery: ");
+    float volts;
+    int raw;
+    unsigned load_ua = 0;
+    if (p == NULL || sscanf(p, "Battery: %f V (raw %d), load %u uA", &volts, &raw, &load_ua) < 1) {
+      continue;
+    }
+    int32_t mv = (int32_t)(volts * 1000.0f + 0.5f);
+    int lin = linear_milli(mv);
+    int soc = soc_model_update(&m, mv, load_ua);
+    printf("%4d mV %6u uA  linear %5.1f%%  model %5.1f%%\n", (int)mv, load_ua, lin / 10.0, soc / 10.0);
+
+    if (samples > 0) {
+      int jl = abs(lin - prev_linear);
+      int jm = abs(soc - prev_model);
+      max_jump_linear = jl > max_jump_linear ? jl : max_jump_linear;
+      max_jump_model = jm > max_jump_model ? jm : max_jump_model;
+    }
+    prev_linear = lin;
+    prev_model = soc;
+    samples++;
+  }
+
+  if (samples == 0) {
+    fprintf(stderr, "no Battery: lines on stdin\n");
+    return 1;
+  }
+  printf("%d samples, largest step: linear %.1f%%, model %.1f%%\n", samples,
+         max_jump_linear / 10.0, max_jump_model / 10.0);
+  return 0;
+}
+#endif
@@ -0,0 +1,90 @@
+#ifndef SOC_MODEL_H
+#define SOC_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * State-of-charge model: load-compensated discharge-curve lookup followed
+ * by a fixed-point exponential filter. Integer math only, and no ESP-IDF
+ * dependencies so recorded discharge logs can be replayed on a host:
+ *
+ *   gcc -DSOC_MODEL_HOST -o soc_replay main/soc_model.c
+ *   grep "Battery:" discharge.log | ./soc_replay
+ *
+ * host_test/test_soc_model.c replays host_test/data/discharge.log, a
+ * synthetic log from host_test/data/gen_discharge.py, and checks the model
+ * against the coulomb-counted SoC recorded on each line.
+ */
+
+/* Ends of the discharge curve; the energy runtime estimate extrapolates to the same empty point */
+#define SOC_MODEL_EMPTY_MV 3300
+#define SOC_MODEL_FULL_MV 4200
+
+/* Cell + protection + wiring resistance used to undo the voltage sag under load */
+#ifndef SOC_MODEL_RINT_MOHM
+#define SOC_MODEL_RINT_MOHM 150
+#endif
+
+/* Each update moves the filtered SoC by 1/2^shift of the difference */
+#ifndef SOC_MODEL_FILTER_SHIFT
+#define SOC_MODEL_FILTER_SHIFT 2
+#endif
+
+/**
+ * @brief Filter state
+ */
+typedef struct {
+  int32_t soc_q8;   ///< Filtered state of charge in thousandths, Q24.8
+  bool valid;       ///< At least one sample has been seen
+} soc_model_t;
+
+/**
+ * @brief Reset the filter; the next sample is taken as-is
+ */
+void soc_model_init(soc_model_t *m);
+
+/**
+ * @brief Estimate the open-circuit voltage from a reading taken under load
+ *
+ * @param loaded_mv Measured battery voltage
+ * @param load_ua Current being drawn when the reading was taken
+ * @return Compensated voltage in millivolts
+ */
+int32_t soc_model_ocv_mv(int32_t loaded_mv, uint32_t load_ua);
+
+/**
+ * @brief Map an open-circuit voltage to state of charge on the discharge curve
+ *
+ * Piecewise-linear interpolation over a typical single-cell Li-ion curve,
+ * so the flat 3.7-3.9 V plateau covers most of the capacity.
+ *
+ * @param ocv_mv Open-circuit voltage in millivolts
+ * @return State of charge in thousandths (0-1000)
+ */
+int soc_model_lookup_milli(int32_t ocv_mv);
+
+/**
+ * @brief One step of the raw ADC filter: exponential moving average in Q24.8
+ *
+ * Rounds towards minus infinity, so a rising input settles up to
+ * 2^shift - 1 Q8 units (under one count) short and a falling one exactly.
+ *
+ * @param prev_q8 Previous output, negative before the first sample
+ * @param sample New reading in raw counts (non-negative)
+ * @param shift Each sample moves the estimate by 1/2^shift of the difference
+ * @return Filtered reading in Q24.8; the first sample is taken as-is
+ */
+int32_t soc_model_raw_filter_q8(int32_t prev_q8, int32_t sample, int shift);
+
+/**
+ * @brief Feed one voltage reading through compensation, lookup and filter
+ *
+ * @param m Filter state
+ * @param loaded_mv Measured battery voltage
+ * @param load_ua Current being drawn when the reading was taken
+ * @return Filtered state of charge in thousandths (0-1000)
+ */
+int soc_model_update(soc_model_t *m, int32_t loaded_mv, uint32_t load_ua);
+
+#endif // SOC_MODEL_H
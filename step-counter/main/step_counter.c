@@ -1,12 +1,18 @@
 #include "step_counter.h"
 #include "websocket_client.h"
+#include "metrics.h"
+#include "binlog.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_mac.h"
 #include "driver/gpio.h"
+#include "driver/gpio_filter.h"
+#include "esp_intr_alloc.h"
+#include "soc/soc_caps.h"
+#include "debounce_core.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "cJSON.h"
+#include "msg_pool.h"
 #include <string.h>
 
 static const char *TAG = "step_counter";
@@ -15,6 +21,21 @@ static const char *TAG = "step_counter";
 #define STEP_GPIO 18
 #define MAX_BUFFERED_STEPS 100
 #define DEBOUNCE_MS 80
+#define STEP_MESSAGE_SIZE 128
+#define STEP_GLITCH_WINDOW_NS 1000  // Flex filter window, where the chip has one
+
+// Capture mode: run the debounce timer from the esp_timer ISR instead of its
+// task, so step timing does not depend on what else is queued on that task
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+#define STEP_CAPTURE_ISR 1
+#else
+#define STEP_CAPTURE_ISR 0
+#endif
+
+// Log every edge and acceptance for replay with the host build of debounce_core.c
+#ifndef STEP_EDGE_TRACE
+#define STEP_EDGE_TRACE 0
+#endif
 
 // Step buffer
 static uint64_t step_buffer[MAX_BUFFERED_STEPS];
@@ -29,10 +50,9 @@ static volatile uint32_t total_steps = 0;
 static volatile uint64_t last_step_time_ms = 0;
 static volatile bool wifi_reconnect_needed = false;
 
-// Debouncing state
-static volatile int last_stable_level = -1;  // Last confirmed stable pin state
-static volatile int pending_level = -1;       // Pin level being debounced
-static volatile uint32_t level_change_time_ms = 0;  // When current level was first seen
+// Debouncing state; the lock also covers the step buffer indices
+static debounce_t debouncer;
+static portMUX_TYPE debounce_lock = portMUX_INITIALIZER_UNLOCKED;
 static esp_timer_handle_t debounce_timer = NULL;
 
 // MAC address (cached)
@@ -40,33 +60,50 @@ static char device_mac[18] = {0};
 
 /**
  * @brief Timer callback to confirm debounced state change
+ *
+ * Runs in the esp_timer ISR when STEP_CAPTURE_ISR is enabled, so it must
+ * stay in IRAM and call nothing that can block.
  */
 static void IRAM_ATTR debounce_timer_callback(void *arg)
 {
-    // Read current pin level
+    int64_t now_us = esp_timer_get_time();
     int current_level = gpio_get_level(STEP_GPIO);
 
-    // Check if pin is still in the pending state
-    if (current_level == pending_level && pending_level != last_stable_level) {
-        // Pin has been stable in new state for 80ms - accept the change
-        last_stable_level = pending_level;
+    portENTER_CRITICAL_SAFE(&debounce_lock);
+    uint64_t deadline_us = debouncer.deadline_us;
+    bool accepted = debounce_expire(&debouncer, current_level);
+    portEXIT_CRITICAL_SAFE(&debounce_lock);
 
-        // Record when this step occurred
-        last_step_time_ms = esp_timer_get_time() / 1000;
-
-        // Signal that WiFi reconnection may be needed
-        wifi_reconnect_needed = true;
-
-        // Increment total step counter
-        total_steps++;
-
-        // Add timestamp to buffer if not full
-        if (step_buffer_size < MAX_BUFFERED_STEPS) {
-            uint64_t timestamp_ms = last_step_time_ms;
-            step_buffer[step_buffer_write_idx] = timestamp_ms;
-            step_buffer_write_idx = (step_buffer_write_idx + 1) % MAX_BUFFERED_STEPS;
-            step_buffer_size++;
-        }
+    metrics_histogram_record(METRIC_DEBOUNCE_LATE_US,
+                             now_us > (int64_t)deadline_us ? (uint32_t)(now_us - deadline_us) : 0);
+    if (!accepted) {
+        return;
+    }
+#if STEP_EDGE_TRACE
+    BINLOG(BL_STEP_ACCEPTED, (uint32_t)now_us);
+#endif
+
+    // Pin has been stable in the new state for DEBOUNCE_MS - count the step
+    last_step_time_ms = now_us / 1000;
+
+    // Signal that WiFi reconnection may be needed
+    wifi_reconnect_needed = true;
+
+    // Increment total step counter
+    total_steps++;
+
+    // Add timestamp to buffer if not full. The flush runs in a task on
+    // either core, so the size update is taken under the lock
+    portENTER_CRITICAL_SAFE(&debounce_lock);
+    bool stored = step_buffer_size < MAX_BUFFERED_STEPS;
+    if (stored) {
+        step_buffer[step_buffer_write_idx] = last_step_time_ms;
+        step_buffer_write_idx = (step_buffer_write_idx + 1) % MAX_BUFFERED_STEPS;
+        step_buffer_size++;
+    }
+    portEXIT_CRITICAL_SAFE(&debounce_lock);
+    if (!stored) {
+        metrics_counter_add(METRIC_STEPS_DROPPED, 1);
     }
 }
 
@@ -75,30 +112,68 @@ static void IRAM_ATTR debounce_timer_callback(void *arg)
  */
 static void IRAM_ATTR step_isr_handler(void *arg)
 {
-    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    int64_t now_us = esp_timer_get_time();
     int current_level = gpio_get_level(STEP_GPIO);
 
-    // If this is the first interrupt, just record the initial state
-    if (last_stable_level == -1) {
-        last_stable_level = current_level;
-        return;
-    }
+#if STEP_EDGE_TRACE
+    BINLOG(BL_STEP_EDGE, (uint32_t)now_us, current_level);
+#endif
 
-    // If level is same as stable state, ignore it
-    if (current_level == last_stable_level) {
-        pending_level = -1;
-        return;
+    portENTER_CRITICAL_ISR(&debounce_lock);
+    debounce_action_t action = debounce_edge(&debouncer, current_level, now_us);
+    portEXIT_CRITICAL_ISR(&debounce_lock);
+
+    switch (action) {
+    case DEBOUNCE_ARM:
+        // Start/restart the debounce window from this edge
+        esp_timer_stop(debounce_timer);
+        esp_timer_start_once(debounce_timer, DEBOUNCE_MS * 1000);
+        break;
+    case DEBOUNCE_CANCEL:
+        esp_timer_stop(debounce_timer);
+        break;
+    default:
+        break;
     }
+}
 
-    // Level has changed - start/restart debounce timer
-    if (pending_level != current_level) {
-        pending_level = current_level;
-        level_change_time_ms = now_ms;
+/**
+ * @brief Enable the hardware glitch filter on the step input
+ *
+ * Pulses shorter than the filter window never raise an interrupt, so
+ * contact chatter is dropped before it reaches the ISR. The pin filter is a
+ * fixed couple of clock cycles; chips with flex filters get a configurable
+ * window instead.
+ */
+static void enable_glitch_filter(void)
+{
+    gpio_glitch_filter_handle_t filter = NULL;
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+
+#if SOC_GPIO_FLEX_GLITCH_FILTER_NUM > 0
+    gpio_flex_glitch_filter_config_t flex_config = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = STEP_GPIO,
+        .window_width_ns = STEP_GLITCH_WINDOW_NS,
+        .window_thres_ns = STEP_GLITCH_WINDOW_NS,
+    };
+    err = gpio_new_flex_glitch_filter(&flex_config, &filter);
+#elif SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+    gpio_pin_glitch_filter_config_t pin_config = {
+        .clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT,
+        .gpio_num = STEP_GPIO,
+    };
+    err = gpio_new_pin_glitch_filter(&pin_config, &filter);
+#endif
 
-        // Start the debounce timer (will fire after DEBOUNCE_MS)
-        esp_timer_stop(debounce_timer);
-        esp_timer_start_once(debounce_timer, DEBOUNCE_MS * 1000);  // Convert ms to microseconds
+    if (err == ESP_OK) {
+        err = gpio_glitch_filter_enable(filter);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No glitch filter on GPIO %d: %s", STEP_GPIO, esp_err_to_name(err));
+        return;
     }
+    ESP_LOGI(TAG, "Glitch filter enabled on GPIO %d", STEP_GPIO);
 }
 
 esp_err_t step_counter_init(void)
@@ -116,11 +191,17 @@ esp_err_t step_counter_init(void)
              mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     ESP_LOGI(TAG, "Device MAC: %s", device_mac);
 
+    debounce_init(&debouncer, DEBOUNCE_MS * 1000);
+
     // Create debounce timer
     esp_timer_create_args_t timer_args = {
         .callback = debounce_timer_callback,
         .arg = NULL,
+#if STEP_CAPTURE_ISR
+        .dispatch_method = ESP_TIMER_ISR,
+#else
         .dispatch_method = ESP_TIMER_TASK,
+#endif
         .name = "step_debounce"
     };
 
@@ -145,8 +226,12 @@ esp_err_t step_counter_init(void)
         return err;
     }
 
-    // Install ISR service
-    err = gpio_install_isr_service(0);
+    enable_glitch_filter();
+
+    // Install ISR service in IRAM so step edges are still taken while flash is
+    // being written (OTA, NVS). Shared with touch.c, which uses the same flags.
+    // main.c normally installs it on the UI core first, making this a no-op
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
     if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
         // ESP_ERR_INVALID_STATE means service is already installed, which is fine
         ESP_LOGE(TAG, "Failed to install ISR service: %s", esp_err_to_name(err));
@@ -160,7 +245,7 @@ esp_err_t step_counter_init(void)
         return err;
     }
 
-    ESP_LOGI(TAG, "Step counter initialized successfully");
+    ESP_LOGI(TAG, "Step counter initialized (%s debounce timer)", STEP_CAPTURE_ISR ? "ISR" : "task");
     return ESP_OK;
 }
 
@@ -198,49 +283,30 @@ esp_err_t step_counter_flush_one(void)
 
     // Build JSON message matching the format from the Arduino version
     // {"action":"sendStep","data":{"sent_at":1234567890.123,"deviceMAC":"XX:XX:XX:XX:XX:XX"}}
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        ESP_LOGE(TAG, "Failed to create JSON root");
-        return ESP_ERR_NO_MEM;
-    }
-
-    cJSON_AddStringToObject(root, "action", "sendStep");
-
-    cJSON *data = cJSON_CreateObject();
-    if (data == NULL) {
-        cJSON_Delete(root);
-        ESP_LOGE(TAG, "Failed to create JSON data object");
-        return ESP_ERR_NO_MEM;
-    }
-
-    // Convert milliseconds to seconds with 3 decimal places
-    double sent_at = (double)timestamp_ms / 1000.0;
-    cJSON_AddNumberToObject(data, "sent_at", sent_at);
-    cJSON_AddStringToObject(data, "deviceMAC", device_mac);
-
-    cJSON_AddItemToObject(root, "data", data);
-
-    // Generate JSON string
-    char *json_string = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
+    // Formatted straight into a pool block: this runs for every step, so it stays off the heap
+    char *json_string = msg_pool_alloc(STEP_MESSAGE_SIZE);
     if (json_string == NULL) {
-        ESP_LOGE(TAG, "Failed to generate JSON string");
+        ESP_LOGE(TAG, "Failed to allocate step message");
         return ESP_ERR_NO_MEM;
     }
+    int len = snprintf(json_string, STEP_MESSAGE_SIZE,
+                       "{\"action\":\"sendStep\",\"data\":{\"sent_at\":%llu.%03u,\"deviceMAC\":\"%s\"}}",
+                       (unsigned long long)(timestamp_ms / 1000), (unsigned)(timestamp_ms % 1000), device_mac);
 
     ESP_LOGD(TAG, "Sending step: %s", json_string);
 
     // Send via WebSocket with minimal timeout for fastest transmission
     esp_websocket_client_handle_t ws_client = websocket_client_get_handle();
     if (ws_client == NULL) {
-        free(json_string);
+        msg_pool_free(json_string);
         ESP_LOGE(TAG, "WebSocket client handle is NULL");
         return ESP_ERR_INVALID_STATE;
     }
 
-    int sent = esp_websocket_client_send_text(ws_client, json_string, strlen(json_string), pdMS_TO_TICKS(100));
-    free(json_string);
+    int64_t send_start_us = esp_timer_get_time();
+    int sent = esp_websocket_client_send_text(ws_client, json_string, len, pdMS_TO_TICKS(100));
+    metrics_histogram_record(METRIC_WS_SEND_LATENCY_US, (uint32_t)(esp_timer_get_time() - send_start_us));
+    msg_pool_free(json_string);
 
     if (sent < 0) {
         ESP_LOGE(TAG, "Failed to send step data");
@@ -248,10 +314,12 @@ esp_err_t step_counter_flush_one(void)
     }
 
     // Successfully sent - remove from buffer
+    portENTER_CRITICAL(&debounce_lock);
     step_buffer_read_idx = (step_buffer_read_idx + 1) % MAX_BUFFERED_STEPS;
     step_buffer_size--;
+    portEXIT_CRITICAL(&debounce_lock);
 
-    ESP_LOGD(TAG, "Step sent successfully, %d steps remaining in buffer", step_buffer_size);
+    BINLOG(BL_STEP_SENT, step_buffer_size);
 
     return ESP_OK;
 }
@@ -0,0 +1,108 @@
+#include "step_history.h"
+#include <stdbool.h>
+
+#define MS_PER_MINUTE (60 * 1000ULL)
+#define MS_PER_HOUR (60 * MS_PER_MINUTE)
+#define BUCKET_MAX INT16_MAX
+
+// A ring of fixed-width time buckets with a running total
+typedef struct {
+    int16_t *buckets;
+    uint16_t size;
+    uint16_t head;          // Index of the current (newest) bucket
+    uint64_t head_period;   // Period number of the current bucket
+    uint32_t total;
+    bool started;
+} bucket_ring_t;
+
+static int16_t minute_buckets[STEP_HISTORY_MINUTES];
+static int16_t hour_buckets[STEP_HISTORY_HOURS];
+
+static bucket_ring_t minutes = { .buckets = minute_buckets, .size = STEP_HISTORY_MINUTES };
+static bucket_ring_t hours = { .buckets = hour_buckets, .size = STEP_HISTORY_HOURS };
+static uint32_t version = 0;
+
+static bool ring_advance(bucket_ring_t *ring, uint64_t period)
+{
+    if (!ring->started) {
+        ring->started = true;
+        ring->head_period = period;
+        return false;
+    }
+    if (period <= ring->head_period) {
+        return false;
+    }
+
+    // Clear every bucket we skip over; a long gap clears at most the whole ring
+    uint64_t gap = period - ring->head_period;
+    if (gap > ring->size) {
+        gap = ring->size;
+    }
+    for (uint64_t i = 0; i < gap; i++) {
+        ring->head = (ring->head + 1) % ring->size;
+        ring->total -= ring->buckets[ring->head];
+        ring->buckets[ring->head] = 0;
+    }
+    ring->head_period = period;
+    return true;
+}
+
+static void ring_add(bucket_ring_t *ring, uint32_t steps)
+{
+    // Clamp first so a huge count cannot wrap negative in the int32 sum
+    if (steps > BUCKET_MAX) {
+        steps = BUCKET_MAX;
+    }
+    int32_t value = ring->buckets[ring->head] + (int32_t)steps;
+    if (value > BUCKET_MAX) {
+        value = BUCKET_MAX;
+    }
+    ring->total += value - ring->buckets[ring->head];
+    ring->buckets[ring->head] = (int16_t)value;
+}
+
+void step_history_add(uint64_t now_ms, uint32_t steps)
+{
+    bool rolled = ring_advance(&minutes, now_ms / MS_PER_MINUTE);
+    rolled |= ring_advance(&hours, now_ms / MS_PER_HOUR);
+
+    if (steps > 0) {
+        ring_add(&minutes, steps);
+        ring_add(&hours, steps);
+    }
+
+    if (rolled || steps > 0) {
+        version++;
+    }
+}
+
+const int16_t *step_history_minutes(uint16_t *oldest)
+{
+    if (oldest) {
+        *oldest = (minutes.head + 1) % minutes.size;
+    }
+    return minute_buckets;
+}
+
+const int16_t *step_history_hours(uint16_t *oldest)
+{
+    if (oldest) {
+        *oldest = (hours.head + 1) % hours.size;
+    }
+    return hour_buckets;
+}
+
+uint32_t step_history_last_hour_total(void)
+{
+    return minutes.total;
+}
+
+uint32_t step_history_last_day_total(void)
+{
+    return hours.total;
+}
+
+uint32_t step_history_get_version(void)
+{
+    return version;
+}
@@ -0,0 +1,61 @@
+#ifndef STEP_HISTORY_H
+#define STEP_HISTORY_H
+
+#include <stdint.h>
+
+#define STEP_HISTORY_MINUTES 60
+#define STEP_HISTORY_HOURS 24
+
+/**
+ * @brief Add steps to the history at the given time
+ *
+ * Rolls the minute and hour buckets forward to now_ms (clearing any that
+ * have expired) and adds the steps to the current buckets. Amortized O(1);
+ * call with steps = 0 to just advance time. Buckets saturate at INT16_MAX
+ * and the totals sum the saturated buckets; host_test/test_step_history.c
+ * checks this and times a simulated week.
+ *
+ * @param now_ms Current time in milliseconds since boot
+ * @param steps Number of new steps since the previous call
+ */
+void step_history_add(uint64_t now_ms, uint32_t steps);
+
+/**
+ * @brief Get the steps-per-minute ring for the last hour
+ *
+ * The array has STEP_HISTORY_MINUTES entries and is updated in place; the
+ * oldest bucket is at index *oldest and the newest just before it.
+ *
+ * @param oldest Output: index of the oldest bucket
+ * @return Pointer to the bucket ring
+ */
+const int16_t *step_history_minutes(uint16_t *oldest);
+
+/**
+ * @brief Get the steps-per-hour ring for the last day
+ *
+ * Same layout as step_history_minutes() with STEP_HISTORY_HOURS entries.
+ *
+ * @param oldest Output: index of the oldest bucket
+ * @return Pointer to the bucket ring
+ */
+const int16_t *step_history_hours(uint16_t *oldest);
+
+/**
+ * @brief Get total steps over the last hour (sum of minute buckets)
+ */
+uint32_t step_history_last_hour_total(void);
+
+/**
+ * @brief Get total steps over the last day (sum of hour buckets)
+ */
+uint32_t step_history_last_day_total(void);
+
+/**
+ * @brief Get a counter that changes whenever any bucket changes
+ *
+ * Lets the UI skip chart refreshes when nothing has moved.
+ */
+uint32_t step_history_get_version(void);
+
+#endif // STEP_HISTORY_H
@@ -0,0 +1,89 @@
+#include "task_placement.h"
+#include "esp_log.h"
+
+static const char *TAG = "task_placement";
+
+// Shared priority every task used before the split
+#define UNSPLIT_TASK_PRIO 5
+
+// An unsplit baseline with lwIP or esp_timer still pinned is not the old layout
+#if !TASK_PLACEMENT_SPLIT && \
+    !(defined(CONFIG_LWIP_TCPIP_TASK_AFFINITY_NO_AFFINITY) && defined(CONFIG_ESP_TIMER_TASK_AFFINITY_NO_AFFINITY))
+#define UNSPLIT_SYSTEM_TASKS_PINNED 1
+#warning "TASK_PLACEMENT_SPLIT=0 with lwIP or esp_timer pinned in sdkconfig: not the old unpinned layout"
+#else
+#define UNSPLIT_SYSTEM_TASKS_PINNED 0
+#endif
+
+// Core the esp_timer interrupt (and with it the ISR-dispatched debounce timer) runs on
+#if defined(CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1)
+#define ESP_TIMER_ISR_CORE "1"
+#elif defined(CONFIG_ESP_TIMER_ISR_AFFINITY_CPU0)
+#define ESP_TIMER_ISR_CORE "0"
+#else
+#define ESP_TIMER_ISR_CORE "any"
+#endif
+
+// Tasks shown in the placement table (created by us, ESP-IDF or managed components)
+static const char *const known_tasks[] = {
+    "lv_task",
+    "main",
+    "websocket_task",
+    "ota_check",
+    "ota_writer",
+    "battery",
+    "binlog",
+    "profiler",
+    "tiT",
+    "wifi",
+    "sys_evt",
+    "esp_timer",
+};
+
+UBaseType_t task_placement_priority(task_role_t role)
+{
+    if (role == TASK_ROLE_BACKGROUND) {
+        return BG_TASK_PRIO;
+    }
+#if TASK_PLACEMENT_SPLIT
+    return role == TASK_ROLE_UI ? UI_TASK_PRIO : NET_TASK_PRIO;
+#else
+    (void)role;
+    return UNSPLIT_TASK_PRIO;
+#endif
+}
+
+BaseType_t task_placement_create(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                 void *arg, task_role_t role, TaskHandle_t *handle)
+{
+#if TASK_PLACEMENT_SPLIT
+    BaseType_t core = role == TASK_ROLE_UI ? UI_TASK_CORE : NET_TASK_CORE;
+#else
+    BaseType_t core = tskNO_AFFINITY;
+#endif
+    if (role == TASK_ROLE_BACKGROUND) {
+        core = tskNO_AFFINITY;
+    }
+    return xTaskCreatePinnedToCore(fn, name, stack_size, arg, task_placement_priority(role), handle, core);
+}
+
+void task_placement_log(void)
+{
+    ESP_LOGI(TAG, "Task placement (split %s):", TASK_PLACEMENT_SPLIT ? "on" : "off");
+    if (UNSPLIT_SYSTEM_TASKS_PINNED) {
+        ESP_LOGW(TAG, "  lwIP/esp_timer pinned by sdkconfig; this is not the old unpinned layout");
+    }
+    for (size_t i = 0; i < sizeof(known_tasks) / sizeof(known_tasks[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(known_tasks[i]);
+        if (task == NULL) {
+            continue;
+        }
+        BaseType_t core = xTaskGetCoreID(task);
+        if (core == tskNO_AFFINITY) {
+            ESP_LOGI(TAG, "  %-16s core any  prio %u", known_tasks[i], (unsigned)uxTaskPriorityGet(task));
+        } else {
+            ESP_LOGI(TAG, "  %-16s core %d    prio %u", known_tasks[i], (int)core, (unsigned)uxTaskPriorityGet(task));
+        }
+    }
+    ESP_LOGI(TAG, "  %-16s core %s    (interrupt)", "esp_timer ISR", ESP_TIMER_ISR_CORE);
+}
@@ -0,0 +1,81 @@
+#ifndef TASK_PLACEMENT_H
+#define TASK_PLACEMENT_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/*
+ * Core and priority assignment for the application's own tasks.
+ *
+ * Step capture and LVGL rendering run on the UI core. Capture is interrupt
+ * driven: the GPIO ISR service, installed from a UI-core task in main.c, and
+ * the ISR-dispatched debounce timer (CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1, or
+ * the esp_timer task's CONFIG_ESP_TIMER_TASK_AFFINITY where ISR dispatch is
+ * unavailable). WiFi, lwIP (CONFIG_LWIP_TCPIP_TASK_AFFINITY), the main task,
+ * the OTA check task with its TLS handshakes, the WebSocket client and the
+ * OTA writer run on the network core. Low-rate housekeeping
+ * (battery sampling, the binary log drain, the profiler) runs unpinned below
+ * both, on whichever core is idle.
+ *
+ * Build with TASK_PLACEMENT_SPLIT=0 to leave our tasks unpinned at the old
+ * shared priority for comparison. That only covers tasks created here: the
+ * lwIP and esp_timer tasks keep the cores sdkconfig pins them to. For the
+ * old layout also set CONFIG_LWIP_TCPIP_TASK_AFFINITY_NO_AFFINITY and
+ * CONFIG_ESP_TIMER_TASK_AFFINITY_NO_AFFINITY; the build warns otherwise.
+ */
+#ifndef TASK_PLACEMENT_SPLIT
+#define TASK_PLACEMENT_SPLIT 1
+#endif
+
+#ifndef UI_TASK_CORE
+#define UI_TASK_CORE 1
+#endif
+#ifndef UI_TASK_PRIO
+#define UI_TASK_PRIO 6
+#endif
+
+#ifndef NET_TASK_CORE
+#define NET_TASK_CORE 0
+#endif
+#ifndef NET_TASK_PRIO
+#define NET_TASK_PRIO 5
+#endif
+
+#ifndef BG_TASK_PRIO
+#define BG_TASK_PRIO 1
+#endif
+
+typedef enum {
+    TASK_ROLE_UI = 0,       ///< Rendering and input
+    TASK_ROLE_NET,          ///< Networking, TLS and OTA
+    TASK_ROLE_BACKGROUND,   ///< Housekeeping; unpinned and at the same priority split or not
+} task_role_t;
+
+/**
+ * @brief Create a task on the core and at the priority assigned to its role
+ *
+ * @param fn Task function
+ * @param name Task name (also used in the placement table)
+ * @param stack_size Stack size in bytes
+ * @param arg Task argument
+ * @param role Role that decides core and priority
+ * @param handle Optional output for the task handle
+ * @return pdPASS on success, as xTaskCreatePinnedToCore
+ */
+BaseType_t task_placement_create(TaskFunction_t fn, const char *name, uint32_t stack_size,
+                                 void *arg, task_role_t role, TaskHandle_t *handle);
+
+/**
+ * @brief Get the priority assigned to a role
+ */
+UBaseType_t task_placement_priority(task_role_t role);
+
+/**
+ * @brief Log the core affinity and priority of every known task that is running
+ *
+ * Covers our own tasks plus the WiFi, lwIP, event loop, esp_timer and
+ * WebSocket tasks, so the effective placement can be checked at runtime.
+ */
+void task_placement_log(void);
+
+#endif // TASK_PLACEMENT_H
@@ -1,30 +1,152 @@
 #include "touch.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_lcd_panel_io.h"
+#include "driver/gpio.h"
+#include "esp_intr_alloc.h"
+#include "esp_attr.h"
+#include "driver/i2c_master.h"
 
 #define LCD_H_RES 240
 #define LCD_V_RES 320
 #define LCD_PIN_RST -1
 
+/* Touch I2C configuration */
+#define TOUCH_I2C_PORT I2C_NUM_0
+#define TOUCH_PIN_SDA 48
+#define TOUCH_PIN_SCL 47
+#define TOUCH_PIN_INT 46
+#define TOUCH_I2C_SPEED_HZ (400 * 1000)
+
 static const char *TAG = "touch";
 
-esp_lcd_touch_handle_t touch_init(esp_lcd_panel_io_handle_t io_handle)
+static esp_lcd_touch_handle_t touch_handle = NULL;
+static touch_notify_cb_t notify_cb = NULL;
+static volatile bool irq_pending = false;
+static volatile uint64_t last_touch_time_ms = 0;
+static bool last_pressed = false;
+static volatile uint32_t read_count = 0;
+
+// Installed by esp_lcd_touch directly as the GPIO handler. The shared GPIO ISR
+// service is IRAM-only (the step input must fire during flash writes), so
+// this, the notify callback and everything they call must stay in IRAM/DRAM
+static void IRAM_ATTR touch_isr_cb(esp_lcd_touch_handle_t tp)
+{
+  (void)tp;
+  irq_pending = true;
+  last_touch_time_ms = esp_timer_get_time() / 1000;
+  if (notify_cb) {
+    notify_cb();
+  }
+}
+
+esp_lcd_touch_handle_t touch_init(void)
 {
   ESP_LOGI(TAG, "Initializing touch controller");
 
-  esp_lcd_touch_handle_t tp = NULL;
+  i2c_master_bus_config_t bus_config = {
+      .i2c_port = TOUCH_I2C_PORT,
+      .sda_io_num = TOUCH_PIN_SDA,
+      .scl_io_num = TOUCH_PIN_SCL,
+      .clk_source = I2C_CLK_SRC_DEFAULT,
+      .glitch_ignore_cnt = 7,
+      .flags.enable_internal_pullup = true,
+  };
+  i2c_master_bus_handle_t bus = NULL;
+  esp_lcd_panel_io_handle_t io_handle = NULL;
+  esp_err_t err = i2c_new_master_bus(&bus_config, &bus);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to create I2C bus: %s", esp_err_to_name(err));
+    return NULL;
+  }
+
+  esp_lcd_panel_io_i2c_config_t io_config = ESP_LCD_TOUCH_IO_I2C_CST816S_CONFIG();
+  io_config.scl_speed_hz = TOUCH_I2C_SPEED_HZ;
+  err = esp_lcd_new_panel_io_i2c(bus, &io_config, &io_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to create touch panel IO: %s", esp_err_to_name(err));
+    goto err_bus;
+  }
+
+  // The interrupt handler is attached through the GPIO ISR service; same flags as step_counter.c.
+  // main.c normally installs it on the UI core first, making this a no-op. The service is
+  // shared with the step input, so it is left installed on failure
+  err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "Failed to install ISR service: %s", esp_err_to_name(err));
+    goto err_io;
+  }
+
   esp_lcd_touch_config_t tp_config = {
       .x_max = LCD_H_RES,
       .y_max = LCD_V_RES,
       .rst_gpio_num = LCD_PIN_RST,
-      .int_gpio_num = -1,
+      .int_gpio_num = TOUCH_PIN_INT,
       .levels = {
           .reset = 0,
           .interrupt = 0,
       },
+      .interrupt_callback = touch_isr_cb,
   };
 
-  ESP_ERROR_CHECK(esp_lcd_touch_new_i2c_cst816s(io_handle, &tp_config, &tp));
-  ESP_LOGI(TAG, "Touch controller initialized");
+  err = esp_lcd_touch_new_i2c_cst816s(io_handle, &tp_config, &touch_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to create touch controller: %s", esp_err_to_name(err));
+    touch_handle = NULL;
+    goto err_io;
+  }
+  ESP_LOGI(TAG, "Touch controller initialized (interrupt on GPIO %d%s)", TOUCH_PIN_INT,
+           TOUCH_POLLED ? ", reads polled" : "");
+
+  return touch_handle;
+
+err_io:
+  esp_lcd_panel_io_del(io_handle);
+err_bus:
+  i2c_del_master_bus(bus);
+  return NULL;
+}
+
+void touch_set_notify_cb(touch_notify_cb_t cb)
+{
+  notify_cb = cb;
+}
+
+bool touch_has_pending(void)
+{
+  return irq_pending;
+}
+
+bool touch_read(uint16_t *x, uint16_t *y, bool *pressed)
+{
+  if (touch_handle == NULL) {
+    return false;
+  }
+
+  // No interrupt and nothing held down: the controller has nothing new
+  if (!TOUCH_POLLED && !irq_pending && !last_pressed) {
+    return false;
+  }
+  irq_pending = false;
 
-  return tp;
+  read_count++;
+  if (esp_lcd_touch_read_data(touch_handle) != ESP_OK) {
+    return false;
+  }
+
+  uint16_t strength = 0;
+  uint8_t count = 0;
+  last_pressed = esp_lcd_touch_get_coordinates(touch_handle, x, y, &strength, &count, 1) && count > 0;
+  *pressed = last_pressed;
+  return true;
+}
+
+uint64_t touch_get_last_activity_ms(void)
+{
+  return last_touch_time_ms;
+}
+
+uint32_t touch_get_read_count(void)
+{
+  return read_count;
 }
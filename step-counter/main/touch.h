@@ -1,14 +1,71 @@
 #ifndef TOUCH_H
 #define TOUCH_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_lcd_touch_cst816s.h"
 
+/*
+ * Build with TOUCH_POLLED=1 to read the controller on every LVGL input
+ * period like a polled driver, for comparing the "Touch: N I2C reads" log
+ * line against the default interrupt-gated reads.
+ */
+#ifndef TOUCH_POLLED
+#define TOUCH_POLLED 0
+#endif
+
 /**
- * @brief Initialize touch controller
+ * @brief Callback invoked from the touch interrupt (ISR context)
+ */
+typedef void (*touch_notify_cb_t)(void);
+
+/**
+ * @brief Initialize the touch controller on its own I2C bus
+ *
+ * Brings up the I2C bus, creates the CST816S driver and attaches its
+ * interrupt line so the controller is only read after it signals a touch.
  *
- * @param io_handle LCD IO handle from display initialization
- * @return Touch handle
+ * @return Touch handle, or NULL if the controller could not be initialized
+ */
+esp_lcd_touch_handle_t touch_init(void);
+
+/**
+ * @brief Register a callback to run from the touch interrupt
+ *
+ * @param cb Callback (must be ISR-safe and IRAM_ATTR: the GPIO ISR service
+ *           runs with the flash cache disabled), or NULL to clear
+ */
+void touch_set_notify_cb(touch_notify_cb_t cb);
+
+/**
+ * @brief Check whether the controller has signalled since the last read
+ */
+bool touch_has_pending(void);
+
+/**
+ * @brief Read the current touch point if the controller has signalled
+ *
+ * Performs an I2C transaction only when an interrupt is pending or the
+ * previous read reported a press (to detect release), or on every call
+ * when built with TOUCH_POLLED.
+ *
+ * @param x Output: X coordinate when pressed
+ * @param y Output: Y coordinate when pressed
+ * @param pressed Output: true while the panel is touched
+ * @return true if the controller was read, false if nothing has changed
+ */
+bool touch_read(uint16_t *x, uint16_t *y, bool *pressed);
+
+/**
+ * @brief Get time of last touch interrupt in milliseconds
+ *
+ * @return Timestamp of last touch (0 if never touched)
+ */
+uint64_t touch_get_last_activity_ms(void);
+
+/**
+ * @brief Get total number of I2C reads issued to the controller
  */
-esp_lcd_touch_handle_t touch_init(esp_lcd_panel_io_handle_t io_handle);
+uint32_t touch_get_read_count(void);
 
 #endif // TOUCH_H
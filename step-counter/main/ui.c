@@ -1,15 +1,30 @@
 #include "ui.h"
+#include "display.h"
+#include "digit_counter.h"
+#include "touch.h"
+#include "step_history.h"
+#include "task_placement.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "lvgl.h"
+#include <assert.h>
 #include <string.h>
 
-#define LCD_H_RES 240
-#define LCD_V_RES 320
-#define LVGL_TICK_MS 5
+// Upper bound on how long lv_task sleeps when LVGL reports no pending timers
+#define LVGL_MAX_IDLE_MS 1000
+
+// Height of each internal DMA bounce buffer used to stream the PSRAM framebuffer
+#define UI_FB_BOUNCE_LINES 20
+#define UI_FB_BOUNCE_PIXELS (LCD_H_RES * UI_FB_BOUNCE_LINES)
+
+// Refresh period while an animation is running (~60 fps). Static screens refresh
+// only on change, so this no longer has to be CONFIG_LV_DISP_DEF_REFR_PERIOD's
+// compromise between smooth animation and idle wakeups
+#define LVGL_ANIM_REFR_PERIOD_MS 16
 
 static const char *TAG = "ui";
 
@@ -18,22 +33,108 @@ static lv_disp_draw_buf_t draw_buf;
 static lv_disp_drv_t disp_drv;
 static lv_disp_drv_t *cached_disp_drv = NULL;
 static lv_color_t *disp_buf1 = NULL;
+static lv_color_t *disp_buf2 = NULL;
+
+// PSRAM framebuffer mode (CONFIG_SPIRAM, octal PSRAM on the S3R8 module): LVGL renders dirty areas in place, flush streams them out
+static lv_color_t *psram_fb = NULL;
+static lv_color_t *bounce_buf[2] = {NULL, NULL};
+static int bounce_next = 0;
+static SemaphoreHandle_t bounce_free = NULL;
+static uint32_t last_render_ms = 0;
+static uint32_t last_render_px = 0;
+
+// Last values written to the main screen labels (view model cache)
+static ui_view_model_t rendered_vm;
+static bool rendered_vm_valid = false;
+
+// Render accounting for ui_get_render_stats
+static volatile uint32_t invalidated_px_total = 0;
+static volatile uint32_t flushed_px_total = 0;
+static volatile uint32_t label_writes_total = 0;
+static volatile uint32_t label_skips_total = 0;
+static uint32_t stats_window_invalidated_px = 0;
+static uint32_t stats_window_flushed_px = 0;
+static uint32_t stats_window_label_writes = 0;
+static uint32_t stats_window_label_skips = 0;
+static int64_t stats_window_start_us = 0;
 static lv_obj_t *label_adc = NULL;
 static lv_obj_t *label_voltage = NULL;
 static lv_obj_t *label_percent = NULL;
 static lv_obj_t *label_steps = NULL;
+static lv_obj_t *step_digits = NULL;
 static lv_obj_t *label_buffer_count = NULL;
 static lv_obj_t *label_wifi_status = NULL;
 static lv_obj_t *label_ws_status = NULL;
+static lv_obj_t *label_runtime = NULL;
 static lv_obj_t *label_power_timers = NULL;
 static lv_obj_t *label_startup_status = NULL;
 static lv_obj_t *startup_spinner = NULL;
 static lv_obj_t *qr_code = NULL;
 static lv_obj_t *main_container = NULL;
+static lv_obj_t *history_container = NULL;
+static lv_obj_t *history_minute_chart = NULL;
+static lv_obj_t *history_hour_chart = NULL;
+static lv_chart_series_t *history_minute_series = NULL;
+static lv_chart_series_t *history_hour_series = NULL;
+static lv_obj_t *label_history_totals = NULL;
+static uint32_t history_rendered_version = UINT32_MAX;
 static lv_obj_t *ota_overlay = NULL;
+static uint32_t ota_overlay_footprint = 0;
 static lv_obj_t *ota_label = NULL;
 static lv_obj_t *ota_bar = NULL;
 static SemaphoreHandle_t lvgl_api_mux = NULL;
+static TaskHandle_t lvgl_task_handle = NULL;
+static lv_indev_drv_t touch_indev_drv;
+static lv_indev_t *touch_indev = NULL;
+static volatile bool lvgl_active = true;
+static volatile uint32_t lvgl_wakeups_total = 0;
+static uint32_t stats_window_lvgl_wakeups = 0;
+
+// How late lv_task wakes after a timed sleep (scheduling jitter)
+#define UI_JITTER_PROBE_MS 10
+static volatile bool jitter_probe = false;
+static uint32_t jitter_max_us = 0;
+static uint64_t jitter_sum_us = 0;
+static uint32_t jitter_samples = 0;
+
+// Refresh governor: frames and SPI traffic accounted to the mode they were drawn in
+static ui_refresh_mode_t refresh_mode = UI_REFRESH_EVENT;
+static int64_t refresh_mode_since_us = 0;
+static uint64_t refresh_mode_us[UI_REFRESH_MODE_COUNT];
+static uint32_t refresh_frames[UI_REFRESH_MODE_COUNT];
+static uint64_t refresh_spi_bytes[UI_REFRESH_MODE_COUNT];
+static int64_t stats_window_refresh_start_us = 0;
+static uint64_t stats_window_mode_us[UI_REFRESH_MODE_COUNT];
+static uint32_t stats_window_frames[UI_REFRESH_MODE_COUNT];
+static uint64_t stats_window_spi_bytes[UI_REFRESH_MODE_COUNT];
+
+// Screen manager: only the current screen's objects exist
+typedef enum
+{
+  UI_SCREEN_NONE = -1,
+  UI_SCREEN_STARTUP = 0,
+  UI_SCREEN_QR,
+  UI_SCREEN_MAIN,
+  UI_SCREEN_HISTORY,
+  UI_SCREEN_COUNT
+} ui_screen_t;
+
+static ui_screen_t current_screen = UI_SCREEN_NONE;
+static uint32_t screen_footprint[UI_SCREEN_COUNT];
+static char qr_screen_data[100];
+static char qr_screen_message[64];
+static ui_view_model_t latest_vm;
+static bool latest_vm_set = false;
+
+static void show_screen(ui_screen_t id);
+static void apply_status(const ui_view_model_t *vm);
+static void apply_power_timers(const ui_view_model_t *vm);
+
+// Frame checksum for the screen benchmark (FNV-1a over flushed pixels)
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+static bool checksum_enabled = false;
+static uint32_t frame_checksum = FNV_OFFSET_BASIS;
 
 static bool lvgl_lock(int timeout_ms)
 {
@@ -43,58 +144,292 @@ static bool lvgl_lock(int timeout_ms)
   return xSemaphoreTakeRecursive(lvgl_api_mux, timeout_ticks) == pdTRUE;
 }
 
+static void lvgl_wake(void)
+{
+  if (lvgl_task_handle != NULL && lvgl_active)
+    xTaskNotifyGive(lvgl_task_handle);
+}
+
 static void lvgl_unlock(void)
 {
+  // Wake the handler task if this caller left work for it (dirty areas or new animations)
+  bool wake = false;
+  if (lvgl_task_handle != NULL && xTaskGetCurrentTaskHandle() != lvgl_task_handle)
+  {
+    lv_disp_t *disp = lv_disp_get_default();
+    wake = (disp != NULL && disp->inv_p != 0) || lv_anim_count_running() > 0;
+  }
   xSemaphoreGiveRecursive(lvgl_api_mux);
+  if (wake)
+    lvgl_wake();
 }
 
 bool notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
+  if (psram_fb != NULL)
+  {
+    // Framebuffer mode: a bounce buffer has been sent and can be refilled
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(bounce_free, &woken);
+    return woken == pdTRUE;
+  }
   lv_disp_flush_ready(&disp_drv);
   return false;
 }
 
+static void checksum_bytes(const void *data, size_t len)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < len; i++)
+    frame_checksum = (frame_checksum ^ bytes[i]) * FNV_PRIME;
+}
+
+/**
+ * Copy a dirty area out of the PSRAM framebuffer through the two internal
+ * bounce buffers. The framebuffer is free for LVGL as soon as the last rows
+ * are copied; DMA completion only gates reuse of the bounce buffers.
+ */
+static esp_err_t flush_from_framebuffer(const lv_area_t *area)
+{
+  int w = lv_area_get_width(area);
+  int chunk_lines = UI_FB_BOUNCE_PIXELS / w;
+
+  for (int y = area->y1; y <= area->y2; y += chunk_lines)
+  {
+    int lines = area->y2 - y + 1;
+    if (lines > chunk_lines)
+      lines = chunk_lines;
+
+    xSemaphoreTake(bounce_free, portMAX_DELAY);
+    lv_color_t *dst = bounce_buf[bounce_next];
+    bounce_next ^= 1;
+
+    for (int row = 0; row < lines; row++)
+      memcpy(dst + row * w, psram_fb + (y + row) * LCD_H_RES + area->x1, w * sizeof(lv_color_t));
+    if (checksum_enabled)
+      checksum_bytes(dst, w * lines * sizeof(lv_color_t));
+
+    esp_err_t err = esp_lcd_panel_draw_bitmap(panel_handle, area->x1, y, area->x2 + 1, y + lines, dst);
+    if (err != ESP_OK)
+    {
+      // No transfer was queued, so no DMA-done interrupt will release this buffer
+      xSemaphoreGive(bounce_free);
+      return err;
+    }
+  }
+  return ESP_OK;
+}
+
+// Wait until nothing rendered is still being sent to the panel
+static void wait_flush_idle(void)
+{
+  while (draw_buf.flushing)
+    vTaskDelay(1);
+  if (psram_fb != NULL)
+  {
+    while (uxSemaphoreGetCount(bounce_free) < 2)
+      vTaskDelay(1);
+  }
+}
+
 static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
   cached_disp_drv = drv;
+  flushed_px_total += lv_area_get_size(area);
+  refresh_spi_bytes[refresh_mode] += lv_area_get_size(area) * sizeof(lv_color_t);
+  if (psram_fb != NULL)
+  {
+    esp_err_t err = flush_from_framebuffer(area);
+    if (err != ESP_OK)
+      ESP_LOGE(TAG, "Framebuffer flush failed: %s", esp_err_to_name(err));
+    lv_disp_flush_ready(drv);
+    return;
+  }
+  if (checksum_enabled)
+    checksum_bytes(color_map, lv_area_get_size(area) * sizeof(lv_color_t));
   int offsetx1 = area->x1;
   int offsetx2 = area->x2;
   int offsety1 = area->y1;
   int offsety2 = area->y2;
-  esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
-  // lv_disp_flush_ready will be called by notify_lvgl_flush_ready when DMA completes
+  esp_err_t err = esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
+  if (err != ESP_OK)
+  {
+    // Nothing was queued, so the DMA-done callback will not hand the buffer back
+    ESP_LOGE(TAG, "Band flush failed: %s", esp_err_to_name(err));
+    lv_disp_flush_ready(drv);
+  }
+  // Otherwise lv_disp_flush_ready will be called by notify_lvgl_flush_ready when DMA completes
 }
 
-static void lv_tick_task(void *arg)
+static void lvgl_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px)
 {
-  (void)arg;
-  TickType_t delay_ticks = pdMS_TO_TICKS(LVGL_TICK_MS);
-  if (delay_ticks == 0)
-    delay_ticks = 1;
-  while (1)
+  (void)drv;
+  last_render_ms = time_ms;
+  last_render_px = px;
+  invalidated_px_total += px;
+  refresh_frames[refresh_mode]++;
+
+  static bool first_frame_logged = false;
+  if (!first_frame_logged)
+  {
+    ESP_LOGI(TAG, "First LVGL frame rendered %lld us after boot", esp_timer_get_time());
+    first_frame_logged = true;
+  }
+}
+
+static void set_refresh_mode(ui_refresh_mode_t mode)
+{
+  if (mode == refresh_mode)
+    return;
+
+  int64_t now_us = esp_timer_get_time();
+  refresh_mode_us[refresh_mode] += now_us - refresh_mode_since_us;
+  refresh_mode_since_us = now_us;
+  refresh_mode = mode;
+}
+
+/**
+ * Pick the refresh timer's behaviour for the next handler pass. While an
+ * animation runs the timer fires every LVGL_ANIM_REFR_PERIOD_MS; otherwise
+ * it stays paused and is only made ready when something was invalidated, so
+ * a static screen costs no wakeups between updates. Caller holds the lock.
+ * Returns the longest lv_task may sleep before the next refresh is due.
+ */
+static uint32_t refresh_governor_update(void)
+{
+  lv_disp_t *disp = lv_disp_get_default();
+  if (disp == NULL || disp->refr_timer == NULL)
+    return LV_NO_TIMER_READY;
+
+  if (lv_anim_count_running() > 0)
+  {
+    set_refresh_mode(UI_REFRESH_ANIMATING);
+    lv_timer_set_period(disp->refr_timer, LVGL_ANIM_REFR_PERIOD_MS);
+    lv_timer_resume(disp->refr_timer);
+    return disp->inv_p != 0 ? 0 : LVGL_ANIM_REFR_PERIOD_MS;
+  }
+
+  set_refresh_mode(UI_REFRESH_EVENT);
+  if (disp->inv_p != 0)
   {
-    lv_tick_inc(LVGL_TICK_MS);
-    vTaskDelay(delay_ticks);
+    lv_timer_resume(disp->refr_timer);
+    lv_timer_ready(disp->refr_timer);
+    return 0;
   }
+
+  lv_timer_pause(disp->refr_timer);
+  return LV_NO_TIMER_READY;
 }
 
 static void lv_task(void *arg)
 {
   (void)arg;
-  TickType_t task_delay = pdMS_TO_TICKS(5);
-  if (task_delay == 0)
-    task_delay = 1;
   while (1)
   {
-    if (lvgl_lock(500))
+    uint32_t delay_ms = LVGL_MAX_IDLE_MS;
+    if (lvgl_active && lvgl_lock(500))
     {
-      lv_task_handler();
+      // The touch read timer only runs while the controller has something to report
+      if (touch_indev != NULL && touch_has_pending())
+        lv_timer_resume(touch_indev->driver->read_timer);
+      refresh_governor_update();
+      // lv_timer_handler returns the time until the next LVGL timer is due
+      delay_ms = lv_timer_handler();
+      // Event callbacks may have invalidated areas or started animations while the refresh timer was paused
+      uint32_t refresh_ms = refresh_governor_update();
+      if (refresh_ms < delay_ms)
+        delay_ms = refresh_ms;
       lvgl_unlock();
     }
-    vTaskDelay(task_delay);
+
+    // While probing, cap the sleep so a static screen still takes timed wakeups to measure
+    if (jitter_probe && lvgl_active && (delay_ms == LV_NO_TIMER_READY || delay_ms > UI_JITTER_PROBE_MS))
+      delay_ms = UI_JITTER_PROBE_MS;
+
+    TickType_t wait_ticks;
+    if (!lvgl_active || delay_ms == LV_NO_TIMER_READY)
+    {
+      // Nothing scheduled: sleep until a UI update or resume notifies us
+      wait_ticks = portMAX_DELAY;
+    }
+    else
+    {
+      if (delay_ms > LVGL_MAX_IDLE_MS)
+        delay_ms = LVGL_MAX_IDLE_MS;
+      wait_ticks = pdMS_TO_TICKS(delay_ms);
+      if (wait_ticks == 0)
+        wait_ticks = 1;
+    }
+    int64_t sleep_start_us = esp_timer_get_time();
+    uint32_t notified = ulTaskNotifyTake(pdTRUE, wait_ticks);
+    lvgl_wakeups_total++;
+
+    // A timed-out sleep should end on the tick it asked for; anything later was another task holding the core
+    if (notified == 0 && wait_ticks != portMAX_DELAY)
+    {
+      int64_t late_us = esp_timer_get_time() - sleep_start_us - (int64_t)wait_ticks * portTICK_PERIOD_MS * 1000;
+      if (late_us < 0)
+        late_us = 0;
+      if ((uint32_t)late_us > jitter_max_us)
+        jitter_max_us = (uint32_t)late_us;
+      jitter_sum_us += (uint64_t)late_us;
+      jitter_samples++;
+    }
   }
 }
 
+static void IRAM_ATTR touch_notify_from_isr(void)
+{
+  BaseType_t woken = pdFALSE;
+  if (lvgl_task_handle != NULL)
+    vTaskNotifyGiveFromISR(lvgl_task_handle, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+  static uint16_t last_x = 0;
+  static uint16_t last_y = 0;
+  static bool pressed = false;
+
+  uint16_t x, y;
+  bool now_pressed;
+  if (touch_read(&x, &y, &now_pressed))
+  {
+    pressed = now_pressed;
+    if (pressed)
+    {
+      last_x = x;
+      last_y = y;
+    }
+  }
+
+  data->point.x = last_x;
+  data->point.y = last_y;
+  data->state = pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+
+  // Released with nothing pending: stop polling until the next interrupt
+  if (!TOUCH_POLLED && !pressed && !touch_has_pending())
+    lv_timer_pause(drv->read_timer);
+}
+
+void ui_register_touch(void)
+{
+  if (!lvgl_lock(500))
+    return;
+
+  lv_indev_drv_init(&touch_indev_drv);
+  touch_indev_drv.type = LV_INDEV_TYPE_POINTER;
+  touch_indev_drv.read_cb = touch_read_cb;
+  touch_indev = lv_indev_drv_register(&touch_indev_drv);
+  if (!TOUCH_POLLED)
+    lv_timer_pause(touch_indev->driver->read_timer);
+  touch_set_notify_cb(touch_notify_from_isr);
+
+  lvgl_unlock();
+  ESP_LOGI(TAG, "Touch input registered (interrupt driven)");
+}
+
 void ui_init(esp_lcd_panel_handle_t lcd_panel)
 {
   ESP_LOGI(TAG, "Initializing LVGL and UI");
@@ -108,36 +443,57 @@ void ui_init(esp_lcd_panel_handle_t lcd_panel)
   lvgl_api_mux = xSemaphoreCreateRecursiveMutex();
   assert(lvgl_api_mux != NULL);
 
-  // Allocate draw buffer (80 lines for better rendering with large fonts)
-  disp_buf1 = heap_caps_malloc(LCD_H_RES * 80 * sizeof(lv_color_t), MALLOC_CAP_DMA);
-  assert(disp_buf1 != NULL);
-  lv_disp_draw_buf_init(&draw_buf, disp_buf1, NULL, LCD_H_RES * 80);
+  size_t internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+#if CONFIG_SPIRAM
+  // Full framebuffer in PSRAM; only two small bounce buffers need internal DMA RAM
+  psram_fb = heap_caps_malloc(LCD_H_RES * LCD_V_RES * sizeof(lv_color_t), MALLOC_CAP_SPIRAM);
+  if (psram_fb != NULL)
+  {
+    bounce_buf[0] = heap_caps_malloc(UI_FB_BOUNCE_PIXELS * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    bounce_buf[1] = heap_caps_malloc(UI_FB_BOUNCE_PIXELS * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    bounce_free = xSemaphoreCreateCounting(2, 2);
+    assert(bounce_buf[0] != NULL && bounce_buf[1] != NULL && bounce_free != NULL);
+    lv_disp_draw_buf_init(&draw_buf, psram_fb, NULL, LCD_H_RES * LCD_V_RES);
+  }
+  else
+  {
+    ESP_LOGW(TAG, "No PSRAM for the framebuffer, using internal draw bands");
+  }
+#endif
+
+  if (psram_fb == NULL)
+  {
+    // Allocate two DMA draw buffers so LVGL renders one band while the other is being sent
+    disp_buf1 = heap_caps_malloc(LCD_DRAW_BUF_PIXELS * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    disp_buf2 = heap_caps_malloc(LCD_DRAW_BUF_PIXELS * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    assert(disp_buf1 != NULL && disp_buf2 != NULL);
+    lv_disp_draw_buf_init(&draw_buf, disp_buf1, disp_buf2, LCD_DRAW_BUF_PIXELS);
+  }
+
+  ESP_LOGI(TAG, "Draw buffers (%s): %u bytes of internal RAM, banded mode takes %u",
+           psram_fb != NULL ? "PSRAM framebuffer" : "internal bands",
+           (unsigned)(internal_before - heap_caps_get_free_size(MALLOC_CAP_INTERNAL)),
+           (unsigned)(2 * LCD_DRAW_BUF_PIXELS * sizeof(lv_color_t)));
 
   // Register display driver
   lv_disp_drv_init(&disp_drv);
+  // In direct mode LVGL redraws dirty areas in place and keeps the rest of the frame
+  disp_drv.direct_mode = psram_fb != NULL;
   disp_drv.hor_res = LCD_H_RES;
   disp_drv.ver_res = LCD_V_RES;
   disp_drv.flush_cb = lvgl_flush_cb;
+  disp_drv.monitor_cb = lvgl_monitor_cb;
   disp_drv.draw_buf = &draw_buf;
   lv_disp_drv_register(&disp_drv);
+  refresh_mode_since_us = esp_timer_get_time();
 
-  // Create startup screen with spinner and status
-  lv_obj_t *scr = lv_scr_act();
-
-  // Spinner in center
-  startup_spinner = lv_spinner_create(scr, 1000, 60);
-  lv_obj_set_size(startup_spinner, 100, 100);
-  lv_obj_align(startup_spinner, LV_ALIGN_CENTER, 0, -20);
-
-  // Status label at bottom
-  label_startup_status = lv_label_create(scr);
-  lv_label_set_text(label_startup_status, "Starting up...");
-  lv_obj_set_style_text_font(label_startup_status, &lv_font_montserrat_14, 0);
-  lv_obj_align(label_startup_status, LV_ALIGN_BOTTOM_MID, 0, -20);
+  // Build the startup screen on demand; the default screen LVGL created is discarded
+  show_screen(UI_SCREEN_STARTUP);
 
-  // Create LVGL tasks AFTER UI elements are created
-  xTaskCreate(lv_tick_task, "lv_tick", 2048, NULL, 5, NULL);
-  xTaskCreate(lv_task, "lv_task", 4096, NULL, 5, NULL);
+  // Create LVGL task AFTER UI elements are created
+  // The tick comes from esp_timer_get_time (CONFIG_LV_TICK_CUSTOM), so no tick task is needed
+  task_placement_create(lv_task, "lv_task", 4096, NULL, TASK_ROLE_UI, &lvgl_task_handle);
 
   ESP_LOGI(TAG, "UI initialized with startup screen");
 }
@@ -156,27 +512,109 @@ void ui_update_startup_status(const char *status)
   lvgl_unlock();
 }
 
-void ui_show_main_screen(void)
+static lv_obj_t *create_history_chart(lv_obj_t *parent, const char *title, lv_coord_t y,
+                                      uint16_t points, lv_coord_t y_max, lv_chart_series_t **series)
 {
-  if (!lvgl_lock(500))
+  lv_obj_t *label = lv_label_create(parent);
+  lv_label_set_text(label, title);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_12, 0);
+  lv_obj_align(label, LV_ALIGN_TOP_MID, 0, y);
+
+  lv_obj_t *chart = lv_chart_create(parent);
+  lv_obj_set_size(chart, lv_pct(100), 100);
+  lv_obj_align(chart, LV_ALIGN_TOP_MID, 0, y + 16);
+  lv_obj_clear_flag(chart, LV_OBJ_FLAG_CLICKABLE);  // Taps go to the container to close the view
+  lv_chart_set_type(chart, LV_CHART_TYPE_BAR);
+  lv_chart_set_point_count(chart, points);
+  lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, y_max);
+  lv_chart_set_div_line_count(chart, 0, 0);
+  lv_obj_set_style_pad_column(chart, 0, LV_PART_MAIN);
+  lv_obj_set_style_pad_column(chart, 0, LV_PART_ITEMS);
+  *series = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+  return chart;
+}
+
+static lv_obj_t *create_qr_code(lv_obj_t *parent, const char *qr_data)
+{
+  lv_obj_t *qr = lv_qrcode_create(parent, 200, lv_color_black(), lv_color_white());
+  lv_qrcode_update(qr, qr_data, strlen(qr_data));
+  lv_obj_align(qr, LV_ALIGN_CENTER, 0, -10);
+  return qr;
+}
+
+// Caller must hold the LVGL lock
+static void apply_history(void)
+{
+  if (history_container == NULL)
     return;
 
-  // Clear startup screen
-  if (startup_spinner != NULL)
-  {
-    lv_obj_del(startup_spinner);
-    startup_spinner = NULL;
-  }
-  if (label_startup_status != NULL)
-  {
-    lv_obj_del(label_startup_status);
-    label_startup_status = NULL;
-  }
+  uint32_t version = step_history_get_version();
+  if (version == history_rendered_version)
+    return;
+
+  uint16_t oldest;
+  step_history_minutes(&oldest);
+  lv_chart_set_x_start_point(history_minute_chart, history_minute_series, oldest);
+  lv_chart_refresh(history_minute_chart);
+  step_history_hours(&oldest);
+  lv_chart_set_x_start_point(history_hour_chart, history_hour_series, oldest);
+  lv_chart_refresh(history_hour_chart);
+
+  lv_label_set_text_fmt(label_history_totals, "Hour: %lu | Day: %lu",
+                        (unsigned long)step_history_last_hour_total(),
+                        (unsigned long)step_history_last_day_total());
+  history_rendered_version = version;
+}
+
+static void build_startup_screen(lv_obj_t *scr)
+{
+  // Spinner in center
+  startup_spinner = lv_spinner_create(scr, 1000, 60);
+  lv_obj_set_size(startup_spinner, 100, 100);
+  lv_obj_align(startup_spinner, LV_ALIGN_CENTER, 0, -20);
+
+  // Status label at bottom
+  label_startup_status = lv_label_create(scr);
+  lv_label_set_text(label_startup_status, "Starting up...");
+  lv_obj_set_style_text_font(label_startup_status, &lv_font_montserrat_14, 0);
+  lv_obj_align(label_startup_status, LV_ALIGN_BOTTOM_MID, 0, -20);
+}
+
+static void teardown_startup_screen(void)
+{
+  startup_spinner = NULL;
+  label_startup_status = NULL;
+}
+
+static void build_qr_screen(lv_obj_t *scr)
+{
+  // Create QR code widget - make it as large as possible while fitting on screen
+  // Screen is 240x320, leave room for text at top and bottom
+  qr_code = create_qr_code(scr, qr_screen_data);
+
+  label_startup_status = lv_label_create(scr);
+  lv_label_set_text(label_startup_status, qr_screen_message);
+  lv_obj_set_style_text_font(label_startup_status, &lv_font_montserrat_14, 0);
+  lv_obj_align(label_startup_status, LV_ALIGN_BOTTOM_MID, 0, -20);
+}
+
+static void teardown_qr_screen(void)
+{
+  qr_code = NULL;
+  label_startup_status = NULL;
+}
 
-  // Create main UI
-  lv_obj_t *scr = lv_scr_act();
+static void toggle_history_cb(lv_event_t *e)
+{
+  (void)e;
+  show_screen(current_screen == UI_SCREEN_HISTORY ? UI_SCREEN_MAIN : UI_SCREEN_HISTORY);
+}
+
+static void build_main_screen(lv_obj_t *scr)
+{
   main_container = lv_obj_create(scr);
   lv_obj_set_size(main_container, lv_pct(100), lv_pct(100));
+  lv_obj_add_event_cb(main_container, toggle_history_cb, LV_EVENT_CLICKED, NULL);
 
   // Top left: Buffer count (unsent steps)
   label_buffer_count = lv_label_create(main_container);
@@ -202,11 +640,26 @@ void ui_show_main_screen(void)
   lv_obj_set_style_text_font(label_ws_status, &lv_font_montserrat_12, 0);
   lv_obj_align(label_ws_status, LV_ALIGN_TOP_RIGHT, -5, 35);
 
-  // Large step counter in center
-  label_steps = lv_label_create(main_container);
-  lv_label_set_text(label_steps, "0");
-  lv_obj_set_style_text_font(label_steps, &lv_font_montserrat_48, 0);
-  lv_obj_align(label_steps, LV_ALIGN_CENTER, 0, 0);
+  // Predicted battery runtime (below the status icons)
+  label_runtime = lv_label_create(main_container);
+  lv_label_set_text(label_runtime, "--");
+  lv_obj_set_style_text_font(label_runtime, &lv_font_montserrat_12, 0);
+  lv_obj_align(label_runtime, LV_ALIGN_TOP_RIGHT, -5, 50);
+
+  // Large step counter in center, drawn from a pre-rendered digit atlas when possible
+  step_digits = digit_counter_create(main_container, &lv_font_montserrat_48);
+  if (step_digits != NULL)
+  {
+    lv_obj_align(step_digits, LV_ALIGN_CENTER, 0, 0);
+    digit_counter_set_value(0);
+  }
+  else
+  {
+    label_steps = lv_label_create(main_container);
+    lv_label_set_text(label_steps, "0");
+    lv_obj_set_style_text_font(label_steps, &lv_font_montserrat_48, 0);
+    lv_obj_align(label_steps, LV_ALIGN_CENTER, 0, 0);
+  }
 
   // Power management timers at bottom
   label_power_timers = lv_label_create(main_container);
@@ -214,43 +667,136 @@ void ui_show_main_screen(void)
   lv_obj_set_style_text_font(label_power_timers, &lv_font_montserrat_12, 0);
   lv_obj_align(label_power_timers, LV_ALIGN_BOTTOM_MID, 0, -5);
 
-  lvgl_unlock();
+  // Labels hold placeholder text; show the latest values straight away
+  rendered_vm_valid = false;
+  if (latest_vm_set)
+  {
+    apply_status(&latest_vm);
+    apply_power_timers(&latest_vm);
+    rendered_vm_valid = true;
+  }
+}
 
-  ESP_LOGI(TAG, "Main screen shown");
+static void teardown_main_screen(void)
+{
+  main_container = NULL;
+  label_buffer_count = NULL;
+  label_percent = NULL;
+  label_wifi_status = NULL;
+  label_ws_status = NULL;
+  label_runtime = NULL;
+  label_steps = NULL;
+  step_digits = NULL;
+  label_power_timers = NULL;
+  rendered_vm_valid = false;
 }
 
-void ui_show_qr_code(const char *qr_data, const char *message)
+static void build_history_screen(lv_obj_t *scr)
+{
+  _Static_assert(sizeof(lv_coord_t) == sizeof(int16_t), "history buckets are shared with lv_chart");
+
+  history_container = lv_obj_create(scr);
+  lv_obj_set_size(history_container, lv_pct(100), lv_pct(100));
+  lv_obj_add_event_cb(history_container, toggle_history_cb, LV_EVENT_CLICKED, NULL);
+
+  history_minute_chart = create_history_chart(history_container, "Steps/min, last hour", 0,
+                                              STEP_HISTORY_MINUTES, 200, &history_minute_series);
+  history_hour_chart = create_history_chart(history_container, "Steps/hour, last day", 130,
+                                            STEP_HISTORY_HOURS, 6000, &history_hour_series);
+
+  // The charts read the aggregate rings in place: no copying or resampling per refresh
+  lv_chart_set_ext_y_array(history_minute_chart, history_minute_series,
+                           (lv_coord_t *)step_history_minutes(NULL));
+  lv_chart_set_ext_y_array(history_hour_chart, history_hour_series,
+                           (lv_coord_t *)step_history_hours(NULL));
+
+  label_history_totals = lv_label_create(history_container);
+  lv_obj_set_style_text_font(label_history_totals, &lv_font_montserrat_12, 0);
+  lv_obj_align(label_history_totals, LV_ALIGN_BOTTOM_MID, 0, 0);
+  lv_label_set_text(label_history_totals, "");
+
+  history_rendered_version = UINT32_MAX;
+  apply_history();
+}
+
+static void teardown_history_screen(void)
+{
+  history_container = NULL;
+  history_minute_chart = NULL;
+  history_hour_chart = NULL;
+  history_minute_series = NULL;
+  history_hour_series = NULL;
+  label_history_totals = NULL;
+}
+
+typedef struct
+{
+  const char *name;
+  void (*build)(lv_obj_t *scr);
+  void (*teardown)(void);
+} screen_def_t;
+
+static const screen_def_t screen_defs[UI_SCREEN_COUNT] = {
+    [UI_SCREEN_STARTUP] = {"startup", build_startup_screen, teardown_startup_screen},
+    [UI_SCREEN_QR] = {"qr", build_qr_screen, teardown_qr_screen},
+    [UI_SCREEN_MAIN] = {"main", build_main_screen, teardown_main_screen},
+    [UI_SCREEN_HISTORY] = {"history", build_history_screen, teardown_history_screen},
+};
+
+/**
+ * Delete the previous screen with everything on it, then build the requested
+ * screen on a fresh LVGL screen object and load it. Records how much LVGL
+ * heap the build took. Caller must hold the LVGL lock.
+ */
+static void show_screen(ui_screen_t id)
+{
+  const screen_def_t *def = &screen_defs[id];
+  lv_obj_t *old_scr = lv_scr_act();
+
+  if (current_screen != UI_SCREEN_NONE && screen_defs[current_screen].teardown)
+    screen_defs[current_screen].teardown();
+
+  // Deleted before the build so single-instance widgets (the digit counter
+  // and its atlas) are released first. Safe from an event on the old screen:
+  // LVGL resets input devices pointing into a deleted tree and stops the event
+  if (old_scr != NULL)
+    lv_obj_del(old_scr);
+
+  lv_mem_monitor_t before, after;
+  lv_mem_monitor(&before);
+
+  lv_obj_t *scr = lv_obj_create(NULL);
+  def->build(scr);
+
+  lv_mem_monitor(&after);
+  screen_footprint[id] = before.free_size > after.free_size ? before.free_size - after.free_size : 0;
+
+  lv_scr_load(scr);
+  current_screen = id;
+
+  ESP_LOGI(TAG, "Screen '%s' built: %lu bytes of LVGL heap", def->name, (unsigned long)screen_footprint[id]);
+}
+
+void ui_show_main_screen(void)
 {
   if (!lvgl_lock(500))
     return;
 
-  // Clear spinner if it exists
-  if (startup_spinner != NULL)
-  {
-    lv_obj_del(startup_spinner);
-    startup_spinner = NULL;
-  }
+  show_screen(UI_SCREEN_MAIN);
 
-  // Delete existing QR code if present
-  if (qr_code != NULL)
-  {
-    lv_obj_del(qr_code);
-    qr_code = NULL;
-  }
+  lvgl_unlock();
 
-  // Create QR code widget - make it as large as possible while fitting on screen
-  // Screen is 240x320, leave room for text at top and bottom
-  lv_obj_t *scr = lv_scr_act();
-  qr_code = lv_qrcode_create(scr, 200, lv_color_black(), lv_color_white());
-  lv_qrcode_update(qr_code, qr_data, strlen(qr_data));
-  lv_obj_align(qr_code, LV_ALIGN_CENTER, 0, -10);
+  ESP_LOGI(TAG, "Main screen shown");
+}
 
-  // Update status message
-  if (label_startup_status != NULL)
-  {
-    lv_label_set_text(label_startup_status, message);
-    lv_obj_align(label_startup_status, LV_ALIGN_BOTTOM_MID, 0, -20);
-  }
+void ui_show_qr_code(const char *qr_data, const char *message)
+{
+  if (!lvgl_lock(500))
+    return;
+
+  strncpy(qr_screen_data, qr_data, sizeof(qr_screen_data) - 1);
+  strncpy(qr_screen_message, message, sizeof(qr_screen_message) - 1);
+  show_screen(UI_SCREEN_QR);
 
   ESP_LOGI(TAG, "QR code displayed: %s", qr_data);
   lvgl_unlock();
@@ -286,50 +832,153 @@ void ui_update_battery(float voltage, int adc_raw, int pct_milli)
     int pct_tenth = pct_milli % 10;
     snprintf(buf, sizeof(buf), "Pct: %d.%d%%", pct_whole, pct_tenth);
     lv_label_set_text(label_percent, buf);
+    rendered_vm_valid = false;
   }
 
   lvgl_unlock();
 }
 
-void ui_update_status(uint32_t step_count, uint8_t buffer_count, bool wifi_connected, bool ws_connected, int battery_pct)
+static void set_label_if_changed(lv_obj_t *label, bool changed, const char *text)
 {
-  if (!lvgl_lock(500))
+  if (label == NULL)
     return;
-
-  char buf[32];
-
-  // Update step count (center, large)
-  if (label_steps)
+  if (!changed)
   {
-    snprintf(buf, sizeof(buf), "%lu", (unsigned long)step_count);
-    lv_label_set_text(label_steps, buf);
+    label_skips_total++;
+    return;
   }
+  lv_label_set_text(label, text);
+  label_writes_total++;
+}
 
-  // Update buffer count (top left)
-  if (label_buffer_count)
+// Caller must hold the LVGL lock
+static void apply_status(const ui_view_model_t *vm)
+{
+  char buf[32] = "";
+  bool all = !rendered_vm_valid;
+
+  // Step count (center, large)
+  bool changed = all || vm->step_count != rendered_vm.step_count;
+  if (step_digits != NULL)
   {
-    snprintf(buf, sizeof(buf), "Q:%u", buffer_count);
-    lv_label_set_text(label_buffer_count, buf);
+    // Counted like a label so the render stats compare across both paths
+    if (changed)
+    {
+      digit_counter_set_value(vm->step_count);
+      label_writes_total++;
+    }
+    else
+    {
+      label_skips_total++;
+    }
   }
-
-  // Update battery percentage (top right)
-  if (label_percent)
+  else
   {
-    snprintf(buf, sizeof(buf), "%d%%", battery_pct);
-    lv_label_set_text(label_percent, buf);
+    if (changed)
+      snprintf(buf, sizeof(buf), "%lu", (unsigned long)vm->step_count);
+    set_label_if_changed(label_steps, changed, buf);
   }
 
-  // Update WiFi status
-  if (label_wifi_status)
+  // Buffer count (top left)
+  changed = all || vm->buffer_count != rendered_vm.buffer_count;
+  if (changed)
+    snprintf(buf, sizeof(buf), "Q:%u", vm->buffer_count);
+  set_label_if_changed(label_buffer_count, changed, buf);
+
+  // Battery percentage (top right)
+  changed = all || vm->battery_pct != rendered_vm.battery_pct;
+  if (changed)
+    snprintf(buf, sizeof(buf), "%d%%", vm->battery_pct);
+  set_label_if_changed(label_percent, changed, buf);
+
+  // WiFi and WebSocket status
+  set_label_if_changed(label_wifi_status, all || vm->wifi_connected != rendered_vm.wifi_connected,
+                       vm->wifi_connected ? "W:OK" : "W:-");
+  set_label_if_changed(label_ws_status, all || vm->ws_connected != rendered_vm.ws_connected,
+                       vm->ws_connected ? "S:OK" : "S:-");
+
+  // Battery runtime estimate
+  changed = all || vm->runtime_min != rendered_vm.runtime_min;
+  if (changed)
   {
-    lv_label_set_text(label_wifi_status, wifi_connected ? "W:OK" : "W:-");
+    if (vm->runtime_min < 0)
+      snprintf(buf, sizeof(buf), "--");
+    else
+      snprintf(buf, sizeof(buf), "%dh%02dm", vm->runtime_min / 60, vm->runtime_min % 60);
   }
+  set_label_if_changed(label_runtime, changed, buf);
+
+  rendered_vm.step_count = vm->step_count;
+  rendered_vm.buffer_count = vm->buffer_count;
+  rendered_vm.battery_pct = vm->battery_pct;
+  rendered_vm.wifi_connected = vm->wifi_connected;
+  rendered_vm.ws_connected = vm->ws_connected;
+  rendered_vm.runtime_min = vm->runtime_min;
+}
+
+// Caller must hold the LVGL lock
+static void apply_power_timers(const ui_view_model_t *vm)
+{
+  char buf[64] = "";
+  bool changed = !rendered_vm_valid ||
+                 vm->wifi_countdown_s != rendered_vm.wifi_countdown_s ||
+                 vm->display_countdown_s != rendered_vm.display_countdown_s;
 
-  // Update WebSocket status
-  if (label_ws_status)
+  if (changed)
   {
-    lv_label_set_text(label_ws_status, ws_connected ? "S:OK" : "S:-");
+    if (vm->wifi_countdown_s == 0 && vm->display_countdown_s == 0) {
+      snprintf(buf, sizeof(buf), "WiFi: OFF | Display: OFF");
+    } else if (vm->wifi_countdown_s == 0) {
+      snprintf(buf, sizeof(buf), "WiFi: OFF | Display: %ds", vm->display_countdown_s);
+    } else if (vm->display_countdown_s == 0) {
+      snprintf(buf, sizeof(buf), "WiFi: %ds | Display: OFF", vm->wifi_countdown_s);
+    } else {
+      snprintf(buf, sizeof(buf), "WiFi: %ds | Display: %ds", vm->wifi_countdown_s, vm->display_countdown_s);
+    }
   }
+  set_label_if_changed(label_power_timers, changed, buf);
+
+  rendered_vm.wifi_countdown_s = vm->wifi_countdown_s;
+  rendered_vm.display_countdown_s = vm->display_countdown_s;
+}
+
+void ui_update(const ui_view_model_t *vm)
+{
+  if (vm == NULL || !lvgl_lock(500))
+    return;
+
+  // Kept so a rebuilt main screen starts with current values
+  latest_vm = *vm;
+  latest_vm_set = true;
+
+  apply_status(vm);
+  apply_power_timers(vm);
+  apply_history();
+  rendered_vm_valid = main_container != NULL;
+
+  lvgl_unlock();
+}
+
+void ui_update_status(uint32_t step_count, uint8_t buffer_count, bool wifi_connected, bool ws_connected, int battery_pct)
+{
+  if (!lvgl_lock(500))
+    return;
+
+  ui_view_model_t vm = latest_vm;
+  vm.step_count = step_count;
+  vm.buffer_count = buffer_count;
+  vm.wifi_connected = wifi_connected;
+  vm.ws_connected = ws_connected;
+  vm.battery_pct = battery_pct;
+  latest_vm = vm;
+  latest_vm_set = true;
+
+  bool was_valid = rendered_vm_valid;
+  apply_status(&vm);
+  // Timers are untouched here, so only a previously valid cache stays valid
+  if (!was_valid)
+    apply_power_timers(&vm);
+  rendered_vm_valid = main_container != NULL;
 
   lvgl_unlock();
 }
@@ -339,27 +988,107 @@ void ui_update_power_timers(int wifi_countdown_s, int display_countdown_s)
   if (!lvgl_lock(500))
     return;
 
-  char buf[64];
+  ui_view_model_t vm = latest_vm;
+  vm.wifi_countdown_s = wifi_countdown_s;
+  vm.display_countdown_s = display_countdown_s;
+  latest_vm = vm;
+  latest_vm_set = true;
 
-  if (label_power_timers)
+  bool was_valid = rendered_vm_valid;
+  apply_power_timers(&vm);
+  if (!was_valid)
+    apply_status(&vm);
+  rendered_vm_valid = main_container != NULL;
+
+  lvgl_unlock();
+}
+
+void ui_set_active(bool active)
+{
+  if (active == lvgl_active)
+    return;
+
+  lvgl_active = active;
+  if (active)
   {
-    if (wifi_countdown_s == 0 && display_countdown_s == 0) {
-      lv_label_set_text(label_power_timers, "WiFi: OFF | Display: OFF");
-    } else if (wifi_countdown_s == 0) {
-      snprintf(buf, sizeof(buf), "WiFi: OFF | Display: %ds", display_countdown_s);
-      lv_label_set_text(label_power_timers, buf);
-    } else if (display_countdown_s == 0) {
-      snprintf(buf, sizeof(buf), "WiFi: %ds | Display: OFF", wifi_countdown_s);
-      lv_label_set_text(label_power_timers, buf);
-    } else {
-      snprintf(buf, sizeof(buf), "WiFi: %ds | Display: %ds", wifi_countdown_s, display_countdown_s);
-      lv_label_set_text(label_power_timers, buf);
+    // Redraw whatever changed while we were asleep
+    if (lvgl_lock(500))
+    {
+      lv_obj_invalidate(lv_scr_act());
+      lvgl_unlock();
     }
+    if (lvgl_task_handle != NULL)
+      xTaskNotifyGive(lvgl_task_handle);
   }
+  ESP_LOGI(TAG, "LVGL rendering %s", active ? "resumed" : "suspended");
+}
 
+void ui_display_sleep(void)
+{
+  // Holding the lock keeps the handler from starting another frame; the one
+  // it may have just handed to DMA has to land before DISPOFF/SLPIN go out
+  lvgl_lock(-1);
+  ui_set_active(false);
+  wait_flush_idle();
+  display_sleep();
   lvgl_unlock();
 }
 
+void ui_display_wake(void)
+{
+  if (display_get_power_state() != DISPLAY_POWER_SLEEP)
+  {
+    ui_set_active(true);
+    return;
+  }
+
+  display_wake_begin();
+
+  // Resume invalidates the whole screen; render it now in a single pass while the panel is dark
+  ui_set_active(true);
+  if (lvgl_lock(500))
+  {
+    lv_refr_now(NULL);
+    lvgl_unlock();
+  }
+
+  // The last band may still be in flight
+  wait_flush_idle();
+
+  display_wake_finish();
+}
+
+void ui_get_render_stats(ui_render_stats_t *stats)
+{
+  if (stats == NULL)
+    return;
+
+  int64_t now_us = esp_timer_get_time();
+  uint32_t invalidated = invalidated_px_total;
+  uint32_t flushed = flushed_px_total;
+  uint32_t writes = label_writes_total;
+  uint32_t skips = label_skips_total;
+  uint32_t wakeups = lvgl_wakeups_total;
+
+  uint32_t elapsed_ms = (uint32_t)((now_us - stats_window_start_us) / 1000);
+  if (elapsed_ms == 0)
+    elapsed_ms = 1;
+
+  stats->invalidated_px_per_s = (uint32_t)((uint64_t)(invalidated - stats_window_invalidated_px) * 1000 / elapsed_ms);
+  stats->flushed_px_per_s = (uint32_t)((uint64_t)(flushed - stats_window_flushed_px) * 1000 / elapsed_ms);
+  stats->label_writes = writes - stats_window_label_writes;
+  stats->label_skips = skips - stats_window_label_skips;
+  stats->lvgl_wakeups_per_s = (uint32_t)((uint64_t)(wakeups - stats_window_lvgl_wakeups) * 1000 / elapsed_ms);
+  stats->window_ms = elapsed_ms;
+
+  stats_window_invalidated_px = invalidated;
+  stats_window_flushed_px = flushed;
+  stats_window_label_writes = writes;
+  stats_window_label_skips = skips;
+  stats_window_lvgl_wakeups = wakeups;
+  stats_window_start_us = now_us;
+}
+
 void ui_show_ota_status(bool visible)
 {
   if (!lvgl_lock(500))
@@ -367,8 +1096,11 @@ void ui_show_ota_status(bool visible)
 
   if (visible) {
     if (ota_overlay == NULL) {
-      // Create overlay container
-      ota_overlay = lv_obj_create(lv_scr_act());
+      lv_mem_monitor_t before, after;
+      lv_mem_monitor(&before);
+
+      // Built on the top layer so it covers whichever screen is loaded
+      ota_overlay = lv_obj_create(lv_layer_top());
       lv_obj_set_size(ota_overlay, LCD_H_RES, LCD_V_RES);
       lv_obj_set_style_bg_color(ota_overlay, lv_color_hex(0x000000), 0);
       lv_obj_set_style_bg_opa(ota_overlay, LV_OPA_90, 0);
@@ -387,17 +1119,97 @@ void ui_show_ota_status(bool visible)
       lv_obj_set_size(ota_bar, 200, 20);
       lv_obj_align(ota_bar, LV_ALIGN_CENTER, 0, 0);
       lv_bar_set_value(ota_bar, 0, LV_ANIM_OFF);
+
+      lv_mem_monitor(&after);
+      ota_overlay_footprint = before.free_size > after.free_size ? before.free_size - after.free_size : 0;
+      ESP_LOGI(TAG, "OTA overlay built: %lu bytes of LVGL heap", (unsigned long)ota_overlay_footprint);
     }
-    lv_obj_clear_flag(ota_overlay, LV_OBJ_FLAG_HIDDEN);
   } else {
     if (ota_overlay != NULL) {
-      lv_obj_add_flag(ota_overlay, LV_OBJ_FLAG_HIDDEN);
+      lv_obj_del(ota_overlay);
+      ota_overlay = NULL;
+      ota_label = NULL;
+      ota_bar = NULL;
     }
   }
 
   lvgl_unlock();
 }
 
+void ui_set_jitter_probe(bool enable)
+{
+  jitter_probe = enable;
+  if (enable)
+    lvgl_wake();
+}
+
+void ui_get_frame_jitter(ui_frame_jitter_t *jitter)
+{
+  if (jitter == NULL || !lvgl_lock(500))
+    return;
+
+  jitter->max_late_us = jitter_max_us;
+  jitter->avg_late_us = jitter_samples ? (uint32_t)(jitter_sum_us / jitter_samples) : 0;
+  jitter->samples = jitter_samples;
+
+  jitter_max_us = 0;
+  jitter_sum_us = 0;
+  jitter_samples = 0;
+
+  lvgl_unlock();
+}
+
+void ui_get_refresh_stats(ui_refresh_stats_t *stats)
+{
+  if (stats == NULL || !lvgl_lock(500))
+    return;
+
+  int64_t now_us = esp_timer_get_time();
+  // Close the current mode's segment so its time is counted up to now
+  refresh_mode_us[refresh_mode] += now_us - refresh_mode_since_us;
+  refresh_mode_since_us = now_us;
+
+  for (int m = 0; m < UI_REFRESH_MODE_COUNT; m++)
+  {
+    uint64_t mode_us = refresh_mode_us[m] - stats_window_mode_us[m];
+    uint32_t frames = refresh_frames[m] - stats_window_frames[m];
+    uint64_t bytes = refresh_spi_bytes[m] - stats_window_spi_bytes[m];
+
+    stats->time_ms[m] = (uint32_t)(mode_us / 1000);
+    stats->frames_per_min[m] = mode_us ? (uint32_t)((uint64_t)frames * 60000000ULL / mode_us) : 0;
+    stats->spi_bytes_per_min[m] = mode_us ? (uint32_t)(bytes * 60000000ULL / mode_us) : 0;
+
+    stats_window_mode_us[m] = refresh_mode_us[m];
+    stats_window_frames[m] = refresh_frames[m];
+    stats_window_spi_bytes[m] = refresh_spi_bytes[m];
+  }
+  stats->mode = refresh_mode;
+  stats->window_ms = (uint32_t)((now_us - stats_window_refresh_start_us) / 1000);
+  stats_window_refresh_start_us = now_us;
+
+  lvgl_unlock();
+}
+
+void ui_get_mem_stats(ui_mem_stats_t *stats)
+{
+  if (stats == NULL || !lvgl_lock(500))
+    return;
+
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  stats->total_size = mon.total_size;
+  stats->used_size = mon.total_size - mon.free_size;
+  stats->max_used = mon.max_used;
+  stats->free_biggest_size = mon.free_biggest_size;
+  stats->frag_pct = mon.frag_pct;
+  stats->main_screen = screen_footprint[UI_SCREEN_MAIN];
+  stats->history_screen = screen_footprint[UI_SCREEN_HISTORY];
+  stats->qr_screen = screen_footprint[UI_SCREEN_QR];
+  stats->ota_overlay = ota_overlay_footprint;
+
+  lvgl_unlock();
+}
+
 void ui_update_ota_progress(int percent)
 {
   if (!lvgl_lock(500))
@@ -409,3 +1221,277 @@ void ui_update_ota_progress(int percent)
 
   lvgl_unlock();
 }
+
+static const char *draw_mode_name(void)
+{
+  return psram_fb != NULL ? "PSRAM framebuffer + bounce buffers" : "double-buffered internal bands";
+}
+
+void ui_benchmark_full_redraw(int frames)
+{
+  if (frames <= 0 || !lvgl_lock(500))
+    return;
+
+  lv_disp_t *disp = lv_disp_get_default();
+  uint32_t min_us = UINT32_MAX;
+  uint32_t max_us = 0;
+  uint64_t total_us = 0;
+
+  for (int i = 0; i < frames; i++)
+  {
+    lv_obj_invalidate(lv_scr_act());
+    int64_t start = esp_timer_get_time();
+    lv_refr_now(disp);
+    // The last band is still on the wire when lv_refr_now returns
+    wait_flush_idle();
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    total_us += elapsed;
+    if (elapsed < min_us)
+      min_us = elapsed;
+    if (elapsed > max_us)
+      max_us = elapsed;
+  }
+
+  lvgl_unlock();
+
+  ESP_LOGI(TAG, "Full redraw x%d (%s): avg %lu us, min %lu us, max %lu us, last render %lu ms / %lu px",
+           frames, draw_mode_name(),
+           (unsigned long)(total_us / frames), (unsigned long)min_us, (unsigned long)max_us,
+           (unsigned long)last_render_ms, (unsigned long)last_render_px);
+}
+
+// Returns microseconds per update; *px_per_update gets the pixels each one flushed
+static uint32_t time_step_updates(lv_obj_t *label, int updates, uint32_t *px_per_update)
+{
+  lv_disp_t *disp = lv_disp_get_default();
+  char buf[16];
+  uint32_t flushed_before = flushed_px_total;
+  int64_t start = esp_timer_get_time();
+  for (int i = 0; i < updates; i++)
+  {
+    uint32_t value = 1000 + i;
+    if (label != NULL)
+    {
+      snprintf(buf, sizeof(buf), "%lu", (unsigned long)value);
+      lv_label_set_text(label, buf);
+    }
+    else
+    {
+      digit_counter_set_value(value);
+    }
+    lv_refr_now(disp);
+    wait_flush_idle();
+  }
+  *px_per_update = (flushed_px_total - flushed_before) / updates;
+  return (uint32_t)((esp_timer_get_time() - start) / updates);
+}
+
+bool ui_benchmark_step_counter(int updates, ui_step_counter_bench_t *result)
+{
+  if (updates <= 0 || step_digits == NULL || !lvgl_lock(500))
+    return false;
+
+  ui_step_counter_bench_t bench;
+  bench.blit_us = time_step_updates(NULL, updates, &bench.blit_px);
+
+  // Same update sequence through a regular label in the same spot
+  lv_obj_add_flag(step_digits, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_t *label = lv_label_create(main_container);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_48, 0);
+  lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+  lv_refr_now(NULL);
+  bench.label_us = time_step_updates(label, updates, &bench.label_px);
+  lv_obj_del(label);
+  lv_obj_clear_flag(step_digits, LV_OBJ_FLAG_HIDDEN);
+  digit_counter_set_value(rendered_vm.step_count);
+  lv_refr_now(NULL);
+  wait_flush_idle();
+
+  lvgl_unlock();
+
+  ESP_LOGI(TAG, "Step counter update x%d (%s, render + flush): digit blitter %lu us / %lu px, label %lu us / %lu px",
+           updates, draw_mode_name(), (unsigned long)bench.blit_us, (unsigned long)bench.blit_px,
+           (unsigned long)bench.label_us, (unsigned long)bench.label_px);
+  if (result != NULL)
+    *result = bench;
+  return true;
+}
+
+typedef struct
+{
+  const char *name;
+  uint32_t frames;
+  uint64_t total_us;
+  uint32_t max_us;
+  uint64_t flushed_px;
+  uint32_t heap_max_used;
+  uint32_t checksum;
+} screen_bench_t;
+
+// Caller must hold the LVGL lock
+static void bench_frame(screen_bench_t *b)
+{
+  uint32_t flushed_before = flushed_px_total;
+  int64_t start = esp_timer_get_time();
+  lv_refr_now(NULL);
+  wait_flush_idle();
+  uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+
+  b->frames++;
+  b->total_us += elapsed;
+  if (elapsed > b->max_us)
+    b->max_us = elapsed;
+  b->flushed_px += flushed_px_total - flushed_before;
+  if (mon.max_used > b->heap_max_used)
+    b->heap_max_used = mon.max_used;
+}
+
+// Caller must hold the LVGL lock
+static uint32_t screen_checksum(void)
+{
+  frame_checksum = FNV_OFFSET_BASIS;
+  checksum_enabled = true;
+  lv_obj_invalidate(lv_scr_act());
+  lv_refr_now(NULL);
+  wait_flush_idle();
+  checksum_enabled = false;
+  return frame_checksum;
+}
+
+/*
+ * Expected full-redraw checksums. They depend on the fonts, the theme, the
+ * LVGL release (idf_component.yml) and its sdkconfig options, not on the
+ * chip: host_test's ui test renders with the same configuration and prints
+ * the checksum of any screen that misses. Re-record them from there when
+ * any of those change. 0 means not recorded yet, which counts as a miss.
+ */
+static const struct
+{
+  const char *name;
+  uint32_t checksum;
+} screen_goldens[] = {
+    {"main", 0},
+    {"ota", 0},
+    {"qr", 0},
+};
+
+// Returns false if the screen has a golden and the checksum misses it or none is recorded yet
+static bool bench_report(const screen_bench_t *b)
+{
+  if (b->frames == 0)
+    return true;
+  ESP_LOGI(TAG, "[%s] %lu frames: avg %lu us, max %lu us, %lu px/frame flushed, LVGL heap max %lu B, checksum %08lx",
+           b->name, (unsigned long)b->frames,
+           (unsigned long)(b->total_us / b->frames), (unsigned long)b->max_us,
+           (unsigned long)(b->flushed_px / b->frames), (unsigned long)b->heap_max_used,
+           (unsigned long)b->checksum);
+
+  for (size_t i = 0; i < sizeof(screen_goldens) / sizeof(screen_goldens[0]); i++)
+  {
+    if (strcmp(screen_goldens[i].name, b->name) != 0)
+      continue;
+    if (screen_goldens[i].checksum == 0)
+    {
+      ESP_LOGE(TAG, "[%s] no golden checksum recorded; record 0x%08lx once the frame is checked",
+               b->name, (unsigned long)b->checksum);
+      return false;
+    }
+    if (screen_goldens[i].checksum != b->checksum)
+    {
+      ESP_LOGE(TAG, "[%s] checksum %08lx does not match golden %08lx",
+               b->name, (unsigned long)b->checksum, (unsigned long)screen_goldens[i].checksum);
+      return false;
+    }
+    return true;
+  }
+  return true;
+}
+
+int ui_benchmark_screens(void)
+{
+  if (main_container == NULL || !lvgl_lock(500))
+    return -1;
+
+  lv_obj_t *main_scr = lv_scr_act();
+  ui_view_model_t saved_vm = latest_vm;
+
+  // Main screen: steps ticking every frame, power timers counting down every 10 frames
+  screen_bench_t main_bench = {.name = "main"};
+  ui_view_model_t vm = {
+      .step_count = 1234,
+      .buffer_count = 3,
+      .wifi_connected = true,
+      .ws_connected = true,
+      .battery_pct = 87,
+      .wifi_countdown_s = 30,
+      .display_countdown_s = 60,
+      .runtime_min = 750,
+  };
+  ui_update(&vm);
+  main_bench.checksum = screen_checksum();
+  for (int i = 0; i < 100; i++)
+  {
+    vm.step_count++;
+    vm.buffer_count = (vm.buffer_count + 1) % 5;
+    if (i % 10 == 0)
+    {
+      vm.wifi_countdown_s--;
+      vm.display_countdown_s--;
+    }
+    ui_update(&vm);
+    bench_frame(&main_bench);
+  }
+
+  // OTA overlay: progress 0-100 over the main screen
+  screen_bench_t ota_bench = {.name = "ota"};
+  ui_show_ota_status(true);
+  ui_update_ota_progress(0);
+  ota_bench.checksum = screen_checksum();
+  for (int pct = 1; pct <= 100; pct++)
+  {
+    ui_update_ota_progress(pct);
+    bench_frame(&ota_bench);
+  }
+  ui_show_ota_status(false);
+
+  // QR code screen, built on a scratch screen by the same builder the screen manager uses
+  screen_bench_t qr_bench = {.name = "qr"};
+  lv_obj_t *scratch = lv_obj_create(NULL);
+  lv_scr_load(scratch);
+  strncpy(qr_screen_data, "WIFI:T:nopass;S:Stepper;;", sizeof(qr_screen_data) - 1);
+  strncpy(qr_screen_message, "Scan to connect to 'Stepper'", sizeof(qr_screen_message) - 1);
+  build_qr_screen(scratch);
+  qr_bench.checksum = screen_checksum();
+  lv_obj_invalidate(scratch);
+  bench_frame(&qr_bench);
+
+  // Startup screen: spinner animation (no checksum, the frame depends on timing)
+  screen_bench_t startup_bench = {.name = "startup"};
+  lv_obj_clean(scratch);
+  teardown_qr_screen();
+  build_startup_screen(scratch);
+  for (int i = 0; i < 30; i++)
+  {
+    lv_timer_handler();
+    bench_frame(&startup_bench);
+    vTaskDelay(pdMS_TO_TICKS(30));
+  }
+
+  lv_scr_load(main_scr);
+  lv_obj_del(scratch);
+  teardown_startup_screen();
+  ui_update(&saved_vm);
+  lv_obj_invalidate(main_scr);
+
+  lvgl_unlock();
+
+  int mismatches = 0;
+  mismatches += !bench_report(&main_bench);
+  mismatches += !bench_report(&ota_bench);
+  mismatches += !bench_report(&qr_bench);
+  mismatches += !bench_report(&startup_bench);
+  return mismatches;
+}
@@ -3,6 +3,96 @@
 
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_io.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Everything shown on the main screen, in model form
+ *
+ * ui_update() compares this against the values last rendered and only
+ * touches labels whose text actually changes.
+ */
+typedef struct {
+  uint32_t step_count;      ///< Total steps detected
+  uint8_t buffer_count;     ///< Unsent steps in buffer
+  bool wifi_connected;      ///< WiFi connection status
+  bool ws_connected;        ///< WebSocket connection status
+  int battery_pct;          ///< Battery percentage (0-100)
+  int wifi_countdown_s;     ///< Seconds until WiFi shuts down (0 = off)
+  int display_countdown_s;  ///< Seconds until display shuts down (0 = off)
+  int runtime_min;          ///< Predicted battery runtime in minutes (-1 = unknown)
+} ui_view_model_t;
+
+/**
+ * @brief Rendering cost over the window since the previous query
+ */
+typedef struct {
+  uint32_t invalidated_px_per_s;  ///< Pixels LVGL re-rendered per second
+  uint32_t flushed_px_per_s;      ///< Pixels sent to the panel per second
+  uint32_t label_writes;          ///< Labels whose text was changed, step counter blits included
+  uint32_t label_skips;           ///< Label updates skipped as unchanged, step counter included
+  uint32_t lvgl_wakeups_per_s;    ///< Times the LVGL handler task woke per second
+  uint32_t window_ms;             ///< Length of the measurement window
+} ui_render_stats_t;
+
+/**
+ * @brief Cost of one step counter update through each drawing path
+ */
+typedef struct {
+  uint32_t blit_us;   ///< Digit blitter: set value, render and flush
+  uint32_t blit_px;   ///< Digit blitter: pixels flushed
+  uint32_t label_us;  ///< LVGL label in the same spot: set text, render and flush
+  uint32_t label_px;  ///< LVGL label: pixels flushed
+} ui_step_counter_bench_t;
+
+/**
+ * @brief Display refresh modes chosen by the refresh governor
+ */
+typedef enum {
+  UI_REFRESH_EVENT = 0,   ///< Static screen: redraw only when something changed
+  UI_REFRESH_ANIMATING,   ///< Animation running: redraw every CONFIG_LV_DISP_DEF_REFR_PERIOD ms
+  UI_REFRESH_MODE_COUNT
+} ui_refresh_mode_t;
+
+/**
+ * @brief Frames and SPI traffic per refresh mode since the previous query
+ *
+ * Rates are normalised to the time spent in each mode, so they stay
+ * comparable however the window was split between modes.
+ */
+typedef struct {
+  uint32_t frames_per_min[UI_REFRESH_MODE_COUNT];     ///< Refreshes rendered per minute in the mode
+  uint32_t spi_bytes_per_min[UI_REFRESH_MODE_COUNT];  ///< Bytes flushed to the panel per minute in the mode
+  uint32_t time_ms[UI_REFRESH_MODE_COUNT];            ///< Time spent in the mode during the window
+  ui_refresh_mode_t mode;                             ///< Current mode
+  uint32_t window_ms;                                 ///< Length of the measurement window
+} ui_refresh_stats_t;
+
+/**
+ * @brief Lateness of the LVGL handler's timed wakeups since the previous query
+ */
+typedef struct {
+  uint32_t max_late_us;  ///< Worst delay past the requested wakeup tick
+  uint32_t avg_late_us;  ///< Mean delay past the requested wakeup tick
+  uint32_t samples;      ///< Timed wakeups measured
+} ui_frame_jitter_t;
+
+/**
+ * @brief LVGL heap usage and the footprint of each lazily built screen
+ *
+ * Footprints are measured when a screen is built; 0 means it has not been shown yet.
+ */
+typedef struct {
+  uint32_t total_size;         ///< LVGL heap size (CONFIG_LV_MEM_SIZE_KILOBYTES)
+  uint32_t used_size;          ///< Bytes currently allocated
+  uint32_t max_used;           ///< High-water mark since boot
+  uint32_t free_biggest_size;  ///< Largest free block
+  uint8_t frag_pct;            ///< Fragmentation of the free space
+  uint32_t main_screen;        ///< Bytes taken by the main screen
+  uint32_t history_screen;     ///< Bytes taken by the history screen
+  uint32_t qr_screen;          ///< Bytes taken by the AP-mode QR screen
+  uint32_t ota_overlay;        ///< Bytes taken by the OTA progress overlay
+} ui_mem_stats_t;
 
 /**
  * @brief Callback for LCD DMA transfer completion
@@ -19,6 +109,14 @@ bool notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_i
  */
 void ui_init(esp_lcd_panel_handle_t panel_handle);
 
+/**
+ * @brief Register the touch controller as an LVGL pointer input device
+ *
+ * Call after touch_init(). The device is only read after the controller's
+ * interrupt fires, and until the touch is released.
+ */
+void ui_register_touch(void);
+
 /**
  * @brief Update startup status message
  *
@@ -28,6 +126,9 @@ void ui_update_startup_status(const char *status);
 
 /**
  * @brief Transition from startup screen to main UI
+ *
+ * Each screen is built when shown and deleted when left. Tapping the main
+ * screen switches to the step history screen and back.
  */
 void ui_show_main_screen(void);
 
@@ -41,7 +142,7 @@ void ui_show_main_screen(void);
 void ui_update_battery(float voltage, int adc_raw, int pct_milli);
 
 /**
- * @brief Display a QR code with message on the startup screen
+ * @brief Replace the current screen with a QR code and message
  *
  * @param qr_data QR code data string (e.g., WiFi connection string)
  * @param message Message to display below QR code
@@ -59,6 +160,16 @@ void ui_show_qr_code(const char *qr_data, const char *message);
  */
 void ui_update_status(uint32_t step_count, uint8_t buffer_count, bool wifi_connected, bool ws_connected, int battery_pct);
 
+/**
+ * @brief Apply a full main-screen view model under a single LVGL lock
+ *
+ * Only labels whose values differ from the last rendered state are updated.
+ * The step history view, when shown, is refreshed if its buckets changed.
+ *
+ * @param vm View model to render
+ */
+void ui_update(const ui_view_model_t *vm);
+
 /**
  * @brief Update power management countdown timers
  *
@@ -70,6 +181,8 @@ void ui_update_power_timers(int wifi_countdown_s, int display_countdown_s);
 /**
  * @brief Show or hide OTA update status overlay
  *
+ * The overlay is built on the top layer when shown and deleted when hidden.
+ *
  * @param visible True to show OTA overlay, false to hide
  */
 void ui_show_ota_status(bool visible);
@@ -81,4 +194,112 @@ void ui_show_ota_status(bool visible);
  */
 void ui_update_ota_progress(int percent);
 
+/**
+ * @brief Start or stop the LVGL handler task
+ *
+ * While inactive the handler task blocks indefinitely and no rendering or
+ * flushing happens; widgets can still be updated. Resuming invalidates the
+ * screen so the latest state is drawn.
+ *
+ * @param active True to run LVGL, false to suspend it
+ */
+void ui_set_active(bool active);
+
+/**
+ * @brief Suspend LVGL and put the panel into sleep mode
+ *
+ * Waits for any transfer still in flight before the panel is sent to sleep.
+ */
+void ui_display_sleep(void);
+
+/**
+ * @brief Wake the panel and restore the last frame with a single full flush
+ *
+ * The panel stays dark until the frame has been redrawn, then the display
+ * and backlight are turned on. The latency is available from
+ * display_get_last_wake_latency_us().
+ */
+void ui_display_wake(void);
+
+/**
+ * @brief Get render statistics and start a new measurement window
+ *
+ * @param stats Output: rates and counts since the previous call
+ */
+void ui_get_render_stats(ui_render_stats_t *stats);
+
+/**
+ * @brief Get UI frame jitter and start a new measurement window
+ *
+ * Only timed wakeups count, so samples accumulate while something is
+ * animating (e.g. the startup spinner) or while the jitter probe is on.
+ * A static screen without the probe reports no samples.
+ *
+ * @param jitter Output: lateness of timed wakeups
+ */
+void ui_get_frame_jitter(ui_frame_jitter_t *jitter);
+
+/**
+ * @brief Make the LVGL handler wake at least every 10 ms to sample jitter
+ *
+ * For measurement windows only; costs ~100 wakeups/s while on. No samples
+ * are taken while rendering is suspended (display asleep).
+ *
+ * @param enable True to start probing, false to stop
+ */
+void ui_set_jitter_probe(bool enable);
+
+/**
+ * @brief Get refresh governor statistics and start a new measurement window
+ *
+ * @param stats Output: per-mode frame and SPI byte rates
+ */
+void ui_get_refresh_stats(ui_refresh_stats_t *stats);
+
+/**
+ * @brief Get LVGL heap usage, its high-water mark and per-screen footprints
+ *
+ * @param stats Output: heap and screen memory figures
+ */
+void ui_get_mem_stats(ui_mem_stats_t *stats);
+
+/**
+ * @brief Benchmark full-screen redraws of the active screen
+ *
+ * Invalidates the whole screen and forces a synchronous refresh the given
+ * number of times, then logs average/min/max frame time (render + flush).
+ *
+ * @param frames Number of full redraws to time
+ */
+void ui_benchmark_full_redraw(int frames);
+
+/**
+ * @brief Benchmark step counter updates: digit blitter vs LVGL label
+ *
+ * Times the given number of counter updates (set value, synchronous
+ * refresh and flush) through the digit atlas, then through a temporary
+ * label in the same position, and logs microseconds and flushed pixels per
+ * update for each.
+ *
+ * @param updates Number of updates to time per path
+ * @param result Output: per-update cost of each path, or NULL
+ * @return false if the main screen has no digit counter or LVGL was busy
+ */
+bool ui_benchmark_step_counter(int updates, ui_step_counter_bench_t *result);
+
+/**
+ * @brief Replay realistic update sequences on every screen and log the cost
+ *
+ * Runs steps ticking and timers counting down on the main screen, OTA
+ * progress on the overlay, the AP-mode QR code and the startup spinner,
+ * logging per-frame render time (until the last pixel is sent), flushed
+ * pixels and LVGL heap high-water for each. Deterministic screens also
+ * checksum a full redraw and compare it with the golden recorded in ui.c.
+ * Call after ui_show_main_screen().
+ *
+ * @return Number of screens whose checksum missed its golden or has no
+ *         golden recorded, -1 if LVGL was busy
+ */
+int ui_benchmark_screens(void);
+
 #endif // UI_H
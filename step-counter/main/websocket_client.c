@@ -1,5 +1,10 @@
 #include "websocket_client.h"
 #include "esp_websocket_client.h"
+#include "task_placement.h"
+#include "energy.h"
+#include "metrics.h"
+#include "binlog.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "cJSON.h"
 #include "amazon_root_ca.h"
@@ -18,6 +23,18 @@ static const char *TAG = "websocket_client";
 static esp_websocket_client_handle_t client = NULL;
 static ws_state_t current_state = WS_STATE_DISCONNECTED;
 static bool initialized = false;
+static bool handshake_active = false;
+static int64_t handshake_start_us = 0;
+static uint32_t connect_count = 0;
+
+// Close the ledger's TLS interval once the handshake has finished either way
+static void end_handshake(void)
+{
+    if (handshake_active) {
+        handshake_active = false;
+        energy_tls_end();
+    }
+}
 
 /**
  * @brief WebSocket event handler
@@ -28,14 +45,32 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
     esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
 
     switch (event_id) {
+        case WEBSOCKET_EVENT_BEFORE_CONNECT:
+            // Fires for the first connect and every automatic reconnect
+            if (!handshake_active) {
+                handshake_active = true;
+                handshake_start_us = esp_timer_get_time();
+                energy_tls_begin();
+            }
+            break;
+
         case WEBSOCKET_EVENT_CONNECTED:
             ESP_LOGI(TAG, "WebSocket connected");
             current_state = WS_STATE_CONNECTED;
+            if (handshake_active) {
+                metrics_histogram_record(METRIC_TLS_HANDSHAKE_MS,
+                                         (uint32_t)((esp_timer_get_time() - handshake_start_us) / 1000));
+            }
+            if (connect_count++ > 0) {
+                metrics_counter_add(METRIC_WS_RECONNECTS, 1);
+            }
+            end_handshake();
             break;
 
         case WEBSOCKET_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "WebSocket disconnected");
             current_state = WS_STATE_DISCONNECTED;
+            end_handshake();
             break;
 
         case WEBSOCKET_EVENT_DATA:
@@ -46,6 +81,7 @@ static void websocket_event_handler(void *handler_args, esp_event_base_t base,
         case WEBSOCKET_EVENT_ERROR:
             ESP_LOGE(TAG, "WebSocket error");
             current_state = WS_STATE_ERROR;
+            end_handshake();
             break;
 
         default:
@@ -69,6 +105,7 @@ esp_err_t websocket_client_init(void)
         .ping_interval_sec = WS_PING_INTERVAL_SEC,
         .cert_pem = amazon_root_ca,
         .skip_cert_common_name_check = false,
+        .task_prio = task_placement_priority(TASK_ROLE_NET),
     };
 
     client = esp_websocket_client_init(&ws_cfg);
@@ -131,6 +168,7 @@ esp_err_t websocket_client_stop(void)
     }
 
     current_state = WS_STATE_DISCONNECTED;
+    end_handshake();
     return ESP_OK;
 }
 
@@ -176,14 +214,146 @@ esp_err_t websocket_client_send_step(uint32_t step_count, time_t timestamp)
 
     int sent = esp_websocket_client_send_text(client, json_string, strlen(json_string),
                                                portMAX_DELAY);
-    free(json_string);
+    cJSON_free(json_string);
+
+    if (sent < 0) {
+        ESP_LOGE(TAG, "Failed to send WebSocket message");
+        return ESP_FAIL;
+    }
+
+    BINLOG(BL_WS_SENT, sent);
+    return ESP_OK;
+}
+
+esp_err_t websocket_client_send_energy(const energy_report_t *report)
+{
+    if (report == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!websocket_client_is_connected()) {
+        ESP_LOGW(TAG, "Cannot send energy report - not connected");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    static const char *const names[ENERGY_SUB_COUNT] = {"wifi", "tls", "display", "cpu", "base"};
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        ESP_LOGE(TAG, "Failed to create JSON object");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "type", "energy");
+    cJSON_AddNumberToObject(root, "uptime_s", report->uptime_s);
+    cJSON_AddNumberToObject(root, "avg_ua", report->avg_current_ua);
+    cJSON_AddNumberToObject(root, "slope_uv_per_h", report->slope_uv_per_h);
+    cJSON_AddNumberToObject(root, "runtime_min", report->runtime_min);
+    cJSON *ledger = cJSON_AddObjectToObject(root, "ledger");
+    for (int sub = 0; ledger != NULL && sub < ENERGY_SUB_COUNT; sub++) {
+        cJSON *entry = cJSON_AddObjectToObject(ledger, names[sub]);
+        if (entry != NULL) {
+            cJSON_AddNumberToObject(entry, "on_s", report->on_s[sub]);
+            cJSON_AddNumberToObject(entry, "uah", report->used_uah[sub]);
+        }
+    }
+
+    char *json_string = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (json_string == NULL) {
+        ESP_LOGE(TAG, "Failed to generate JSON string");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Sending energy report: %s", json_string);
+
+    int sent = esp_websocket_client_send_text(client, json_string, strlen(json_string),
+                                               portMAX_DELAY);
+    cJSON_free(json_string);
 
     if (sent < 0) {
         ESP_LOGE(TAG, "Failed to send WebSocket message");
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "Successfully sent %d bytes", sent);
+    return ESP_OK;
+}
+
+esp_err_t websocket_client_send_metrics(void)
+{
+    if (!websocket_client_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    static char frame[384];
+    metrics_snapshot_t snap;
+    metrics_snapshot(&snap);
+    size_t len = metrics_format_frame(&snap, (uint32_t)(esp_timer_get_time() / 1000000), frame, sizeof(frame));
+    if (len == 0) {
+        ESP_LOGE(TAG, "Metrics frame does not fit in %u bytes", (unsigned)sizeof(frame));
+        return ESP_ERR_NO_MEM;
+    }
+
+    int sent = esp_websocket_client_send_text(client, frame, len, pdMS_TO_TICKS(1000));
+    if (sent < 0) {
+        ESP_LOGE(TAG, "Failed to send metrics frame");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t websocket_client_send_profile(const profiler_report_t *report)
+{
+    if (report == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!websocket_client_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        ESP_LOGE(TAG, "Failed to create JSON object");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "type", "profile");
+    cJSON_AddNumberToObject(root, "window_ms", report->window_ms);
+    cJSON_AddNumberToObject(root, "tasks", report->task_count);
+    cJSON_AddNumberToObject(root, "cost_us", report->sample_cost_us);
+    cJSON_AddNumberToObject(root, "switch_ns", report->counter_read_ns);
+    cJSON_AddStringToObject(root, "tightest_stack", report->tightest_stack_task);
+    cJSON_AddNumberToObject(root, "tightest_free", report->tightest_stack_free);
+    cJSON *top = cJSON_AddArrayToObject(root, "top");
+    for (int i = 0; top != NULL && i < report->top_count; i++) {
+        cJSON *task = cJSON_CreateObject();
+        if (task != NULL) {
+            cJSON_AddStringToObject(task, "name", report->top[i].name);
+            cJSON_AddNumberToObject(task, "cpu_pm", report->top[i].cpu_permille);
+            cJSON_AddNumberToObject(task, "stack_free", report->top[i].stack_free_min);
+            cJSON_AddNumberToObject(task, "core", report->top[i].core);
+            cJSON_AddItemToArray(top, task);
+        }
+    }
+
+    char *json_string = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (json_string == NULL) {
+        ESP_LOGE(TAG, "Failed to generate JSON string");
+        return ESP_ERR_NO_MEM;
+    }
+
+    int sent = esp_websocket_client_send_text(client, json_string, strlen(json_string),
+                                               pdMS_TO_TICKS(1000));
+    cJSON_free(json_string);
+
+    if (sent < 0) {
+        ESP_LOGE(TAG, "Failed to send profile report");
+        return ESP_FAIL;
+    }
     return ESP_OK;
 }
 
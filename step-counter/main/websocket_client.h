@@ -5,6 +5,8 @@
 #include <time.h>
 #include "esp_err.h"
 #include "esp_websocket_client.h"
+#include "energy.h"
+#include "profiler.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,6 +68,29 @@ ws_state_t websocket_client_get_state(void);
  */
 esp_err_t websocket_client_send_step(uint32_t step_count, time_t timestamp);
 
+/**
+ * @brief Send the energy ledger and runtime estimate to the server
+ *
+ * @param report Snapshot from energy_get_report()
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t websocket_client_send_energy(const energy_report_t *report);
+
+/**
+ * @brief Send a snapshot of the metrics registry as a compact frame
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t websocket_client_send_metrics(void);
+
+/**
+ * @brief Send the profiler's busiest tasks and stack headroom to the server
+ *
+ * @param report Report from profiler_get_report()
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t websocket_client_send_profile(const profiler_report_t *report);
+
 /**
  * @brief Get WebSocket client handle
  *
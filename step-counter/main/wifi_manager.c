@@ -3,10 +3,14 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_netif.h"
+#include "dhcpserver/dhcpserver_options.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_http_server.h"
-#include "cJSON.h"
+#include "esp_timer.h"
+#include "dns_server.h"
+#include "json_stream.h"
+#include "freertos/semphr.h"
 #include <string.h>
 
 static const char *TAG = "wifi_manager";
@@ -16,6 +20,12 @@ static const char *TAG = "wifi_manager";
 #define AP_SSID "Stepper"
 #define AP_PASSWORD "" // Open network
 #define MAX_SCAN_RESULTS 20
+#define SCAN_STREAM_BUFFER 128
+#define PORTAL_URL "http://192.168.4.1/"
+
+// Portal page, gzip-compressed at build time (see CMakeLists.txt)
+extern const uint8_t portal_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t portal_html_gz_end[] asm("_binary_index_html_gz_end");
 
 static bool wifi_connected = false;
 static httpd_handle_t server = NULL;
@@ -29,9 +39,22 @@ typedef struct {
 static wifi_credential_t stored_credentials[MAX_WIFI_CREDENTIALS];
 static int stored_count = 0;
 
-// Cached scan results
+// Cached scan results, refreshed in the background by /rescan
 static wifi_ap_record_t scan_results[MAX_SCAN_RESULTS];
 static uint16_t scan_results_count = 0;
+static SemaphoreHandle_t scan_lock = NULL;
+static uint32_t scan_generation = 0;   // Bumped whenever scan_results is replaced
+static int64_t scan_time_us = 0;
+static volatile bool async_scan_running = false;
+
+// Portal caching and delivery counters
+static char portal_etag[12] = "";
+static uint32_t portal_bytes_served = 0;
+static uint32_t portal_full_responses = 0;
+static uint32_t portal_not_modified = 0;
+static bool portal_first_served = false;
+
+static void store_scan_results(void);
 
 // Event handler for WiFi events
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
@@ -55,6 +78,13 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             case WIFI_EVENT_AP_STACONNECTED:
                 ESP_LOGI(TAG, "Station connected to AP");
                 break;
+            case WIFI_EVENT_SCAN_DONE:
+                // Blocking scans collect their own results; only pick up ours
+                if (async_scan_running) {
+                    store_scan_results();
+                    async_scan_running = false;
+                }
+                break;
             default:
                 break;
         }
@@ -118,6 +148,28 @@ static bool try_connect_wifi(const char* ssid, const char* password)
     return wifi_connected;
 }
 
+// Copy the finished scan into the cache; readers see a new generation
+static void store_scan_results(void)
+{
+    uint16_t ap_count = 0;
+    esp_wifi_scan_get_ap_num(&ap_count);
+
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    // Limit to our array size
+    scan_results_count = (ap_count > MAX_SCAN_RESULTS) ? MAX_SCAN_RESULTS : ap_count;
+    if (esp_wifi_scan_get_ap_records(&scan_results_count, scan_results) != ESP_OK) {
+        scan_results_count = 0;
+    }
+    scan_generation++;
+    scan_time_us = esp_timer_get_time();
+    uint16_t count = scan_results_count;
+    xSemaphoreGive(scan_lock);
+
+    // Frees the driver's list when there were more APs than we keep
+    esp_wifi_clear_ap_list();
+    ESP_LOGI(TAG, "Found %d networks", count);
+}
+
 // Scan for available WiFi networks and cache results
 static void scan_wifi_networks(void)
 {
@@ -131,99 +183,159 @@ static void scan_wifi_networks(void)
     };
 
     ESP_ERROR_CHECK(esp_wifi_scan_start(&scan_config, true));
+    store_scan_results();
+}
 
-    uint16_t ap_count = 0;
-    esp_wifi_scan_get_ap_num(&ap_count);
-
-    // Limit to our array size
-    scan_results_count = (ap_count > MAX_SCAN_RESULTS) ? MAX_SCAN_RESULTS : ap_count;
-
-    if (scan_results_count > 0) {
-        ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&scan_results_count, scan_results));
+// ETag for the embedded portal page: FNV-1a over the compressed bytes
+static void compute_portal_etag(void)
+{
+    uint32_t hash = 2166136261u;
+    for (const uint8_t *p = portal_html_gz_start; p < portal_html_gz_end; p++) {
+        hash = (hash ^ *p) * 16777619u;
     }
-
-    ESP_LOGI(TAG, "Found %d networks", scan_results_count);
+    snprintf(portal_etag, sizeof(portal_etag), "\"%08lx\"", (unsigned long)hash);
 }
 
-// HTML for captive portal
-static const char* get_portal_html(void)
+static void log_time_to_portal(void)
 {
-    return "<!DOCTYPE html>"
-           "<html><head><meta name='viewport' content='width=device-width,initial-scale=1'>"
-           "<title>Stepper WiFi Setup</title>"
-           "<style>body{font-family:Arial;margin:20px;background:#f0f0f0}"
-           ".container{max-width:400px;margin:auto;background:white;padding:20px;border-radius:8px;box-shadow:0 2px 4px rgba(0,0,0,0.1)}"
-           "h1{color:#333;text-align:center}"
-           "select,input{width:100%;padding:10px;margin:10px 0;box-sizing:border-box;border:1px solid #ddd;border-radius:4px}"
-           "button{width:100%;padding:12px;background:#4CAF50;color:white;border:none;border-radius:4px;cursor:pointer;font-size:16px}"
-           "button:hover{background:#45a049}"
-           "</style></head><body>"
-           "<div class='container'>"
-           "<h1>Stepper Setup</h1>"
-           "<p>Select your WiFi network:</p>"
-           "<form action='/save' method='post'>"
-           "<select name='ssid' id='ssid' required><option value=''>Scanning...</option></select>"
-           "<input type='password' name='password' placeholder='Password' required>"
-           "<button type='submit'>Connect</button>"
-           "</form></div>"
-           "<script>"
-           "fetch('/scan').then(r=>r.json()).then(data=>{"
-           "let select=document.getElementById('ssid');select.innerHTML='';"
-           "data.networks.forEach(n=>{let opt=document.createElement('option');opt.value=n.ssid;opt.textContent=`${n.ssid} (${n.rssi}dBm)`;select.appendChild(opt);});"
-           "});"
-           "</script></body></html>";
+    if (portal_first_served) {
+        return;
+    }
+    portal_first_served = true;
+
+    dns_server_stats_t dns_stats;
+    dns_server_get_stats(&dns_stats);
+    if (dns_stats.first_query_us > 0) {
+        ESP_LOGI(TAG, "Portal first served %lld ms after the first DNS query",
+                 (esp_timer_get_time() - dns_stats.first_query_us) / 1000);
+    }
 }
 
 // HTTP GET handler for root
 static esp_err_t root_get_handler(httpd_req_t *req)
 {
-    const char* html = get_portal_html();
+    log_time_to_portal();
+
+    // Revalidations (the page is reloaded on every portal probe) only cost a header
+    char if_none_match[sizeof(portal_etag)];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        strcmp(if_none_match, portal_etag) == 0) {
+        portal_not_modified++;
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_set_hdr(req, "ETag", portal_etag);
+        httpd_resp_send(req, NULL, 0);
+        ESP_LOGI(TAG, "Portal: 304 (%lu full, %lu not modified, %lu bytes served)",
+                 (unsigned long)portal_full_responses, (unsigned long)portal_not_modified,
+                 (unsigned long)portal_bytes_served);
+        return ESP_OK;
+    }
+
+    size_t len = portal_html_gz_end - portal_html_gz_start;
     httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html, strlen(html));
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "ETag", portal_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    httpd_resp_send(req, (const char *)portal_html_gz_start, len);
+
+    portal_full_responses++;
+    portal_bytes_served += len;
+    ESP_LOGI(TAG, "Portal: %u bytes (%lu full, %lu not modified, %lu bytes served)",
+             (unsigned)len, (unsigned long)portal_full_responses, (unsigned long)portal_not_modified,
+             (unsigned long)portal_bytes_served);
     return ESP_OK;
 }
 
-// HTTP GET handler for scan
+// Everything else (OS connectivity probes, typed URLs) is redirected to the portal
+static esp_err_t redirect_get_handler(httpd_req_t *req)
+{
+    httpd_resp_set_status(req, "302 Found");
+    httpd_resp_set_hdr(req, "Location", PORTAL_URL);
+    httpd_resp_send(req, NULL, 0);
+    return ESP_OK;
+}
+
+static bool send_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK;
+}
+
+// HTTP GET handler for scan: streams the cached results as chunked JSON
 static esp_err_t scan_get_handler(httpd_req_t *req)
 {
-    ESP_LOGI(TAG, "Scan handler: returning %d cached networks", scan_results_count);
+    char buf[SCAN_STREAM_BUFFER];
+    json_stream_t out;
+    json_stream_init(&out, buf, sizeof(buf), send_chunk, req);
+    httpd_resp_set_type(req, "application/json");
 
-    // Build JSON response using cJSON from cached scan results
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
-        return ESP_FAIL;
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    uint32_t generation = scan_generation;
+    uint16_t count = scan_results_count;
+    int32_t age_s = (int32_t)((esp_timer_get_time() - scan_time_us) / 1000000);
+    xSemaphoreGive(scan_lock);
+
+    json_stream_raw(&out, "{\"scanning\":");
+    json_stream_raw(&out, async_scan_running ? "true" : "false");
+    json_stream_raw(&out, ",\"age_s\":");
+    json_stream_int(&out, age_s);
+    json_stream_raw(&out, ",\"networks\":[");
+    for (int i = 0; i < count && !out.failed; i++) {
+        // Copy one entry at a time so a slow client never holds up a finishing scan
+        char ssid[sizeof(scan_results[0].ssid)];
+        int8_t rssi;
+        xSemaphoreTake(scan_lock, portMAX_DELAY);
+        bool stale = scan_generation != generation;
+        memcpy(ssid, scan_results[i].ssid, sizeof(ssid));
+        rssi = scan_results[i].rssi;
+        xSemaphoreGive(scan_lock);
+        if (stale) {
+            break;  // A rescan replaced the list; the client polls again anyway
+        }
+
+        if (i > 0) {
+            json_stream_raw(&out, ",");
+        }
+        json_stream_raw(&out, "{\"ssid\":");
+        json_stream_string(&out, ssid, sizeof(ssid));
+        json_stream_raw(&out, ",\"rssi\":");
+        json_stream_int(&out, rssi);
+        json_stream_raw(&out, "}");
     }
+    json_stream_raw(&out, "]}");
 
-    cJSON *networks = cJSON_AddArrayToObject(root, "networks");
-    if (networks == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+    if (!json_stream_finish(&out)) {
+        ESP_LOGW(TAG, "Scan response aborted after %u bytes", (unsigned)out.total);
         return ESP_FAIL;
     }
+    httpd_resp_send_chunk(req, NULL, 0);
+    ESP_LOGI(TAG, "Scan handler: streamed %d networks, %u bytes in %lu chunks",
+             count, (unsigned)out.total, (unsigned long)out.flushes);
+    return ESP_OK;
+}
 
-    // Add cached scan results to JSON
-    for (int i = 0; i < scan_results_count; i++) {
-        cJSON *net = cJSON_CreateObject();
-        if (net != NULL) {
-            cJSON_AddStringToObject(net, "ssid", (char*)scan_results[i].ssid);
-            cJSON_AddNumberToObject(net, "rssi", scan_results[i].rssi);
-            cJSON_AddItemToArray(networks, net);
+// HTTP POST handler for rescan: starts a scan and returns at once
+static esp_err_t rescan_post_handler(httpd_req_t *req)
+{
+    esp_err_t err = ESP_OK;
+    if (!async_scan_running) {
+        wifi_scan_config_t scan_config = {
+            .show_hidden = false
+        };
+        async_scan_running = true;
+        err = esp_wifi_scan_start(&scan_config, false);
+        if (err != ESP_OK) {
+            async_scan_running = false;
         }
     }
 
-    char *json_str = cJSON_Print(root);
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Rescan failed to start: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Scan failed to start");
         return ESP_FAIL;
     }
 
+    httpd_resp_set_status(req, "202 Accepted");
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_str, strlen(json_str));
-
-    cJSON_Delete(root);
-    free(json_str);
+    httpd_resp_sendstr(req, "{\"scanning\":true}");
     return ESP_OK;
 }
 
@@ -336,7 +448,24 @@ void wifi_manager_start_ap_mode(void)
     ESP_ERROR_CHECK(esp_wifi_stop());
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
 
-    esp_netif_create_default_wifi_ap();
+    esp_netif_t *ap_netif = esp_netif_create_default_wifi_ap();
+
+    // Hand out our own address as the DNS server so every lookup reaches dns_server
+    esp_netif_ip_info_t ap_ip;
+    ESP_ERROR_CHECK(esp_netif_get_ip_info(ap_netif, &ap_ip));
+    esp_netif_dns_info_t dns_info = {
+        .ip.u_addr.ip4.addr = ap_ip.ip.addr,
+        .ip.type = ESP_IPADDR_TYPE_V4,
+    };
+    dhcps_offer_t offer_dns = OFFER_DNS;
+    ESP_ERROR_CHECK(esp_netif_dhcps_stop(ap_netif));
+    ESP_ERROR_CHECK(esp_netif_set_dns_info(ap_netif, ESP_NETIF_DNS_MAIN, &dns_info));
+    ESP_ERROR_CHECK(esp_netif_dhcps_option(ap_netif, ESP_NETIF_OP_SET, ESP_NETIF_DOMAIN_NAME_SERVER,
+                                           &offer_dns, sizeof(offer_dns)));
+    // DHCP option 114 lets newer clients open the portal without probing
+    esp_netif_dhcps_option(ap_netif, ESP_NETIF_OP_SET, ESP_NETIF_CAPTIVEPORTAL_URI,
+                           (void *)PORTAL_URL, strlen(PORTAL_URL));
+    ESP_ERROR_CHECK(esp_netif_dhcps_start(ap_netif));
 
     wifi_config_t ap_config = {
         .ap = {
@@ -351,14 +480,24 @@ void wifi_manager_start_ap_mode(void)
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &ap_config));
     ESP_ERROR_CHECK(esp_wifi_start());
 
+    if (scan_lock == NULL) {
+        scan_lock = xSemaphoreCreateMutex();
+    }
+
     // Scan for networks after WiFi is started in APSTA mode
     // This ensures scan results are available when the web server starts
     ESP_LOGI(TAG, "Scanning for available WiFi networks...");
     scan_wifi_networks();
 
+    if (dns_server_start(ap_ip.ip.addr) != ESP_OK) {
+        ESP_LOGW(TAG, "DNS responder failed to start; portal only reachable at %s", PORTAL_URL);
+    }
+
     // Start HTTP server
+    compute_portal_etag();
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
+    config.uri_match_fn = httpd_uri_match_wildcard;  // Needed for the "/*" catch-all
 
     if (httpd_start(&server, &config) == ESP_OK) {
         httpd_uri_t root_uri = {
@@ -375,6 +514,13 @@ void wifi_manager_start_ap_mode(void)
         };
         httpd_register_uri_handler(server, &scan_uri);
 
+        httpd_uri_t rescan_uri = {
+            .uri = "/rescan",
+            .method = HTTP_POST,
+            .handler = rescan_post_handler
+        };
+        httpd_register_uri_handler(server, &rescan_uri);
+
         httpd_uri_t save_uri = {
             .uri = "/save",
             .method = HTTP_POST,
@@ -386,7 +532,7 @@ void wifi_manager_start_ap_mode(void)
         httpd_uri_t catchall_uri = {
             .uri = "/*",
             .method = HTTP_GET,
-            .handler = root_get_handler
+            .handler = redirect_get_handler
         };
         httpd_register_uri_handler(server, &catchall_uri);
 